@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Contiguous array that either owns its elements or views memory owned by
+// someone else (e.g. a read-only file mapping kept alive through `owner`).
+// Reads work in both modes. Writing through a view is not allowed; resize()
+// and assign() first turn a view into an owned copy.
+template <typename T>
+class ArrayBuffer {
+public:
+    ArrayBuffer() = default;
+    ArrayBuffer(const T* data, size_t size, std::shared_ptr<const void> owner)
+        : view(data), count(size), owner(std::move(owner)) {}
+
+    ArrayBuffer(const ArrayBuffer& other) : storage(other.storage), view(other.view), count(other.count), owner(other.owner) {
+        if (!owner) view = storage.data();
+    }
+    ArrayBuffer(ArrayBuffer&& other) noexcept
+        : storage(std::move(other.storage)), view(other.view), count(other.count), owner(std::move(other.owner)) {
+        other.view = nullptr;
+        other.count = 0;
+    }
+    ArrayBuffer& operator=(ArrayBuffer other) noexcept {
+        storage.swap(other.storage);
+        std::swap(view, other.view);
+        std::swap(count, other.count);
+        owner.swap(other.owner);
+        return *this;
+    }
+
+    void resize(size_t size) { own(); storage.resize(size); sync(); }
+    void assign(size_t size, const T& value) { own(); storage.assign(size, value); sync(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool isView() const { return static_cast<bool>(owner); }
+
+    const T* data() const { return view; }
+    const T* begin() const { return view; }
+    const T* end() const { return view + count; }
+    const T& operator[](size_t i) const { return view[i]; }
+
+    T* data() { return const_cast<T*>(view); }
+    T* begin() { return const_cast<T*>(view); }
+    T* end() { return const_cast<T*>(view) + count; }
+    T& operator[](size_t i) { return const_cast<T&>(view[i]); }
+
+private:
+    void own() {
+        if (owner) {
+            storage.assign(view, view + count);
+            owner.reset();
+        }
+    }
+    void sync() {
+        view = storage.data();
+        count = storage.size();
+    }
+
+    std::vector<T> storage;
+    const T* view = nullptr;
+    size_t count = 0;
+    std::shared_ptr<const void> owner;
+};
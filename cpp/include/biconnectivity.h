@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// Single points of failure of an undirected graph
+template <typename G>
+struct Biconnectivity {
+    using Index = typename G::Index;
+
+    std::vector<uint8_t> bridge;           // Per edge id: removing it disconnects its endpoints
+    std::vector<uint8_t> articulation;     // Per vertex: removing it disconnects the graph
+    // Biconnected component of each edge, numbered by smallest edge id;
+    // NO_VERTEX for self loops, which belong to no component
+    std::vector<Index> component;
+    Index numComponents = 0;
+};
+
+// Hopcroft-Tarjan with an explicit stack, so path-like graphs of any depth
+// are safe
+template <typename G>
+Biconnectivity<G> biconnectivity(const G& graph);
+
+// Tarjan-Vishkin: BFS spanning forest, preorder numbers and subtree low/high
+// values computed level by level, then the components as connected
+// components of the auxiliary graph on tree edges, all in parallel
+// (0 threads = hardware concurrency). Same result as biconnectivity().
+template <typename G>
+Biconnectivity<G> biconnectivityParallel(const G& graph, unsigned threads = 0);
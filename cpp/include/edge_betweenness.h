@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// Edge betweenness: for each edge id, the number of unordered vertex pairs
+// whose shortest paths cross it, split evenly among equally short paths
+template <typename G>
+struct EdgeBetweenness {
+    using Index = typename G::Index;
+
+    std::vector<double> centrality;
+    Index sources = 0;        // Sources whose shortest path DAGs were accumulated
+    // Sampled runs: every edge is within errorBound of its exact value with
+    // probability at least 1 - delta (Hoeffding plus a union bound over
+    // edges). 0 when all vertices were used as sources.
+    double errorBound = 0.0;
+};
+
+// Brandes' algorithm with sources spread across threads (0 = hardware
+// concurrency). Weighted runs Dijkstra and needs positive weights;
+// unweighted counts hops with BFS.
+template <typename G>
+EdgeBetweenness<G> edgeBetweenness(const G& graph, bool weighted = true, unsigned threads = 0);
+
+// Same from `samples` distinct random pivot sources, scaled by n / samples
+template <typename G>
+EdgeBetweenness<G> edgeBetweennessSampled(const G& graph, typename G::Index samples, double delta = 0.1,
+                                          uint64_t seed = 1, bool weighted = true, unsigned threads = 0);
+
+// Pivots needed so that every edge is within epsilon * n(n-1)/2 of its exact
+// value with probability at least 1 - delta
+uint64_t betweennessSamples(uint64_t edges, double epsilon, double delta);
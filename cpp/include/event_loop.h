@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Discrete-event loop in virtual milliseconds. Callbacks run in time order,
+// ties in the order they were scheduled, and may schedule more events. One
+// loop is driven by one thread; nothing here is synchronized.
+class EventLoop {
+public:
+    using Callback = std::function<void()>;
+
+    double now() const { return nowMs; }
+    size_t pending() const { return heap.size(); }
+    uint64_t processed() const { return count; }
+
+    // Run `fn` at `timeMs`, or now if that is in the past
+    void at(double timeMs, Callback fn) {
+        heap.push_back({std::max(timeMs, nowMs), order++, std::move(fn)});
+        std::push_heap(heap.begin(), heap.end(), Later());
+    }
+    void after(double delayMs, Callback fn) { at(nowMs + delayMs, std::move(fn)); }
+
+    // Run the next event; false if there is none
+    bool runOne() {
+        if (heap.empty()) return false;
+        std::pop_heap(heap.begin(), heap.end(), Later());
+        Entry entry = std::move(heap.back());
+        heap.pop_back();
+        nowMs = entry.time;
+        count++;
+        entry.fn();
+        return true;
+    }
+
+    // Run events due up to `untilMs` (all of them by default) or until
+    // stop() is called from a callback; returns how many ran
+    uint64_t run(double untilMs = std::numeric_limits<double>::infinity()) {
+        uint64_t start = count;
+        stopping = false;
+        while (!stopping && !heap.empty() && heap.front().time <= untilMs) runOne();
+        return count - start;
+    }
+    void stop() { stopping = true; }
+
+private:
+    struct Entry {
+        double time;
+        uint64_t order;
+        Callback fn;
+    };
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.time != b.time ? a.time > b.time : a.order > b.order;
+        }
+    };
+
+    std::vector<Entry> heap;
+    double nowMs = 0.0;
+    uint64_t order = 0;
+    uint64_t count = 0;
+    bool stopping = false;
+};
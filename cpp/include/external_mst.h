@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "graph.h"
+
+// Edge files are headerless arrays of packed (u, v, weight) records in the
+// graph's Index and Weight types, native little-endian, so a record takes
+// 2 * sizeof(Index) + sizeof(Weight) bytes and numpy can read them directly.
+template <typename G>
+constexpr size_t edgeRecordBytes() {
+    return 2 * sizeof(typename G::Index) + sizeof(typename G::Weight);
+}
+
+// Write the graph's edges in edge id order (pending edges included)
+template <typename G>
+void writeEdgeFile(const G& graph, const std::string& path);
+
+template <typename G>
+struct ExternalMstStats {
+    uint64_t inputEdges = 0;
+    uint64_t runs = 0;                     // Sorted runs written to disk (0 if the input fit in memory)
+    uint64_t runEdges = 0;                 // Edges that survived the per-run filter
+    uint64_t treeEdges = 0;
+    WeightSum<typename G::Weight> weight = 0;
+    uint64_t components = 0;               // Trees of the spanning forest, isolated vertices included
+};
+
+// Semi-external minimum spanning forest: only the union-find over the
+// vertices and one memory-sized block of edges are held in RAM. The edge
+// file is read in blocks of about memoryBytes; each block is sorted by
+// weight (in parallel) and reduced to its own spanning forest, since an edge
+// that closes a cycle of lighter edges within a block is in no minimum
+// spanning forest. The surviving runs go to temporary files in tempDir
+// (default: next to treeFile), and one k-way merge feeds Kruskal's scan,
+// which stops as soon as the forest is complete. Tree edges are written to
+// treeFile in the edge file format, lightest first; ties between equal
+// weights are broken by (u, v).
+template <typename G>
+ExternalMstStats<G> externalMST(const std::string& edgeFile, typename G::Index vertices, const std::string& treeFile,
+                                uint64_t memoryBytes = uint64_t(1) << 30, const std::string& tempDir = "",
+                                unsigned threads = 0);
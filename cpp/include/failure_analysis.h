@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// What-if results, one row per failed edge (indexed by edge id) or vertex
+template <typename G>
+struct FailureTable {
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+
+    std::vector<Distance> mstDelta;        // Change of the minimum spanning forest weight
+    std::vector<uint64_t> mstSplits;       // Forest pieces the failure leaves unconnected
+    std::vector<Index> replacement;        // Edge failures: edge taking over in the MST, else NO_VERTEX
+    // Shortest-path impact over ordered vertex pairs (s, t), pairs involving a
+    // failed vertex excluded; empty when stretch was not requested
+    std::vector<uint64_t> affectedPairs;   // Pairs whose distance grows
+    std::vector<uint64_t> disconnectedPairs;
+    std::vector<double> meanStretch;       // new / old distance over pairs still connected
+    std::vector<double> maxStretch;
+};
+
+// Single-link and single-node failure analysis. The baseline minimum spanning
+// forest is computed once; a failed tree edge is replaced by the lightest
+// non-tree edge covering it, found for all tree edges in one pass over the
+// non-tree edges in weight order. Path stretch reuses each source's shortest
+// path tree: a failure changes only the subtree below it, which is re-solved
+// locally. Sources are spread across threads. Weights must be non-negative.
+template <typename G>
+class FailureAnalysis {
+public:
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+
+    explicit FailureAnalysis(const G& graph, unsigned threads = 0);
+
+    Distance mstWeight() const { return baseWeight; }
+    const std::vector<bool>& mstEdges() const { return inTree; }
+
+    // Stretch needs a shortest path tree per source (O(n m log n) overall);
+    // without it only the MST columns are filled
+    FailureTable<G> linkFailures(bool stretch = true) const;
+    FailureTable<G> nodeFailures(bool stretch = true) const;
+
+private:
+    static constexpr Index NONE = G::NO_VERTEX;
+
+    const G& graph;
+    unsigned threads;
+    std::vector<typename G::Edge> edges;
+    Distance baseWeight = 0;
+    std::vector<bool> inTree;
+    // Forest rooted at the smallest vertex of each tree
+    std::vector<Index> parent;
+    std::vector<Index> parentEdge;
+    std::vector<Index> depth;
+    std::vector<Index> enter, leave;       // Preorder interval of each subtree
+    std::vector<Index> nonTree;            // Non-tree edge ids by ascending weight
+
+    void stretchImpact(FailureTable<G>& table, bool nodes) const;
+};
@@ -1,14 +1,126 @@
 #pragma once
 #include <vector>
 #include <utility>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include "array_buffer.h"
 
-class Graph {
+// Undirected weighted edge, as passed to BasicGraph::addEdge
+template <typename Index, typename Weight>
+struct BasicEdge {
+    Index u;
+    Index v;
+    Weight weight;
+};
+
+// Sums of edge weights (flows, path lengths): 64-bit integers for integer
+// weights, double otherwise
+template <typename Weight>
+using WeightSum = typename std::conditional<std::is_floating_point<Weight>::value, double, int64_t>::type;
+
+// Compressed sparse row adjacency. Every undirected edge is stored as two
+// arcs, one per endpoint; the arcs of vertex u are [offsets[u], offsets[u + 1])
+// and appear in edge insertion order. The arrays may view a read-only
+// snapshot mapping (see graph_snapshot.h) instead of owning their memory.
+template <typename Index, typename Weight>
+struct BasicCSR {
+    ArrayBuffer<uint64_t> offsets;   // size vertices + 1
+    ArrayBuffer<Index> targets;      // neighbor at the other end of each arc
+    ArrayBuffer<Weight> weights;     // weight of each arc
+    ArrayBuffer<Index> edgeIds;      // insertion index of the edge each arc belongs to
+};
+
+// Minimum spanning tree of one component as flat arrays. Full results list
+// the tree edges (parents[i], children[i]) with weights[i], children in id
+// order; parent-only results fill parentOf instead (the parent of every
+// vertex, NO_VERTEX for the root and vertices outside its component).
+template <typename Index, typename Weight>
+struct BasicSpanningTree {
+    Index root = 0;
+    std::vector<Index> parents;
+    std::vector<Index> children;
+    std::vector<Weight> weights;
+    std::vector<Index> parentOf;
+    Index treeEdges = 0;
+    WeightSum<Weight> totalWeight = 0;
+};
+
+// Weighted undirected graph. Index is the vertex/edge id type (uint32_t or
+// uint64_t), Weight the edge weight type; see NETSIM_FOR_EACH_GRAPH_TYPE for
+// the combinations compiled into the library.
+template <typename IndexT, typename WeightT>
+class BasicGraph {
 public:
-    Graph(int vertices);
-    void addEdge(int u, int v, int weight);
-    std::vector<std::pair<int, int>> primMST();
+    using Index = IndexT;
+    using Weight = WeightT;
+    using Edge = BasicEdge<Index, Weight>;
+    using CSR = BasicCSR<Index, Weight>;
+    using SpanningTree = BasicSpanningTree<Index, Weight>;
+
+    // Marks "no vertex", e.g. the MST parent of the root
+    static constexpr Index NO_VERTEX = std::numeric_limits<Index>::max();
+
+    BasicGraph(Index vertices);
+    BasicGraph(Index vertices, std::vector<Edge> edges);
+    // Adopt a ready-made adjacency (offsets must have vertices + 1 entries)
+    BasicGraph(Index vertices, CSR arrays);
+    void addEdge(Index u, Index v, Weight weight);
+    void addEdges(const std::vector<Edge>& edges);
+    // MST (or the spanning tree of root's component) as (parent, child) pairs,
+    // one per vertex other than root in id order; unreached children get NO_VERTEX
+    std::vector<std::pair<Index, Index>> primMST(Index root = 0);
+    // Same tree without building pairs; see BasicSpanningTree
+    SpanningTree primTree(Index root = 0, bool parentsOnly = false) const;
+
+    Index numVertices() const { return vertices; }
+    uint64_t numEdges() const;
+    // True while the adjacency is used in place from a snapshot mapping
+    bool isMapped() const { return adjacency.targets.isView(); }
+
+    // All edges indexed by edge id, endpoints ordered u <= v
+    std::vector<Edge> edgeList() const;
+
+    // Adjacency in CSR form. Edges added since the last call are merged in
+    // here under a lock, so concurrent readers are safe; adding edges while
+    // another thread still uses the returned arrays is not.
+    const CSR& csr() const;
 
 private:
-    int vertices;
-    std::vector<std::vector<std::pair<int, int>>> adjList;
+    // Copies and moves of the graph get a lock of their own
+    struct MergeLock {
+        std::mutex mutex;
+        MergeLock() = default;
+        MergeLock(const MergeLock&) {}
+        MergeLock& operator=(const MergeLock&) { return *this; }
+    };
+
+    Index vertices;
+    mutable CSR adjacency;
+    mutable std::vector<Edge> pending;   // added but not yet merged into adjacency
+    mutable MergeLock merging;           // guards pending and the merge
 };
+
+// Index/weight combinations instantiated in the library and exposed to Python.
+// X(Index, Weight, python suffix)
+#define NETSIM_FOR_EACH_GRAPH_TYPE(X) \
+    X(uint32_t, int32_t, "u32_i32")   \
+    X(uint32_t, uint16_t, "u32_u16")  \
+    X(uint32_t, uint32_t, "u32_u32")  \
+    X(uint32_t, float, "u32_f32")     \
+    X(uint32_t, double, "u32_f64")    \
+    X(uint64_t, int32_t, "u64_i32")   \
+    X(uint64_t, uint16_t, "u64_u16")  \
+    X(uint64_t, uint32_t, "u64_u32")  \
+    X(uint64_t, float, "u64_f32")     \
+    X(uint64_t, double, "u64_f64")
+
+#define NETSIM_DECLARE_GRAPH(I, W, NAME) extern template class BasicGraph<I, W>;
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_DECLARE_GRAPH)
+#undef NETSIM_DECLARE_GRAPH
+
+// The original int-weighted graph
+using Graph = BasicGraph<uint32_t, int32_t>;
+using Edge = Graph::Edge;
+using CSR = Graph::CSR;
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// Options shared by the topology generators
+struct GeneratorConfig {
+    uint64_t seed = 1;                     // Same seed gives the same graph for any thread count
+    double minWeight = 1;                  // Smallest edge weight drawn
+    double maxWeight = 1;                  // Largest edge weight drawn (inclusive for integer weights)
+    unsigned threads = 0;                  // Worker threads (0 = hardware concurrency)
+};
+
+// G(n, p): each of the n(n-1)/2 vertex pairs is an edge with probability p.
+// Uses geometric skipping, so the cost is proportional to the edges produced.
+template <typename G = Graph>
+G erdosRenyi(typename G::Index n, double p, const GeneratorConfig& config = GeneratorConfig());
+
+// Preferential attachment: each vertex after the first attaches m edges to
+// earlier vertices chosen proportionally to their degree (Batagelj-Brandes
+// model, parallel edges possible). Every edge is resolved independently.
+template <typename G = Graph>
+G barabasiAlbert(typename G::Index n, typename G::Index m, const GeneratorConfig& config = GeneratorConfig());
+
+// Waxman random geometric graph on the unit square: u and v are joined with
+// probability alpha * exp(-d / (beta * L)). Weights grow linearly with the
+// distance from minWeight to maxWeight.
+template <typename G = Graph>
+G waxman(typename G::Index n, double alpha, double beta, const GeneratorConfig& config = GeneratorConfig());
+
+// k-ary fat-tree: (k/2)^2 core, k pods of k/2 aggregation and k/2 edge
+// switches, and k^3/4 hosts when includeHosts is set. Switches come first.
+template <typename G = Graph>
+G fatTree(typename G::Index k, bool includeHosts = true, typename G::Weight weight = 1);
+
+// 2D or 3D torus with wrap-around links; vertex id is x + X * (y + Y * z)
+template <typename G = Graph>
+G torus(const std::vector<typename G::Index>& dims, typename G::Weight weight = 1);
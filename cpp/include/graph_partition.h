@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// k-way vertex partition with its cut statistics
+template <typename G>
+struct GraphPartition {
+    using Index = typename G::Index;
+
+    std::vector<Index> part;               // Part of each vertex
+    std::vector<uint64_t> partSizes;       // Vertices per part
+    std::vector<uint64_t> partCut;         // Cut edges with an endpoint in each part
+    uint64_t cutEdges = 0;
+    WeightSum<typename G::Weight> cutWeight = 0;
+    double imbalance = 0.0;                // Largest part / ceil(n / parts) - 1
+};
+
+// Multilevel partitioning into `parts` parts of at most
+// (1 + epsilon) * ceil(n / parts) vertices, minimizing the number of cut
+// edges (edge weights are reported but not optimized: they are latencies,
+// not traffic). The graph is coarsened by parallel heavy-edge matching, the
+// coarsest graph split by greedy graph growing from several seeds at once,
+// and each level on the way back refined by parallel size-constrained label
+// propagation followed by a boundary FM pass with rollback. Moves are
+// committed in a fixed order, so the result depends on the seed only, not on
+// the thread count.
+template <typename G>
+GraphPartition<G> partitionGraph(const G& graph, typename G::Index parts, double epsilon = 0.03, uint64_t seed = 1,
+                                 unsigned threads = 0);
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "graph.h"
+#include "max_flow.h"
+
+// Vertex numberings that place neighbors close together in memory
+enum class VertexOrder {
+    IDENTITY,   // Keep the input numbering
+    DEGREE,     // Highest degree first, so hubs share cache lines
+    BFS,        // Breadth-first discovery order, one component after another
+    RCM         // Reverse Cuthill-McKee from pseudo-peripheral vertices (small bandwidth)
+};
+
+// Permutation for the given order as newId[original vertex]
+template <typename G>
+std::vector<typename G::Index> vertexOrdering(const G& graph, VertexOrder order);
+
+// Copy of the graph with vertex v renumbered to newId[v]. Edge ids and the
+// per-vertex arc order are kept, so edge-indexed results need no mapping.
+template <typename G>
+G permuteGraph(const G& graph, const std::vector<typename G::Index>& newId, unsigned threads = 0);
+
+// Largest |u - v| over all edges; smaller means better locality
+template <typename G>
+uint64_t graphBandwidth(const G& graph);
+
+// A graph renumbered for locality. Algorithms run on the permuted copy and
+// their results are translated back to the original vertex ids.
+template <typename G>
+class ReorderedGraph {
+public:
+    using Index = typename G::Index;
+
+    ReorderedGraph(const G& graph, VertexOrder order, unsigned threads = 0);
+
+    const G& graph() const { return permuted; }
+    const std::vector<Index>& newIds() const { return newId; }          // Indexed by original id
+    const std::vector<Index>& originalIds() const { return originalId; } // Indexed by new id
+    Index toOriginal(Index v) const { return v == G::NO_VERTEX ? v : originalId.at(v); }
+    Index toReordered(Index v) const { return v == G::NO_VERTEX ? v : newId.at(v); }
+
+    // Same contract as G::primMST, in original ids
+    std::vector<std::pair<Index, Index>> primMST(Index root = 0);
+    MaxFlowResult<G> maxFlow(Index s, Index t) const;
+
+private:
+    std::vector<Index> newId;
+    std::vector<Index> originalId;
+    G permuted;
+};
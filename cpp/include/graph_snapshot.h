@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "graph.h"
+
+// Binary CSR snapshot, version 1. A 128-byte header is followed by the
+// offsets, targets, weights and edgeIds arrays, each starting on a 64-byte
+// boundary, in native little-endian layout. Loading maps the file read-only
+// and the graph uses the arrays in place, so processes that load the same
+// snapshot share one copy through the page cache.
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint64_t SNAPSHOT_ALIGNMENT = 64;
+
+enum class WeightKind : uint8_t {
+    SIGNED = 0,
+    UNSIGNED = 1,
+    FLOAT = 2
+};
+
+struct SnapshotHeader {
+    char magic[8];                         // "NSIMCSR" followed by a NUL
+    uint32_t version;
+    uint32_t byteOrder;                    // 0x01020304 as written by the producer
+    uint8_t indexBytes;
+    uint8_t weightBytes;
+    WeightKind weightKind;
+    uint8_t reserved0[5];
+    uint64_t vertices;
+    uint64_t arcs;                         // Twice the number of edges
+    uint64_t offsetsPos;                   // Byte position of each array in the file
+    uint64_t targetsPos;
+    uint64_t weightsPos;
+    uint64_t edgeIdsPos;
+    uint64_t fileSize;
+    uint8_t reserved1[48];
+};
+static_assert(sizeof(SnapshotHeader) == 128, "snapshot header must stay 128 bytes");
+
+template <typename W>
+constexpr WeightKind weightKindOf() {
+    return std::is_floating_point<W>::value ? WeightKind::FLOAT
+         : std::is_signed<W>::value ? WeightKind::SIGNED : WeightKind::UNSIGNED;
+}
+
+// True when a snapshot with this header can be loaded as graph type G
+template <typename G>
+bool snapshotMatches(const SnapshotHeader& header) {
+    return header.indexBytes == sizeof(typename G::Index) && header.weightBytes == sizeof(typename G::Weight) &&
+           header.weightKind == weightKindOf<typename G::Weight>();
+}
+
+// Read and validate the header only, e.g. to pick the matching graph type
+SnapshotHeader readSnapshotHeader(const std::string& path);
+
+// Write the graph (pending edges are merged first)
+template <typename G>
+void saveSnapshot(const G& graph, const std::string& path);
+
+// Map a snapshot written for the same index/weight types. With prefault the
+// whole file is paged in up front instead of on first touch. With verify the
+// arrays are checked in one pass before use; without it the file is trusted,
+// and a corrupt one makes algorithms read out of bounds.
+template <typename G>
+G loadSnapshot(const std::string& path, bool prefault = false, bool verify = true);
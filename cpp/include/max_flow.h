@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <type_traits>
+#include "graph.h"
+
+// Accumulated flow: 64-bit integers for integer capacities, double otherwise
+template <typename Weight>
+using FlowType = WeightSum<Weight>;
+
+// Result of a single s-t max-flow computation. Edge weights are capacities,
+// usable in both directions (undirected graph).
+template <typename G>
+struct MaxFlowResult {
+    FlowType<typename G::Weight> flow = 0; // Value of the maximum flow
+    std::vector<bool> sourceSide;          // Vertices on the s side of a minimum cut
+    std::vector<typename G::Index> cutEdges; // Ids of the edges crossing that cut
+};
+
+// Highest-label push-relabel engine with global relabeling and the gap
+// heuristic. Builds the residual network once, then answers any number of
+// s-t queries; an instance is not thread-safe, use one per thread.
+template <typename G>
+class MaxFlow {
+public:
+    using Index = typename G::Index;
+    using Flow = FlowType<typename G::Weight>;
+
+    explicit MaxFlow(const G& graph);
+
+    // Max flow value from s to t; when sourceSide is given it receives the
+    // s side of a minimum cut
+    Flow solve(Index s, Index t, std::vector<bool>* sourceSide = nullptr);
+
+private:
+    static constexpr Index NONE = G::NO_VERTEX;
+
+    const typename G::CSR& g;
+    Index n;
+    std::vector<uint64_t> reverse;         // Arc index of the opposite direction
+    std::vector<Flow> residual;
+    std::vector<Flow> excess;
+    std::vector<Index> height;
+    std::vector<uint64_t> current;         // Current-arc pointer per vertex
+
+    // Per-height buckets: singly linked active vertices, doubly linked inactive ones
+    std::vector<Index> firstActive, firstInactive;
+    std::vector<Index> nextActive, nextInactive, prevInactive;
+    int64_t maxActive = -1;                // Highest bucket that may hold an active vertex
+    int64_t maxHeight = 0;                 // Highest height in use below n
+    uint64_t work = 0;                     // Work since the last global relabel
+
+    void addActive(Index h, Index v);
+    void addInactive(Index h, Index v);
+    void removeInactive(Index h, Index v);
+    void globalRelabel(Index s, Index t);
+    void gap(Index h);
+    void discharge(Index v, Index t);
+};
+
+// Convenience wrapper returning the flow value together with the cut
+template <typename G>
+MaxFlowResult<G> maxFlow(const G& graph, typename G::Index s, typename G::Index t);
+
+// Independent s-t queries spread across threads (0 = hardware concurrency)
+template <typename G>
+std::vector<FlowType<typename G::Weight>> maxFlowBatch(
+    const G& graph, const std::vector<std::pair<typename G::Index, typename G::Index>>& pairs, unsigned threads = 0);
+
+// Flow-equivalent Gomory-Hu tree built with Gusfield's algorithm: n - 1 max
+// flow computations, after which the min cut between any pair is the lightest
+// edge on their tree path.
+template <typename G>
+class GomoryHuTree {
+public:
+    using Index = typename G::Index;
+    using Flow = FlowType<typename G::Weight>;
+
+    explicit GomoryHuTree(const G& graph);
+
+    Flow minCut(Index u, Index v) const;
+    std::vector<Flow> minCutBatch(const std::vector<std::pair<Index, Index>>& pairs, unsigned threads = 0) const;
+    // Min cut of every pair, row-major n x n (diagonal is 0)
+    std::vector<Flow> minCutMatrix(unsigned threads = 0) const;
+
+    const std::vector<Index>& parents() const { return parent; }     // parent[0] == G::NO_VERTEX
+    const std::vector<Flow>& cutValues() const { return cut; }       // cut to parent
+
+private:
+    std::vector<Index> parent;
+    std::vector<Flow> cut;
+    std::vector<Index> depth;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// Equal-cost next hops towards a set of destinations. Row r = j * n + v
+// covers vertex v and destination j: its next hops are
+// nextHops[offsets[r], offsets[r + 1]), empty for the destination itself and
+// for vertices that cannot reach it.
+template <typename G>
+struct EcmpTable {
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+
+    std::vector<Distance> distances;       // Row r: distance from v to destination j (max() if unreachable)
+    std::vector<uint64_t> offsets;
+    std::vector<Index> nextHops;
+};
+
+// Paths of many source/target pairs in one arena. Path i visits
+// vertices[pathOffsets[i], pathOffsets[i + 1]) and has length lengths[i];
+// the paths of pair j are [pairOffsets[j], pairOffsets[j + 1]), shortest first.
+template <typename G>
+struct PathPool {
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+
+    std::vector<uint64_t> pairOffsets;
+    std::vector<uint64_t> pathOffsets;
+    std::vector<Index> vertices;
+    std::vector<Distance> lengths;
+};
+
+// One shortest path tree per destination; destinations spread across
+// threads (0 = hardware concurrency). Weights must be non-negative.
+template <typename G>
+EcmpTable<G> ecmpNextHops(const G& graph, const std::vector<typename G::Index>& destinations, unsigned threads = 0);
+
+// Yen's k shortest loopless paths for each (sources[j], targets[j]). Pairs
+// sharing a target share its shortest path tree, which gives the first path
+// and an exact A* potential for the spur searches; spurs whose lower bound
+// cannot beat the candidates already queued are skipped. Paths come shortest
+// first; the order among equal-length paths follows the searches and is
+// unspecified. Weights must be non-negative.
+template <typename G>
+PathPool<G> kShortestPaths(const G& graph, const std::vector<typename G::Index>& sources,
+                           const std::vector<typename G::Index>& targets, typename G::Index k, unsigned threads = 0);
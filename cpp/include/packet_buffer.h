@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+class PacketPool;
+
+// Packet bytes inside a slab with free space before and after them, so
+// headers are prepended and trailers appended by moving the ends rather than
+// copying the payload (the sk_buff / mbuf layout). Move-only; the slab goes
+// back to its pool when the buffer is destroyed, so buffers must not outlive
+// their pool.
+class PacketBuffer {
+public:
+    PacketBuffer() = default;
+    PacketBuffer(PacketBuffer&& other) noexcept { swap(other); }
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept {
+        PacketBuffer(std::move(other)).swap(*this);
+        return *this;
+    }
+    PacketBuffer(const PacketBuffer&) = delete;
+    PacketBuffer& operator=(const PacketBuffer&) = delete;
+    ~PacketBuffer() { release(); }
+
+    uint8_t* data() { return slab + head; }
+    const uint8_t* data() const { return slab + head; }
+    size_t size() const { return tail - head; }
+    bool empty() const { return tail == head; }
+    size_t headroom() const { return head; }
+    size_t tailroom() const { return capacity - tail; }
+
+    // Prepend n bytes; returns the new start
+    uint8_t* push(size_t n) {
+        if (n > head) throw std::length_error("packet headroom exhausted");
+        head -= n;
+        return data();
+    }
+    // Drop n bytes from the front; returns the new start
+    uint8_t* pull(size_t n) {
+        if (n > size()) throw std::length_error("packet shorter than the header pulled");
+        head += n;
+        return data();
+    }
+    // Append n bytes; returns where they go
+    uint8_t* put(size_t n) {
+        if (n > tailroom()) throw std::length_error("packet tailroom exhausted");
+        uint8_t* end = slab + tail;
+        tail += n;
+        return end;
+    }
+    // Drop n bytes from the end
+    void trim(size_t n) {
+        if (n > size()) throw std::length_error("packet shorter than the trailer trimmed");
+        tail -= n;
+    }
+    void append(const uint8_t* bytes, size_t n) {
+        if (n) std::memcpy(put(n), bytes, n);
+    }
+
+private:
+    friend class PacketPool;
+
+    PacketPool* pool = nullptr;            // Null for oversized slabs owned by the buffer
+    uint8_t* slab = nullptr;
+    size_t capacity = 0;
+    size_t head = 0;
+    size_t tail = 0;
+
+    PacketBuffer(PacketPool* pool, uint8_t* slab, size_t capacity, size_t headroom)
+        : pool(pool), slab(slab), capacity(capacity), head(headroom), tail(headroom) {}
+
+    void swap(PacketBuffer& other) noexcept {
+        std::swap(pool, other.pool);
+        std::swap(slab, other.slab);
+        std::swap(capacity, other.capacity);
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+    }
+    inline void release();
+};
+
+// Free list of fixed-size slabs. acquire() hands out a returned slab when
+// one is free, so a steady stream of packets stops allocating once the pool
+// holds as many slabs as packets are alive at a time. Not thread-safe: use
+// one pool per thread or simulated link.
+class PacketPool {
+public:
+    explicit PacketPool(size_t slabSize = 2048, size_t headroom = 64) : slabBytes(slabSize), reserve(headroom) {
+        if (headroom >= slabSize) throw std::invalid_argument("packet headroom must be smaller than the slab");
+    }
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // Empty buffer with the pool's headroom in front and room for at least
+    // `size` bytes after it. Requests larger than a slab get a slab of their
+    // own that is freed with the buffer.
+    PacketBuffer acquire(size_t size = 0) {
+        if (reserve + size > slabBytes) {
+            return PacketBuffer(nullptr, new uint8_t[reserve + size], reserve + size, reserve);
+        }
+        if (freeSlabs.empty()) {
+            allocated.emplace_back(new uint8_t[slabBytes]);
+            freeSlabs.reserve(allocated.size());
+            return PacketBuffer(this, allocated.back().get(), slabBytes, reserve);
+        }
+        uint8_t* slab = freeSlabs.back();
+        freeSlabs.pop_back();
+        return PacketBuffer(this, slab, slabBytes, reserve);
+    }
+
+    size_t slabSize() const { return slabBytes; }
+    size_t headroom() const { return reserve; }
+    size_t slabs() const { return allocated.size(); }
+    size_t available() const { return freeSlabs.size(); }
+
+private:
+    friend class PacketBuffer;
+
+    size_t slabBytes;
+    size_t reserve;
+    std::vector<std::unique_ptr<uint8_t[]>> allocated;
+    std::vector<uint8_t*> freeSlabs;       // Capacity kept at slabs(), so returns never allocate
+};
+
+inline void PacketBuffer::release() {
+    if (!slab) return;
+    if (pool) {
+        pool->freeSlabs.push_back(slab);
+    } else {
+        delete[] slab;
+    }
+    slab = nullptr;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Number of worker threads used when a caller passes threads = 0
+inline unsigned resolveThreadCount(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max(1u, threads);
+}
+
+// Run fn(i) for every i in [begin, end) on up to `threads` workers.
+// Indices are handed out in blocks of `grain` from a shared counter, so
+// uneven per-index work is balanced dynamically.
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, unsigned threads, Fn&& fn, size_t grain = 1) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(1, grain);
+    size_t blocks = (end - begin + grain - 1) / grain;
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), blocks));
+
+    std::atomic<size_t> next(begin);
+    auto worker = [&]() {
+        while (true) {
+            size_t start = next.fetch_add(grain);
+            if (start >= end) break;
+            size_t stop = std::min(end, start + grain);
+            for (size_t i = start; i < stop; i++) {
+                fn(i);
+            }
+        }
+    };
+
+    if (workers == 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned t = 1; t < workers; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+}
+
+// Run fn(worker) once on each of `workers` threads (worker in [0, workers)).
+// Used for per-thread scratch state that outlives a single index.
+template <typename Fn>
+void parallelRun(unsigned workers, Fn&& fn) {
+    if (workers <= 1) {
+        fn(0u);
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned t = 1; t < workers; t++) {
+        pool.emplace_back([&fn, t]() { fn(t); });
+    }
+    fn(0u);
+    for (auto& th : pool) {
+        th.join();
+    }
+}
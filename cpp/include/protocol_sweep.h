@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "stop_and_wait.h"
+
+// Values of each ProtocolConfig field to combine; every combination is a cell
+struct SweepGrid {
+    std::vector<double> errorProbability;
+    std::vector<double> lossProbability;
+    std::vector<double> ackLossProbability;
+    std::vector<int> timeoutMs;
+};
+
+// Per-cell statistics, flattened in row-major order over
+// (errorProbability, lossProbability, ackLossProbability, timeoutMs)
+struct SweepResult {
+    std::vector<double> successRate;
+    std::vector<double> meanAttempts;      // Frames sent per transfer, failures included
+    std::vector<uint32_t> p50Attempts;
+    std::vector<uint32_t> p90Attempts;
+    std::vector<uint32_t> p99Attempts;
+    std::vector<double> meanLatencyMs;
+    std::vector<double> goodputBps;        // Delivered payload bits per simulated second
+    std::vector<uint64_t> attemptCounts;   // cells x maxRetries: transfers that sent k + 1 frames
+};
+
+// `trials` virtual-time Stop-and-Wait transfers of `data` for every cell of
+// the grid, the other fields taken from `config`. Trials are split into
+// chunks that workers take from a shared queue; each chunk draws from its own
+// stream of `seed`, so results do not depend on the thread count. Throws
+// std::invalid_argument for an empty axis, no trials or maxRetries < 1.
+SweepResult sweepProtocolConfigs(const std::vector<uint8_t>& data, const ProtocolConfig& config,
+                                 const SweepGrid& grid, uint64_t trials, uint64_t seed = 0, unsigned threads = 0);
@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Wall-clock counterpart of EventLoop running on a thread of its own.
+// Callbacks run on that thread at steady_clock deadlines, ties in the order
+// they were scheduled; at(), after() and post() may be called from any
+// thread, callbacks included. Long callbacks delay the ones behind them.
+class RealTimeLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    RealTimeLoop() : worker([this]() { run(); }) {}
+    RealTimeLoop(const RealTimeLoop&) = delete;
+    RealTimeLoop& operator=(const RealTimeLoop&) = delete;
+    ~RealTimeLoop() { shutdown(); }
+
+    void at(Clock::time_point when, Callback fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            heap.push_back({when, order++, std::move(fn)});
+            std::push_heap(heap.begin(), heap.end(), Later());
+        }
+        wakeup.notify_one();
+    }
+    void after(double delayMs, Callback fn) {
+        at(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(delayMs)),
+           std::move(fn));
+    }
+    void post(Callback fn) { at(Clock::now(), std::move(fn)); }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heap.size();
+    }
+
+    // Stop the thread once the running callback returns; callbacks not yet
+    // run stay queued until clear()
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+    // Drop queued callbacks, destroying what they captured on this thread
+    void clear() {
+        std::vector<Entry> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            dropped.swap(heap);
+        }
+    }
+
+private:
+    struct Entry {
+        Clock::time_point time;
+        uint64_t order;
+        Callback fn;
+    };
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.time != b.time ? a.time > b.time : a.order > b.order;
+        }
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::vector<Entry> heap;
+    uint64_t order = 0;
+    bool stopping = false;
+    std::thread worker;                    // Last, so it starts after the members above
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (heap.empty()) {
+                wakeup.wait(lock);
+            } else if (heap.front().time > Clock::now()) {
+                wakeup.wait_until(lock, heap.front().time);
+            } else {
+                std::pop_heap(heap.begin(), heap.end(), Later());
+                Callback fn = std::move(heap.back().fn);
+                heap.pop_back();
+                lock.unlock();
+                fn();
+                fn = nullptr;              // Release captures before retaking the lock
+                lock.lock();
+            }
+        }
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// SplitMix64 step, used to expand seeds into generator state
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Nondeterministic seed for simulations run without an explicit one
+inline uint64_t randomSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
+// Stateless random value for position `counter` of stream `seed`.
+// Lets parallel generators draw the same numbers regardless of thread count.
+inline uint64_t counterRandom(uint64_t seed, uint64_t counter) {
+    uint64_t state = seed ^ (counter * 0xD1B54A32D192ED03ULL);
+    return splitmix64(state);
+}
+
+// xoshiro256++ generator (Blackman & Vigna). Small, fast and seedable;
+// satisfies UniformRandomBitGenerator so it works with <random> distributions.
+class Xoshiro256pp {
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256pp(uint64_t seed = 0, uint64_t stream = 0) {
+        uint64_t sm = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (auto& word : s) {
+            word = splitmix64(sm);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Uniform integer in [0, bound) using Lemire's multiply-shift reduction
+    uint64_t below(uint64_t bound) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * bound) >> 64);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s[4];
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "stop_and_wait.h"
+
+// Sliding-window ARQ over the Stop-and-Wait frame layout (buildFrame)
+enum class ArqProtocol : uint8_t { GO_BACK_N, SELECTIVE_REPEAT };
+
+struct WindowConfig {
+    ArqProtocol protocol = ArqProtocol::GO_BACK_N;
+    uint32_t windowSize = 7;               // Frames in flight
+    uint32_t sequenceBits = 3;             // Sequence space 2^bits, at most 8 (one header byte); 0 = smallest that fits
+};
+
+struct WindowStats {
+    uint64_t delivered = 0;                // Frames handed up in order by the receiver
+    uint64_t transmissions = 0;            // Data frames put on the link
+    uint64_t retransmissions = 0;
+    uint64_t timeouts = 0;
+    uint64_t crcErrors = 0;                // Corrupted frames caught by the receiver
+    uint64_t undetectedErrors = 0;         // Corrupted frames that passed the CRC
+    uint32_t sequenceBits = 0;             // Sequence space actually used
+    double elapsedMs = 0.0;                // Until the last frame was acknowledged
+    double goodputBps = 0.0;               // Delivered payload bits per simulated second
+    double utilization = 0.0;              // Share of the run the link spent on delivered frames
+};
+
+// Send `data` `count` times with Go-Back-N or Selective-Repeat in virtual
+// time. The link model is the one simulateTransfers uses: frames and 1-byte
+// ACKs are serialized at config.bandwidthBps in each direction and arrive
+// config.propagationDelayMs later; data frames are lost or get bits flipped
+// (per frame, or by config.corruption's bit-level model) and the receiver's
+// CRC check decides, and ACKs are lost with the configured probabilities.
+// Timers run config.timeoutMs from the end of a frame's transmission: one for
+// the window base in Go-Back-N, one per frame in Selective-Repeat. Frames are
+// retransmitted until acknowledged (maxRetries does not apply: a window cannot
+// skip a frame). Throws std::invalid_argument if the window does not fit the
+// sequence space (2^bits - 1 for Go-Back-N, 2^(bits - 1) for Selective-Repeat)
+// or a probability makes delivery impossible. Runs with the same seed and
+// stream are identical.
+WindowStats simulateWindow(const std::vector<uint8_t>& data, uint64_t count, const ProtocolConfig& config,
+                           const WindowConfig& window, uint64_t seed = 0, uint64_t stream = 0);
+
+// simulateWindow for each window size, with sequenceBits fixed or (0) the
+// smallest that fits each window; window i runs on stream i of `seed`
+std::vector<WindowStats> sweepWindowSizes(const std::vector<uint8_t>& data, uint64_t count,
+                                          const ProtocolConfig& config, ArqProtocol protocol,
+                                          const std::vector<uint32_t>& windowSizes, uint32_t sequenceBits = 0,
+                                          uint64_t seed = 0);
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "graph.h"
+
+// Port roles and states. 802.1D Blocking is DISCARDING; LISTENING only
+// occurs in 802.1D.
+enum class PortRole : uint8_t { DISABLED, ROOT, DESIGNATED, ALTERNATE, BACKUP };
+enum class PortState : uint8_t { DISCARDING, LISTENING, LEARNING, FORWARDING };
+
+// Protocol timers in milliseconds of simulated time (802.1D defaults)
+struct StpConfig {
+    bool rapid = false;                    // 802.1w RSTP (proposal/agreement) instead of 802.1D
+    uint32_t helloTime = 2000;
+    uint32_t maxAge = 20000;               // Also bounds the diameter: message age grows every hop
+    uint32_t forwardDelay = 15000;
+    uint32_t messageAgeIncrement = 1000;   // Added to the message age by each bridge
+    uint32_t bpduDelay = 1;                // Transmission, propagation and processing per hop
+    uint64_t duration = 0;                 // Simulated time; 0 runs until the topology has settled
+    unsigned threads = 0;                  // Workers for large BPDU batches (0 = hardware concurrency)
+};
+
+template <typename G>
+struct StpResult {
+    using Index = typename G::Index;
+
+    // Port of each edge end, [2e] at edge.u and [2e + 1] at edge.v, as
+    // PortRole and PortState values
+    std::vector<uint8_t> roles;
+    std::vector<uint8_t> states;
+    std::vector<uint8_t> active;           // Per edge: forwarding at both ends
+    std::vector<Index> rootBridge;         // Root each bridge has elected
+    std::vector<WeightSum<typename G::Weight>> rootCost;
+    std::vector<Index> parentOf;           // Bridge across the root port, NO_VERTEX for roots
+    std::vector<Index> rootPortEdge;       // Edge of the root port, NO_VERTEX for roots
+    uint64_t convergenceTime = 0;          // Last port role or state change
+    uint64_t endTime = 0;                  // Simulated time when the run stopped
+    uint64_t bpdus = 0;                    // BPDUs delivered
+    uint64_t ticks = 0;                    // Distinct instants with events
+    uint64_t changes = 0;                  // Port role and state changes
+    bool converged = false;                // Root/designated ports forwarding, all others discarding
+    bool loopFree = false;                 // Forwarding edges form a forest
+};
+
+// Discrete-event 802.1D / 802.1w simulation with every vertex a bridge and
+// every edge a point-to-point link whose weight is the port path cost. Bridge
+// ids are (priority, vertex); priorities default to 32768, so the lowest
+// vertex wins the root election. All bridges boot at time 0; `failures`
+// takes links down as (time, edge id) and both ends notice at once.
+// Events are kept per millisecond: the BPDUs, hello and forward-delay timers
+// due at one instant are grouped by bridge and each bridge processes its
+// batch in one step (in parallel across bridges for large batches), so the
+// result does not depend on the thread count. Topology change notification
+// is not modelled. Received information is aged on each hello tick.
+template <typename G>
+StpResult<G> simulateSpanningTree(const G& graph, const StpConfig& config = StpConfig(),
+                                  const std::vector<uint16_t>& priorities = {},
+                                  const std::vector<std::pair<uint64_t, typename G::Index>>& failures = {});
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "graph.h"
+
+// Tree connecting a set of terminals
+template <typename G>
+struct SteinerTree {
+    using Index = typename G::Index;
+
+    std::vector<Index> edges;              // Edge ids, ascending
+    WeightSum<typename G::Weight> weight = 0;
+    // False when the terminals lie in several components; `edges` then
+    // holds one tree per component
+    bool connected = true;
+};
+
+// Mehlhorn's 2-approximate Steiner trees. Each query grows the shortest
+// path Voronoi regions of its terminals in one multi-source Dijkstra, takes
+// the minimum spanning tree of the terminal distance network formed by
+// edges crossing regions, and expands each of its edges into the graph path
+// through the two regions. The union is already a tree whose leaves are
+// terminals. The builder keeps the edge list, so many multicast groups can
+// be evaluated on one graph; batches run in parallel. Weights must be
+// non-negative.
+template <typename G>
+class SteinerTreeBuilder {
+public:
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+
+    explicit SteinerTreeBuilder(const G& graph);
+
+    SteinerTree<G> build(const std::vector<Index>& terminals) const;
+    std::vector<SteinerTree<G>> buildBatch(const std::vector<std::vector<Index>>& groups, unsigned threads = 0) const;
+
+    Index numVertices() const { return graph.numVertices(); }
+    const typename G::Edge& edge(Index id) const { return edges[id]; }
+
+private:
+    struct Workspace;
+
+    const G& graph;
+    std::vector<typename G::Edge> edges;
+
+    SteinerTree<G> build(const std::vector<Index>& terminals, Workspace& work) const;
+};
@@ -2,6 +2,19 @@
 #include <vector>
 #include <cstdint>
 #include <chrono>
+#include <functional>
+#include "rng.h"
+#include "packet_buffer.h"
+
+// How data frames get corrupted. FRAME decides per frame with
+// errorProbability and drops the frame without touching its bytes;
+// BIT_ERRORS and BURST flip real bits and leave the verdict to the
+// receiver's CRC check.
+enum class CorruptionModel : uint8_t {
+    FRAME,
+    BIT_ERRORS,                            // Each bit flips independently with probability bitErrorRate
+    BURST                                  // Bursts start at a bit with probability bitErrorRate
+};
 
 // Configuration for the protocol
 struct ProtocolConfig {
@@ -10,13 +23,104 @@ struct ProtocolConfig {
     double errorProbability = 0.1;         // Probability of packet corruption
     double lossProbability = 0.1;          // Probability of packet loss
     double ackLossProbability = 0.1;       // Probability of ACK loss
+    bool virtualTime = false;              // Advance a simulated clock instead of waiting in real time
+    double propagationDelayMs = 0.0;       // One-way link delay (virtual time)
+    double bandwidthBps = 0.0;             // Link rate for transmission delay, 0 = instantaneous (virtual time)
+    CorruptionModel corruption = CorruptionModel::FRAME;
+    double bitErrorRate = 0.0;             // BIT_ERRORS / BURST; errorProbability is then unused
+    uint32_t burstLength = 16;             // BURST: bits from first to last error; the ones between flip with p = 1/2
+};
+
+// State of one simulated link: time in milliseconds, the generator that
+// decides losses and corruption, and the pool its frames are built in. In
+// virtual-time mode sendPacket advances the time by the transmission,
+// propagation and timeout delays and returns at once. Clocks with the same
+// seed and stream replay the same run; different streams of one seed are
+// independent, so concurrent runs need no locking.
+struct SimClock {
+    double nowMs = 0.0;
+    uint64_t frames = 0;                   // Data frames put on the link
+    uint64_t crcErrors = 0;                // Bit-corrupted frames the receiver's CRC rejected
+    uint64_t undetectedErrors = 0;         // Bit-corrupted frames that passed the CRC
+    Xoshiro256pp rng;
+    PacketPool pool;                       // 2048-byte slabs with 64 bytes of headroom
+
+    SimClock() : rng(randomSeed()) {}
+    SimClock(uint64_t seed, uint64_t stream = 0) : rng(seed, stream) {}
 };
 
-// Send a packet with CRC, sequence number, and wait for ACK
+// Back-to-back virtual-time transfers of one payload
+struct TransferStats {
+    uint64_t delivered = 0;
+    uint64_t failed = 0;                   // Gave up after maxRetries
+    uint64_t attempts = 0;
+    double elapsedMs = 0.0;                // Simulated time for the whole run
+    double goodputBps = 0.0;               // Delivered payload bits per simulated second
+    double utilization = 0.0;              // Share of the run the link spent on delivered frames
+    uint64_t crcErrors = 0;
+    uint64_t undetectedErrors = 0;         // Transfers "delivered" with corrupted bytes
+    std::vector<double> latencyMs;         // Per transfer, failures included
+};
+
+// Frame layout shared by all the ARQ engines: sequence number byte, payload,
+// then the CRC-32 of both, most significant byte first
+std::vector<uint8_t> buildFrame(const std::vector<uint8_t>& data, int seqNum);
+
+// The same layout built in place around the payload already in `packet`: the
+// sequence number goes into the headroom and the CRC into the tailroom
+void framePacket(PacketBuffer& packet, int seqNum);
+
+// Flip the bits of `frame` that the BIT_ERRORS or BURST channel corrupts
+// (bit 0 is the most significant bit of byte 0) and return how many flipped;
+// FRAME mode flips nothing. Gaps between errors are drawn from the geometric
+// distribution, so a clean frame costs a single draw.
+uint32_t applyBitErrors(uint8_t* frame, size_t size, const ProtocolConfig& config, Xoshiro256pp& rng);
+
+// Check a frame's CRC, reporting the computed and received values; false if
+// the frame is too short or corrupted
+bool verifyFrame(const std::vector<uint8_t>& frame, uint32_t& computedCRC, uint32_t& receivedCRC);
+bool verifyFrame(const uint8_t* frame, size_t size, uint32_t& computedCRC, uint32_t& receivedCRC);
+
+// Send a packet with CRC, sequence number, and wait for ACK, on a clock
+// private to the calling thread
 bool sendPacket(const std::vector<uint8_t>& data, std::vector<uint8_t>& ack, int& seqNum, const ProtocolConfig& config = ProtocolConfig());
 
+// Same on the given clock; in virtual-time mode a lost frame or ACK costs the
+// frame's transmission time plus the full timeout, as the sender cannot tell
+// a loss from a slow link
+bool sendPacket(const std::vector<uint8_t>& data, std::vector<uint8_t>& ack, int& seqNum, const ProtocolConfig& config,
+                SimClock& clock);
+
+class RealTimeLoop;
+
+struct SendResult {
+    bool delivered = false;
+    std::vector<uint8_t> ack;
+    int seqNum = 0;                        // Next sequence number, as sendPacket leaves it
+};
+
+// sendPacket without a blocked thread: the wait for the ACK is a chain of
+// timed callbacks on `loop`, so any number of transfers share its thread.
+// `done` runs on the loop thread; virtual-time configs finish in the first
+// callback.
+void sendPacketAsync(RealTimeLoop& loop, const std::vector<uint8_t>& data, int seqNum, const ProtocolConfig& config,
+                     std::function<void(SendResult)> done);
+
+// Send `data` `count` times in virtual time (whatever config.virtualTime says)
+// on a SimClock(seed, stream)
+TransferStats simulateTransfers(const std::vector<uint8_t>& data, uint64_t count, const ProtocolConfig& config,
+                                uint64_t seed = 0, uint64_t stream = 0);
+
 // Receive a packet, verify CRC and sequence number
 bool receivePacket(std::vector<uint8_t>& data, int& seqNum, const ProtocolConfig& config = ProtocolConfig());
 
+// Same on a pooled frame, drawing network conditions from the clock's
+// generator; on success the header and CRC are popped, leaving the payload
+bool receivePacket(PacketBuffer& packet, int& seqNum, const ProtocolConfig& config, SimClock& clock);
+
 // Simulate network conditions (errors and losses, including ACK loss)
+bool simulateNetworkConditions(const std::vector<uint8_t>& packet, const ProtocolConfig& config, Xoshiro256pp& rng,
+                               bool isAck = false);
+
+// Same with a randomly seeded generator private to the calling thread
 bool simulateNetworkConditions(const std::vector<uint8_t>& packet, const ProtocolConfig& config, bool isAck = false); 
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+#include <coroutine>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "stop_and_wait_endpoints.h"
+
+// Coroutine run by a FlowNetwork: starts at once, runs to its first
+// co_await, and is resumed by the event loop. The task owns the frame and
+// destroys it, finished or still suspended. An exception escapes from the
+// resume, i.e. out of EventLoop::run.
+class FlowTask {
+public:
+    struct promise_type {
+        FlowTask get_return_object() { return FlowTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    FlowTask(FlowTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    FlowTask& operator=(FlowTask&& other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+    FlowTask(const FlowTask&) = delete;
+    FlowTask& operator=(const FlowTask&) = delete;
+    ~FlowTask() {
+        if (handle) handle.destroy();
+    }
+
+    bool done() const { return !handle || handle.done(); }
+
+private:
+    explicit FlowTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+struct FlowStats {
+    uint64_t flows = 0;
+    uint64_t delivered = 0;                // Messages handed up by the receivers
+    uint64_t failed = 0;                   // Given up after maxRetries transmissions
+    uint64_t frames = 0;
+    uint64_t retransmissions = 0;
+    uint64_t timeouts = 0;
+    uint64_t duplicates = 0;
+    uint64_t crcErrors = 0;
+    uint64_t events = 0;
+    double elapsedMs = 0.0;                // Until the last sender finished
+    double meanCompletionMs = 0.0;         // Per flow
+    double throughputBps = 0.0;            // Delivered payload bits of all flows per simulated second
+};
+
+// Many flows on one event loop, each with its own DATA and ACK direction
+// modelled as a Channel is (serialization, propagation, loss, corruption),
+// sharing one generator and one packet pool. Endpoints are coroutines that
+// co_await receive(); frames in flight sit in a shared slot table, so a
+// flow costs two Endpoints plus its coroutine frames. Single-threaded.
+class FlowNetwork {
+public:
+    using Direction = Channel::Direction;
+
+    FlowNetwork(EventLoop& loop, const ProtocolConfig& config, size_t flows, size_t frameBytes, uint64_t seed = 0);
+
+    EventLoop& eventLoop() { return loop; }
+    const ProtocolConfig& protocol() const { return config; }
+    size_t flows() const { return endpoints.size() / 2; }
+    FlowStats& stats() { return counters; }
+
+    // Empty pooled buffer for a frame of up to frameBytes
+    PacketBuffer acquire(size_t size) { return pool.acquire(size); }
+
+    // Send `frame` on `flow` towards the endpoint awaiting `direction`;
+    // returns the time its last bit leaves
+    double send(uint32_t flow, Direction direction, PacketBuffer frame);
+
+    class Receive {
+    public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> waiter) { net.suspend(endpoint, waiter, deadline); }
+        std::optional<PacketBuffer> await_resume() { return std::exchange(net.endpoints[endpoint].inbox, std::nullopt); }
+
+    private:
+        friend class FlowNetwork;
+        Receive(FlowNetwork& net, uint32_t endpoint, double deadline)
+            : net(net), endpoint(endpoint), deadline(deadline) {}
+        FlowNetwork& net;
+        uint32_t endpoint;
+        double deadline;
+    };
+
+    // Awaitable: the next frame arriving for `flow` in `direction`, or
+    // nothing once `deadline` passes. Frames arriving while no one waits
+    // are dropped.
+    Receive receive(uint32_t flow, Direction direction,
+                    double deadline = std::numeric_limits<double>::infinity()) {
+        return Receive(*this, index(flow, direction), deadline);
+    }
+
+private:
+    static constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+    struct Endpoint {
+        std::coroutine_handle<> waiter;
+        std::optional<PacketBuffer> inbox;
+        double deadline = NEVER;
+        double timerAt = NEVER;            // Earliest queued timer event
+        double linkFree = 0.0;             // When the link towards this endpoint finishes serializing
+    };
+    struct InFlight {
+        PacketBuffer frame;
+        uint32_t endpoint;
+    };
+
+    EventLoop& loop;
+    const ProtocolConfig config;
+    Xoshiro256pp rng;
+    PacketPool pool;
+    std::vector<Endpoint> endpoints;       // DATA and ACK side of each flow
+    std::vector<InFlight> inFlight;
+    std::vector<uint32_t> freeSlots;
+    FlowStats counters;
+
+    static uint32_t index(uint32_t flow, Direction direction) {
+        return flow * 2 + static_cast<uint32_t>(direction);
+    }
+    void suspend(uint32_t endpoint, std::coroutine_handle<> waiter, double deadline);
+    void arrive(uint32_t slot);
+    void onTimer(uint32_t endpoint);
+    void wake(Endpoint& endpoint);
+};
+
+// Stop-and-Wait sender for `count` messages carrying `payload` on `flow`:
+// "wait for the ACK or the timeout" is one co_await. Sets `completedAt` when
+// done; the network, payload and completedAt must outlive the task.
+FlowTask stopAndWaitSender(FlowNetwork& net, uint32_t flow, const std::vector<uint8_t>& payload, uint64_t count,
+                           double& completedAt);
+// Stop-and-Wait receiver on `flow`; runs until its task is destroyed
+FlowTask stopAndWaitReceiver(FlowNetwork& net, uint32_t flow);
+
+// `flows` concurrent transfers of `messages` copies of `payload` each, all
+// coroutines on the calling thread
+FlowStats simulateFlows(const std::vector<uint8_t>& payload, size_t flows, uint64_t messages,
+                        const ProtocolConfig& config, uint64_t seed = 0);
@@ -0,0 +1,161 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "event_loop.h"
+#include "stop_and_wait.h"
+
+// One direction of a point-to-point link. Frames are serialized back to back
+// at config.bandwidthBps and arrive config.propagationDelayMs after their
+// last bit leaves. DATA channels lose frames with lossProbability and corrupt
+// them with config.corruption's model (FRAME flips one bit with
+// errorProbability); ACK channels only lose frames, with ackLossProbability.
+class Channel {
+public:
+    enum class Direction : uint8_t { DATA, ACK };
+    using Receiver = std::function<void(PacketBuffer&)>;
+
+    Channel(EventLoop& loop, const ProtocolConfig& config, Direction direction, uint64_t seed = 0,
+            uint64_t stream = 0);
+
+    void connect(Receiver receiver) { deliver = std::move(receiver); }
+
+    // Queue `frame` behind the frames being serialized; returns the time its
+    // last bit leaves
+    double send(PacketBuffer frame);
+
+    uint64_t sent() const { return framesSent; }
+    uint64_t lost() const { return framesLost; }
+    uint64_t corrupted() const { return framesCorrupted; }
+    double busyMs() const { return busy; }
+
+private:
+    struct InFlight {
+        double arrival;
+        PacketBuffer frame;
+    };
+
+    EventLoop& loop;
+    const ProtocolConfig config;
+    const Direction direction;
+    Xoshiro256pp rng;
+    Receiver deliver;
+    std::deque<InFlight> inFlight;         // Constant delay, so frames arrive in send order
+    double freeAt = 0.0;                   // When the current serialization ends
+    uint64_t framesSent = 0;
+    uint64_t framesLost = 0;
+    uint64_t framesCorrupted = 0;
+    double busy = 0.0;
+
+    void arrive();
+};
+
+enum class FrameFate : uint8_t { INTACT, CORRUPTED, LOST };
+
+// The loss and corruption a Channel applies to one frame sent in `direction`;
+// corrupted frames are altered in place
+FrameFate impairFrame(PacketBuffer& frame, const ProtocolConfig& config, Channel::Direction direction,
+                      Xoshiro256pp& rng);
+
+struct SenderStats {
+    uint64_t delivered = 0;                // Messages acknowledged
+    uint64_t failed = 0;                   // Given up after maxRetries transmissions
+    uint64_t frames = 0;                   // Transmissions, retransmissions included
+    uint64_t retransmissions = 0;
+    uint64_t timeouts = 0;
+};
+
+// Stop-and-Wait sender: one frame outstanding, alternating sequence numbers,
+// retransmission config.timeoutMs after a frame's last bit leaves. Giving up
+// after maxRetries transmissions moves on to the next message on the same
+// sequence number, as sendPacket does; if the receiver had got the frame it
+// takes the next message for a duplicate, a limit of the alternating bit.
+class StopAndWaitSender {
+public:
+    using Completion = std::function<void(bool delivered, double latencyMs)>;
+
+    StopAndWaitSender(EventLoop& loop, Channel& channel, const ProtocolConfig& config);
+
+    // Queue `copies` messages carrying `payload`; sending starts at once when idle
+    void send(const std::vector<uint8_t>& payload, uint64_t copies = 1);
+    // Called by the ACK channel
+    void onAck(PacketBuffer& ack);
+    void onComplete(Completion completion) { completed = std::move(completion); }
+
+    bool idle() const { return !waiting; }
+    const SenderStats& stats() const { return counters; }
+
+private:
+    EventLoop& loop;
+    Channel& channel;
+    const ProtocolConfig config;
+    PacketPool pool;
+    std::deque<std::pair<std::vector<uint8_t>, uint64_t>> queue;  // Payloads and copies left
+    PacketBuffer current;                  // Framed message awaiting its ACK
+    int seqNum = 0;
+    int attempts = 0;
+    double deadline = 0.0;                 // Retransmission time of the outstanding frame
+    bool timerArmed = false;               // A timer event is queued, possibly for an older deadline
+    bool waiting = false;
+    double startedAt = 0.0;
+    SenderStats counters;
+    Completion completed;
+
+    void next();
+    void transmit();
+    void armTimer();
+    void onTimer();
+    void finish(bool delivered);
+};
+
+struct ReceiverStats {
+    uint64_t delivered = 0;                // Messages handed up
+    uint64_t bytes = 0;
+    uint64_t duplicates = 0;               // Retransmissions of a delivered message, re-acknowledged
+    uint64_t crcErrors = 0;                // Dropped without an ACK
+};
+
+// Stop-and-Wait receiver: checks each frame's CRC, hands new payloads up and
+// acknowledges every intact frame with its sequence number
+class StopAndWaitReceiver {
+public:
+    using Delivery = std::function<void(const uint8_t* payload, size_t size)>;
+
+    explicit StopAndWaitReceiver(Channel& ackChannel);
+
+    // Called by the data channel
+    void onFrame(PacketBuffer& frame);
+    void onDeliver(Delivery delivery) { delivered = std::move(delivery); }
+
+    const ReceiverStats& stats() const { return counters; }
+
+private:
+    Channel& ackChannel;
+    PacketPool pool;
+    int expectedSeqNum = 0;
+    ReceiverStats counters;
+    Delivery delivered;
+};
+
+// Bulk transfer between a sender and receiver joined by a DATA and an ACK
+// channel (streams 0 and 1 of `seed`)
+struct LinkStats {
+    uint64_t delivered = 0;                // At the receiver
+    uint64_t failed = 0;
+    uint64_t frames = 0;
+    uint64_t retransmissions = 0;
+    uint64_t timeouts = 0;
+    uint64_t duplicates = 0;
+    uint64_t crcErrors = 0;
+    uint64_t undetectedErrors = 0;         // Corrupted frames that passed the CRC
+    uint64_t events = 0;                   // Processed by the event loop
+    double elapsedMs = 0.0;
+    double throughputBps = 0.0;            // Delivered payload bits per simulated second
+    double utilization = 0.0;              // Share of the run spent serializing delivered frames
+    double busy = 0.0;                     // Share of the run the data channel was serializing
+    double propagationRatio = 0.0;         // a = propagation delay / frame time; lossless utilization ~ 1/(1+2a)
+};
+
+LinkStats simulateLink(const std::vector<uint8_t>& payload, uint64_t count, const ProtocolConfig& config,
+                       uint64_t seed = 0);
@@ -4,6 +4,7 @@
 #include <chrono>
 #include <deque>
 #include <map>
+#include "rng.h"
 
 // TCP Tahoe State
 enum class TCPState {
@@ -47,6 +48,8 @@ struct TCPStats {
 class TCPTahoe {
 public:
     TCPTahoe(const TCPConfig& config = TCPConfig());
+    // Loss decisions drawn from stream `stream` of `seed`, so runs replay
+    TCPTahoe(const TCPConfig& config, uint64_t seed, uint64_t stream = 0);
     
     // Core TCP Tahoe functions
     bool sendData(const std::vector<uint8_t>& data);
@@ -88,6 +91,8 @@ private:
     std::map<uint32_t, std::chrono::steady_clock::time_point> packetSendTimes;  // Track send times for RTT calculation
     
     std::chrono::steady_clock::time_point lastSendTime;
+
+    Xoshiro256pp rng;             // Packet loss
     
     // Helper functions
     void updateWindowSize();
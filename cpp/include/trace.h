@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary event tracing for the protocol hot paths. Each thread appends
+// fixed-size records to its own lock-free ring (single producer, single
+// consumer); a background thread drains the rings to the trace file. A full
+// ring drops records instead of blocking and the loss is recorded at the end.
+//
+// Levels are filtered twice: NETSIM_TRACE_LEVEL removes the calls at compile
+// time, and startTrace sets the level recorded at run time (tracing is off
+// until then, costing one relaxed load per call site).
+
+enum class TraceLevel : uint8_t { OFF = 0, WARN = 1, INFO = 2, DEBUG = 3 };
+
+#ifndef NETSIM_TRACE_LEVEL
+#define NETSIM_TRACE_LEVEL 3
+#endif
+
+// Event ids are stored in the file together with their names and argument
+// names, so readers need no copy of this list
+enum class TraceEvent : uint16_t {
+    TRACE_DROPPED = 0,                     // dropped
+    SW_SEND,                               // seq, attempt, bytes
+    SW_LOST,                               // bytes
+    SW_CORRUPTED,                          // bytes
+    SW_ACK_LOST,
+    SW_TIMEOUT,                            // seq, attempt
+    SW_ACKED,                              // seq, attempts
+    SW_GAVE_UP,                            // seq, attempts
+    SW_RECEIVED,                           // seq, bytes
+    SW_CRC_ERROR,                          // seq, computed, received
+    SW_BAD_SEQUENCE,                       // seq, expected
+    TCP_WINDOW_FULL,                       // buffered, window
+    TCP_SEND_LOST,                         // seq
+    TCP_SENT,                              // seq, cwnd, state
+    TCP_DUP_ACK,                           // ack, count
+    TCP_FAST_RETRANSMIT,                   // ack, ssthresh
+    TCP_ACK,                               // ack, cwnd, rtt
+    TCP_TIMEOUT,                           // rto, ssthresh
+    TCP_STATE,                             // state
+    TCP_RETRANSMIT,                        // seq
+    TCP_DELAYED_ACK,
+    ARQ_SEND,                              // seq, attempt, outstanding
+    ARQ_TIMEOUT,                           // seq, outstanding
+    ARQ_ACK,                               // base, ack
+    SW_BIT_ERRORS,                         // bytes, flipped
+    SW_UNDETECTED_ERROR,                   // seq, flipped
+    COUNT
+};
+
+// One trace record as stored in the file (little-endian, 32 bytes)
+struct TraceRecord {
+    uint64_t timeNs;                       // Since startTrace
+    uint32_t thread;                       // Small id in order of each thread's first event
+    uint16_t event;
+    uint8_t level;
+    uint8_t reserved;
+    int64_t a;
+    uint32_t b;
+    uint32_t c;
+};
+static_assert(sizeof(TraceRecord) == 32, "trace records are 32 bytes");
+
+struct TraceStats {
+    uint64_t records = 0;                  // Written to the file
+    uint64_t dropped = 0;                  // Lost to full rings
+};
+
+extern std::atomic<uint8_t> traceLevel;
+
+inline bool traceEnabled(TraceLevel level) {
+    return static_cast<uint8_t>(level) <= traceLevel.load(std::memory_order_relaxed);
+}
+
+void traceEvent(TraceLevel level, TraceEvent event, int64_t a, uint32_t b, uint32_t c);
+
+#define NETSIM_TRACE(LEVEL, EVENT, A, B, C)                                                        \
+    do {                                                                                           \
+        if (static_cast<int>(TraceLevel::LEVEL) <= NETSIM_TRACE_LEVEL && traceEnabled(TraceLevel::LEVEL)) { \
+            traceEvent(TraceLevel::LEVEL, TraceEvent::EVENT, (A), static_cast<uint32_t>(B),      \
+                       static_cast<uint32_t>(C));                                                  \
+        }                                                                                          \
+    } while (0)
+
+// Start writing events up to `level` to `path`; each thread's ring holds
+// ringRecords records (rounded up to a power of two), threads that traced in
+// an earlier session included. Throws if a trace is already running or the
+// file cannot be created.
+void startTrace(const std::string& path, TraceLevel level = TraceLevel::DEBUG, uint32_t ringRecords = 1 << 16);
+
+// Stop recording, drain every ring and close the file
+TraceStats stopTrace();
+
+bool traceRunning();
+
+// Trace file as text, one line per record: time in microseconds, thread,
+// level, event name and named arguments
+std::vector<std::string> decodeTrace(const std::string& path);
@@ -0,0 +1,34 @@
+#pragma once
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "trace.h"
+
+// Trace control for a protocol module. Every extension module links its own
+// copy of the tracer, so each module's events go to the file started there.
+// TraceLevel is module-local for the same reason, and so that the modules
+// can be imported together.
+inline void bindTrace(pybind11::module& m) {
+    namespace py = pybind11;
+    py::enum_<TraceLevel>(m, "TraceLevel", py::module_local())
+        .value("OFF", TraceLevel::OFF)
+        .value("WARN", TraceLevel::WARN)
+        .value("INFO", TraceLevel::INFO)
+        .value("DEBUG", TraceLevel::DEBUG);
+
+    m.def("startTrace", &startTrace, py::arg("path"), py::arg("level") = TraceLevel::DEBUG,
+          py::arg("ringRecords") = 1 << 16);
+    // Dict with the records written and dropped
+    m.def("stopTrace", []() {
+        TraceStats stats;
+        {
+            py::gil_scoped_release release;
+            stats = stopTrace();
+        }
+        py::dict out;
+        out["records"] = stats.records;
+        out["dropped"] = stats.dropped;
+        return out;
+    });
+    m.def("traceRunning", &traceRunning);
+    m.def("decodeTrace", &decodeTrace, py::arg("path"));
+}
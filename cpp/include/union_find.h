@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <atomic>
+
+// Disjoint sets with union by size and path halving
+template <typename Index>
+class UnionFind {
+public:
+    explicit UnionFind(size_t n = 0) { reset(n); }
+
+    void reset(size_t n) {
+        parent.resize(n);
+        size.assign(n, 1);
+        for (size_t i = 0; i < n; i++) parent[i] = static_cast<Index>(i);
+    }
+
+    Index find(Index x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    // False when a and b were already in the same set
+    bool unite(Index a, Index b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        return true;
+    }
+
+private:
+    std::vector<Index> parent;
+    std::vector<Index> size;
+};
+
+// Lock-free disjoint sets for unions from several threads at once. Roots
+// are linked larger index under smaller, so every set's root is its
+// smallest member. find() is final once all unions have finished.
+template <typename Index>
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(size_t n = 0) : parent(n) {
+        for (size_t i = 0; i < n; i++) parent[i].store(static_cast<Index>(i), std::memory_order_relaxed);
+    }
+
+    Index find(Index x) {
+        while (true) {
+            Index p = parent[x].load(std::memory_order_relaxed);
+            if (p == x) return x;
+            Index grand = parent[p].load(std::memory_order_relaxed);
+            if (grand != p) parent[x].compare_exchange_weak(p, grand, std::memory_order_relaxed);
+            x = grand;
+        }
+    }
+
+    void unite(Index a, Index b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            Index expected = a;
+            if (parent[a].compare_exchange_strong(expected, b)) return;
+        }
+    }
+
+private:
+    std::vector<std::atomic<Index>> parent;
+};
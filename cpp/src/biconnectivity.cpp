@@ -0,0 +1,298 @@
+#include "biconnectivity.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace {
+
+// Levels with fewer vertices are processed inline rather than on the pool
+constexpr size_t PARALLEL_LEVEL = 4096;
+
+// Renumber component labels in [0, labels) by smallest edge id
+template <typename Index>
+Index canonicalComponents(std::vector<Index>& component, size_t labels) {
+    constexpr Index NONE = std::numeric_limits<Index>::max();
+    std::vector<Index> remap(labels, NONE);
+    Index next = 0;
+    for (auto& c : component) {
+        if (c == NONE) continue;
+        if (remap[c] == NONE) remap[c] = next++;
+        c = remap[c];
+    }
+    return next;
+}
+
+// Vertices whose edges lie in more than one component
+template <typename G>
+void markArticulations(const G& graph, Biconnectivity<G>& result, unsigned threads) {
+    using Index = typename G::Index;
+    const auto& g = graph.csr();
+    parallelFor(0, graph.numVertices(), threads, [&](size_t u) {
+        Index first = G::NO_VERTEX;
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index c = result.component[g.edgeIds[a]];
+            if (c == G::NO_VERTEX) continue;
+            if (first == G::NO_VERTEX) {
+                first = c;
+            } else if (c != first) {
+                result.articulation[u] = 1;
+                break;
+            }
+        }
+    }, 1024);
+}
+
+} // namespace
+
+template <typename G>
+Biconnectivity<G> biconnectivity(const G& graph) {
+    using Index = typename G::Index;
+    constexpr Index NONE = G::NO_VERTEX;
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    const size_t m = graph.numEdges();
+
+    Biconnectivity<G> result;
+    result.bridge.assign(m, 0);
+    result.articulation.assign(n, 0);
+    result.component.assign(m, NONE);
+
+    // Edges are identified by id rather than by endpoint, so a parallel edge
+    // back to the DFS parent counts as a back edge
+    struct Frame {
+        Index vertex;
+        Index parentEdge;
+        uint64_t arc;    // next arc to scan
+    };
+    std::vector<Index> disc(n, NONE), low(n);
+    std::vector<Frame> stack;
+    std::vector<Index> edgeStack;   // tree and back edges of the open components
+    Index clock = 0, labels = 0;
+    for (Index root = 0; root < n; root++) {
+        if (disc[root] != NONE) continue;
+        disc[root] = low[root] = clock++;
+        stack.push_back({root, NONE, g.offsets[root]});
+        Index rootChildren = 0;
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            Index u = top.vertex;
+            if (top.arc < g.offsets[u + 1]) {
+                uint64_t a = top.arc++;
+                Index w = g.targets[a];
+                Index e = g.edgeIds[a];
+                if (e == top.parentEdge || w == u) continue;
+                if (disc[w] == NONE) {
+                    if (u == root) rootChildren++;
+                    edgeStack.push_back(e);
+                    disc[w] = low[w] = clock++;
+                    stack.push_back({w, e, g.offsets[w]});
+                } else if (disc[w] < disc[u]) {
+                    edgeStack.push_back(e);
+                    low[u] = std::min(low[u], disc[w]);
+                }
+                continue;
+            }
+
+            Index treeEdge = top.parentEdge;
+            stack.pop_back();
+            if (stack.empty()) break;
+            Index p = stack.back().vertex;
+            low[p] = std::min(low[p], low[u]);
+            if (low[u] >= disc[p]) {
+                // p separates u's subtree: its edges since (p, u) form a component
+                if (p != root) result.articulation[p] = 1;
+                Index e;
+                do {
+                    e = edgeStack.back();
+                    edgeStack.pop_back();
+                    result.component[e] = labels;
+                } while (e != treeEdge);
+                labels++;
+                if (low[u] > disc[p]) result.bridge[treeEdge] = 1;
+            }
+        }
+        if (rootChildren >= 2) result.articulation[root] = 1;
+    }
+    result.numComponents = canonicalComponents(result.component, labels);
+    return result;
+}
+
+template <typename G>
+Biconnectivity<G> biconnectivityParallel(const G& graph, unsigned threads) {
+    using Index = typename G::Index;
+    constexpr Index NONE = G::NO_VERTEX;
+    threads = resolveThreadCount(threads);
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    const size_t m = graph.numEdges();
+    auto threadsFor = [&](size_t work) { return work < PARALLEL_LEVEL ? 1u : threads; };
+
+    Biconnectivity<G> result;
+    result.bridge.assign(m, 0);
+    result.articulation.assign(n, 0);
+    result.component.assign(m, NONE);
+
+    // Connected components; each is rooted at its smallest vertex
+    std::vector<Index> order;
+    {
+        ConcurrentUnionFind<Index> sets(n);
+        parallelFor(0, n, threads, [&](size_t u) {
+            for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                if (g.targets[a] > u) sets.unite(static_cast<Index>(u), g.targets[a]);
+            }
+        }, 1024);
+        for (Index v = 0; v < n; v++) {
+            if (sets.find(v) == v) order.push_back(v);
+        }
+    }
+    const size_t numRoots = order.size();
+
+    // Level-synchronous BFS from all roots at once; `order` lists the
+    // vertices level by level, level L spanning [levels[L], levels[L + 1])
+    std::vector<std::atomic<Index>> claimed(n);
+    std::vector<Index> parentEdge(n, NONE);
+    parallelFor(0, n, threads, [&](size_t v) { claimed[v].store(NONE, std::memory_order_relaxed); }, 4096);
+    for (Index root : order) claimed[root].store(root, std::memory_order_relaxed);
+    std::vector<size_t> levels = {0, order.size()};
+    while (levels.back() > levels[levels.size() - 2]) {
+        const size_t begin = levels[levels.size() - 2], end = levels.back();
+        const unsigned workers = threadsFor(end - begin);
+        std::vector<std::vector<Index>> found(workers);
+        std::atomic<size_t> next(begin);
+        parallelRun(workers, [&](unsigned worker) {
+            auto& out = found[worker];
+            while (true) {
+                size_t start = next.fetch_add(256);
+                if (start >= end) break;
+                for (size_t i = start; i < std::min(end, start + 256); i++) {
+                    Index u = order[i];
+                    for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                        Index w = g.targets[a];
+                        Index expected = NONE;
+                        if (claimed[w].load(std::memory_order_relaxed) == NONE &&
+                            claimed[w].compare_exchange_strong(expected, u, std::memory_order_relaxed)) {
+                            parentEdge[w] = g.edgeIds[a];
+                            out.push_back(w);
+                        }
+                    }
+                }
+            }
+        });
+        for (auto& out : found) order.insert(order.end(), out.begin(), out.end());
+        levels.push_back(order.size());
+    }
+    levels.pop_back();
+    const size_t numLevels = levels.size() - 1;
+    auto forLevel = [&](size_t level, auto&& fn) {
+        parallelFor(levels[level], levels[level + 1], threadsFor(levels[level + 1] - levels[level]),
+                    [&](size_t i) { fn(order[i]); }, 256);
+    };
+
+    // Children lists in BFS order
+    std::vector<uint64_t> childOffsets(static_cast<size_t>(n) + 1, 0);
+    for (size_t i = numRoots; i < order.size(); i++) {
+        childOffsets[claimed[order[i]].load(std::memory_order_relaxed) + 1]++;
+    }
+    for (Index v = 0; v < n; v++) childOffsets[v + 1] += childOffsets[v];
+    std::vector<Index> children(order.size() - numRoots);
+    {
+        std::vector<uint64_t> fill(childOffsets.begin(), childOffsets.end() - 1);
+        for (size_t i = numRoots; i < order.size(); i++) {
+            children[fill[claimed[order[i]].load(std::memory_order_relaxed)]++] = order[i];
+        }
+    }
+
+    // Subtree sizes bottom-up, then preorder numbers top-down: a child starts
+    // right after its parent and the subtrees of its earlier siblings
+    std::vector<Index> size(n), pre(n);
+    for (size_t level = numLevels; level-- > 0;) {
+        forLevel(level, [&](Index v) {
+            Index total = 1;
+            for (uint64_t c = childOffsets[v]; c < childOffsets[v + 1]; c++) total += size[children[c]];
+            size[v] = total;
+        });
+    }
+    {
+        Index start = 0;
+        for (size_t i = 0; i < numRoots; i++) {
+            pre[order[i]] = start;
+            start += size[order[i]];
+        }
+    }
+    for (size_t level = 0; level < numLevels; level++) {
+        forLevel(level, [&](Index v) {
+            Index next = pre[v] + 1;
+            for (uint64_t c = childOffsets[v]; c < childOffsets[v + 1]; c++) {
+                pre[children[c]] = next;
+                next += size[children[c]];
+            }
+        });
+    }
+
+    // low/high: smallest and largest preorder number reachable from a
+    // subtree through one non-tree edge (or inside it)
+    std::vector<Index> low(n), high(n);
+    parallelFor(0, n, threads, [&](size_t v) {
+        Index lo = pre[v], hi = pre[v];
+        for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+            if (g.edgeIds[a] == parentEdge[v]) continue;
+            lo = std::min(lo, pre[g.targets[a]]);
+            hi = std::max(hi, pre[g.targets[a]]);
+        }
+        low[v] = lo;
+        high[v] = hi;
+    }, 1024);
+    for (size_t level = numLevels; level-- > 0;) {
+        forLevel(level, [&](Index v) {
+            for (uint64_t c = childOffsets[v]; c < childOffsets[v + 1]; c++) {
+                low[v] = std::min(low[v], low[children[c]]);
+                high[v] = std::max(high[v], high[children[c]]);
+            }
+        });
+    }
+    auto inSubtree = [&](Index v, Index w) { return pre[w] >= pre[v] && pre[w] < pre[v] + size[v]; };
+
+    // A tree edge (p, v) is a bridge when no non-tree edge leaves v's subtree
+    parallelFor(numRoots, order.size(), threads, [&](size_t i) {
+        Index v = order[i];
+        if (low[v] >= pre[v] && high[v] < pre[v] + size[v]) result.bridge[parentEdge[v]] = 1;
+    }, 1024);
+
+    // Auxiliary graph on tree edges, each named by its child vertex. Two tree
+    // edges share a component when a non-tree edge joins their unrelated
+    // subtrees, or when the subtree below (p, v) escapes p's subtree.
+    ConcurrentUnionFind<Index> sets(n);
+    parallelFor(0, n, threads, [&](size_t u) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index w = g.targets[a];
+            Index e = g.edgeIds[a];
+            if (pre[u] >= pre[w] || e == parentEdge[w]) continue;
+            if (!inSubtree(static_cast<Index>(u), w)) sets.unite(static_cast<Index>(u), w);
+        }
+    }, 1024);
+    parallelFor(numRoots, order.size(), threads, [&](size_t i) {
+        Index v = order[i];
+        Index p = claimed[v].load(std::memory_order_relaxed);
+        if (parentEdge[p] == NONE) return;
+        if (low[v] < pre[p] || high[v] >= pre[p] + size[p]) sets.unite(v, p);
+    }, 1024);
+
+    // Every edge (u, w) with pre[u] < pre[w] belongs to the component of w's
+    // tree edge; self loops have pre[u] == pre[w] and stay unlabelled
+    parallelFor(0, n, threads, [&](size_t u) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index w = g.targets[a];
+            if (pre[u] < pre[w]) result.component[g.edgeIds[a]] = sets.find(w);
+        }
+    }, 1024);
+    result.numComponents = canonicalComponents(result.component, n);
+    markArticulations(graph, result, threads);
+    return result;
+}
+
+#define NETSIM_INSTANTIATE_BICONNECTIVITY(I, W, NAME)                                        \
+    template Biconnectivity<BasicGraph<I, W>> biconnectivity(const BasicGraph<I, W>&);       \
+    template Biconnectivity<BasicGraph<I, W>> biconnectivityParallel(const BasicGraph<I, W>&, unsigned);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_BICONNECTIVITY)
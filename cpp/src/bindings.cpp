@@ -1,12 +1,547 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <string>
+#include <type_traits>
 #include "graph.h"
+#include "graph_generators.h"
+#include "max_flow.h"
+#include "graph_snapshot.h"
+#include "graph_reorder.h"
+#include "contraction_hierarchy.h"
+#include "failure_analysis.h"
+#include "biconnectivity.h"
+#include "edge_betweenness.h"
+#include "steiner_tree.h"
+#include "multipath.h"
+#include "external_mst.h"
+#include "graph_partition.h"
+#include "spanning_tree_protocol.h"
 
 namespace py = pybind11;
 
+namespace {
+
+// Vertex id as seen from Python; NO_VERTEX becomes -1 as in the original int API
+template <typename G>
+int64_t vertexToPython(typename G::Index v) {
+    return v == G::NO_VERTEX ? -1 : static_cast<int64_t>(v);
+}
+
+// Hand a vector to numpy without copying; the array owns it from then on
+template <typename T>
+py::array_t<T> toNumpy(std::vector<T>&& values) {
+    auto* owned = new std::vector<T>(std::move(values));
+    py::capsule release(owned, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+    return py::array_t<T>(owned->size(), owned->data(), release);
+}
+
+// Vertex ids from a numpy array (or any sequence numpy accepts), range-checked
+template <typename G>
+std::vector<typename G::Index> verticesFromPython(const py::array_t<int64_t, py::array::c_style | py::array::forcecast>& array,
+                                                  typename G::Index n) {
+    if (array.ndim() != 1) throw std::invalid_argument("vertex array must be one-dimensional");
+    std::vector<typename G::Index> ids(array.size());
+    auto view = array.template unchecked<1>();
+    for (py::ssize_t i = 0; i < view.shape(0); i++) {
+        if (view(i) < 0 || static_cast<uint64_t>(view(i)) >= static_cast<uint64_t>(n)) {
+            throw std::out_of_range("vertex id out of range");
+        }
+        ids[i] = static_cast<typename G::Index>(view(i));
+    }
+    return ids;
+}
+
+// Path lengths for Python: unreachable becomes -1 for integer weights, inf for floats
+template <typename Distance>
+py::array_t<Distance> distancesToPython(std::vector<Distance>&& distances) {
+    for (Distance& d : distances) {
+        if (d == std::numeric_limits<Distance>::max()) {
+            d = std::numeric_limits<Distance>::has_infinity ? std::numeric_limits<Distance>::infinity() : Distance(-1);
+        }
+    }
+    return toNumpy(std::move(distances));
+}
+
+// Failure table as a dict of numpy columns; missing ids become -1
+template <typename G>
+py::dict failureTableToPython(FailureTable<G>&& table) {
+    std::vector<int64_t> replacement;
+    replacement.reserve(table.replacement.size());
+    for (auto e : table.replacement) replacement.push_back(vertexToPython<G>(e));
+    py::dict columns;
+    columns["mstDelta"] = toNumpy(std::move(table.mstDelta));
+    columns["mstSplits"] = toNumpy(std::move(table.mstSplits));
+    columns["replacement"] = toNumpy(std::move(replacement));
+    if (!table.affectedPairs.empty() || !table.meanStretch.empty()) {
+        columns["affectedPairs"] = toNumpy(std::move(table.affectedPairs));
+        columns["disconnectedPairs"] = toNumpy(std::move(table.disconnectedPairs));
+        columns["meanStretch"] = toNumpy(std::move(table.meanStretch));
+        columns["maxStretch"] = toNumpy(std::move(table.maxStretch));
+    }
+    return columns;
+}
+
+// Boolean numpy mask over a byte vector
+py::object maskToPython(std::vector<uint8_t>&& mask) {
+    return toNumpy(std::move(mask)).attr("view")("bool");
+}
+
+// Bridges and articulation points as masks, components per edge (-1 for self loops)
+template <typename G>
+py::dict biconnectivityToPython(Biconnectivity<G>&& result) {
+    std::vector<int64_t> component;
+    component.reserve(result.component.size());
+    for (auto c : result.component) component.push_back(vertexToPython<G>(c));
+    py::dict out;
+    out["bridges"] = maskToPython(std::move(result.bridge));
+    out["articulationPoints"] = maskToPython(std::move(result.articulation));
+    out["components"] = toNumpy(std::move(component));
+    out["numComponents"] = result.numComponents;
+    return out;
+}
+
+// Steiner tree as a dict: edge ids, their endpoints as an (edges, 2) array,
+// total weight and whether all terminals were connected
+template <typename G>
+py::dict steinerTreeToPython(const SteinerTreeBuilder<G>& builder, SteinerTree<G>&& tree) {
+    std::vector<int64_t> ids(tree.edges.begin(), tree.edges.end());
+    std::vector<int64_t> endpoints;
+    endpoints.reserve(2 * ids.size());
+    for (auto e : tree.edges) {
+        endpoints.push_back(builder.edge(e).u);
+        endpoints.push_back(builder.edge(e).v);
+    }
+    py::dict out;
+    out["edges"] = toNumpy(std::move(ids));
+    out["endpoints"] = toNumpy(std::move(endpoints)).attr("reshape")(-1, 2);
+    out["weight"] = tree.weight;
+    out["connected"] = tree.connected;
+    return out;
+}
+
+// Read-only numpy view of a vector owned by the Python object `owner`
+template <typename T>
+py::array_t<T> viewOf(const std::vector<T>& values, py::handle owner) {
+    py::array_t<T> view(values.size(), values.data(), owner);
+    view.attr("setflags")(py::arg("write") = false);
+    return view;
+}
+
+template <typename G>
+std::vector<std::pair<int64_t, int64_t>> mstToPython(const std::vector<std::pair<typename G::Index, typename G::Index>>& edges) {
+    std::vector<std::pair<int64_t, int64_t>> mst;
+    mst.reserve(edges.size());
+    for (const auto& edge : edges) {
+        mst.push_back({vertexToPython<G>(edge.first), vertexToPython<G>(edge.second)});
+    }
+    return mst;
+}
+
+// Register one graph instantiation and the algorithms templated on it.
+// Class names get the type suffix (Graph_u32_f32, GomoryHuTree_u32_f32, ...);
+// module functions are overloaded on the graph argument.
+template <typename G>
+void bindGraph(py::module& m, const std::string& suffix) {
+    using Index = typename G::Index;
+    using Weight = typename G::Weight;
+
+    py::class_<G>(m, ("Graph" + suffix).c_str())
+        .def(py::init<Index>())
+        .def("addEdge", &G::addEdge)
+        .def("primMST", [](G& g, Index root) { return mstToPython<G>(g.primMST(root)); }, py::arg("root") = 0)
+        .def("mst", &G::primTree, py::arg("root") = 0, py::arg("parentsOnly") = false,
+             py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly_static("NO_VERTEX", [](py::object) { return G::NO_VERTEX; })
+        .def("numVertices", &G::numVertices)
+        .def("numEdges", &G::numEdges)
+        .def("isMapped", &G::isMapped)
+        .def("bandwidth", &graphBandwidth<G>)
+        .def("reordered", [](const G& g, VertexOrder order, unsigned threads) {
+            return ReorderedGraph<G>(g, order, threads);
+        }, py::arg("order") = VertexOrder::RCM, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("saveSnapshot", [](const G& g, const std::string& path) { saveSnapshot(g, path); },
+             py::arg("path"), py::call_guard<py::gil_scoped_release>())
+        .def("writeEdgeFile", [](const G& g, const std::string& path) { writeEdgeFile(g, path); },
+             py::arg("path"), py::call_guard<py::gil_scoped_release>())
+        // numpy dtype of one edge file record, for np.fromfile/np.memmap
+        .def_static("edgeRecordDtype", []() {
+            py::list fields;
+            fields.append(py::make_tuple("u", py::dtype::of<Index>()));
+            fields.append(py::make_tuple("v", py::dtype::of<Index>()));
+            fields.append(py::make_tuple("weight", py::dtype::of<Weight>()));
+            return py::dtype::from_args(fields);
+        })
+        // Minimum spanning forest of an edge file too large for memory; tree
+        // edges go to treeFile, the dict holds the run statistics
+        .def_static("externalMST", [](const std::string& edgeFile, Index vertices, const std::string& treeFile,
+                                      uint64_t memoryBytes, const std::string& tempDir, unsigned threads) {
+            ExternalMstStats<G> stats;
+            {
+                py::gil_scoped_release release;
+                stats = externalMST<G>(edgeFile, vertices, treeFile, memoryBytes, tempDir, threads);
+            }
+            py::dict out;
+            out["inputEdges"] = stats.inputEdges;
+            out["runs"] = stats.runs;
+            out["runEdges"] = stats.runEdges;
+            out["treeEdges"] = stats.treeEdges;
+            out["weight"] = stats.weight;
+            out["components"] = stats.components;
+            return out;
+        }, py::arg("edgeFile"), py::arg("vertices"), py::arg("treeFile"), py::arg("memoryBytes") = uint64_t(1) << 30,
+           py::arg("tempDir") = "", py::arg("threads") = 0)
+        .def_static("erdosRenyi", &erdosRenyi<G>, py::arg("n"), py::arg("p"),
+                    py::arg("config") = GeneratorConfig(), py::call_guard<py::gil_scoped_release>())
+        .def_static("barabasiAlbert", &barabasiAlbert<G>, py::arg("n"), py::arg("m"),
+                    py::arg("config") = GeneratorConfig(), py::call_guard<py::gil_scoped_release>())
+        .def_static("waxman", &waxman<G>, py::arg("n"), py::arg("alpha"), py::arg("beta"),
+                    py::arg("config") = GeneratorConfig(), py::call_guard<py::gil_scoped_release>())
+        .def_static("fatTree", &fatTree<G>, py::arg("k"), py::arg("includeHosts") = true, py::arg("weight") = Weight(1))
+        .def_static("torus", &torus<G>, py::arg("dims"), py::arg("weight") = Weight(1));
+
+    // Arrays are zero-copy views that keep the tree alive; parentOf marks the
+    // root and unreached vertices with Graph.NO_VERTEX
+    using Tree = typename G::SpanningTree;
+    py::class_<Tree>(m, ("SpanningTree" + suffix).c_str())
+        .def_readonly("root", &Tree::root)
+        .def_readonly("treeEdges", &Tree::treeEdges)
+        .def_readonly("totalWeight", &Tree::totalWeight)
+        .def_property_readonly("parents", [](py::object self) { return viewOf(self.cast<const Tree&>().parents, self); })
+        .def_property_readonly("children", [](py::object self) { return viewOf(self.cast<const Tree&>().children, self); })
+        .def_property_readonly("weights", [](py::object self) { return viewOf(self.cast<const Tree&>().weights, self); })
+        .def_property_readonly("parentOf", [](py::object self) { return viewOf(self.cast<const Tree&>().parentOf, self); });
+
+    py::class_<MaxFlowResult<G>>(m, ("MaxFlowResult" + suffix).c_str())
+        .def_readonly("flow", &MaxFlowResult<G>::flow)
+        .def_readonly("sourceSide", &MaxFlowResult<G>::sourceSide)
+        .def_readonly("cutEdges", &MaxFlowResult<G>::cutEdges);
+
+    m.def("maxFlow", &maxFlow<G>, py::arg("graph"), py::arg("s"), py::arg("t"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("maxFlowBatch", &maxFlowBatch<G>, py::arg("graph"), py::arg("pairs"), py::arg("threads") = 0,
+          py::call_guard<py::gil_scoped_release>());
+    // Dict with bridges (per edge id) and articulationPoints (per vertex)
+    // masks and each edge's biconnected component
+    m.def("biconnectivity", [](const G& graph, bool parallel, unsigned threads) {
+        Biconnectivity<G> result;
+        {
+            py::gil_scoped_release release;
+            result = parallel ? biconnectivityParallel(graph, threads) : biconnectivity(graph);
+        }
+        return biconnectivityToPython(std::move(result));
+    }, py::arg("graph"), py::arg("parallel") = false, py::arg("threads") = 0);
+    // Exact Brandes unless samples (or epsilon, which picks the sample count
+    // for that bound) is given; dict with centrality per edge id, sources used
+    // and the error bound holding with probability 1 - delta
+    m.def("edgeBetweenness", [](const G& graph, uint64_t samples, double epsilon, double delta, uint64_t seed,
+                                bool weighted, unsigned threads) {
+        EdgeBetweenness<G> result;
+        {
+            py::gil_scoped_release release;
+            if (epsilon > 0.0) samples = betweennessSamples(graph.numEdges(), epsilon, delta);
+            if (samples == 0 || samples >= graph.numVertices()) {
+                result = edgeBetweenness(graph, weighted, threads);
+            } else {
+                result = edgeBetweennessSampled(graph, static_cast<Index>(samples), delta, seed, weighted, threads);
+            }
+        }
+        py::dict out;
+        out["centrality"] = toNumpy(std::move(result.centrality));
+        out["sources"] = result.sources;
+        out["errorBound"] = result.errorBound;
+        return out;
+    }, py::arg("graph"), py::arg("samples") = 0, py::arg("epsilon") = 0.0, py::arg("delta") = 0.1,
+       py::arg("seed") = 1, py::arg("weighted") = true, py::arg("threads") = 0);
+    // Dict with the part of each vertex and the cut statistics
+    m.def("partition", [](const G& graph, Index parts, double epsilon, uint64_t seed, unsigned threads) {
+        GraphPartition<G> result;
+        {
+            py::gil_scoped_release release;
+            result = partitionGraph(graph, parts, epsilon, seed, threads);
+        }
+        std::vector<int64_t> part(result.part.begin(), result.part.end());
+        py::dict out;
+        out["parts"] = toNumpy(std::move(part));
+        out["partSizes"] = toNumpy(std::move(result.partSizes));
+        out["partCut"] = toNumpy(std::move(result.partCut));
+        out["cutEdges"] = result.cutEdges;
+        out["cutWeight"] = result.cutWeight;
+        out["imbalance"] = result.imbalance;
+        return out;
+    }, py::arg("graph"), py::arg("parts"), py::arg("epsilon") = 0.03, py::arg("seed") = 1, py::arg("threads") = 0);
+    // Dict with per-edge (edges, 2) port roles and states (ends ordered as in
+    // the edge list), the active edge mask, each bridge's root, root path cost
+    // and parent (-1 for roots), and the run statistics; times in ms
+    m.def("spanningTreeProtocol", [](const G& graph, const StpConfig& config, const std::vector<uint16_t>& priorities,
+                                     const std::vector<std::pair<uint64_t, Index>>& failures) {
+        StpResult<G> result;
+        {
+            py::gil_scoped_release release;
+            result = simulateSpanningTree(graph, config, priorities, failures);
+        }
+        std::vector<int64_t> parentOf, rootPortEdge;
+        parentOf.reserve(result.parentOf.size());
+        rootPortEdge.reserve(result.rootPortEdge.size());
+        for (auto v : result.parentOf) parentOf.push_back(vertexToPython<G>(v));
+        for (auto e : result.rootPortEdge) rootPortEdge.push_back(vertexToPython<G>(e));
+        py::dict out;
+        out["roles"] = toNumpy(std::move(result.roles)).attr("reshape")(-1, 2);
+        out["states"] = toNumpy(std::move(result.states)).attr("reshape")(-1, 2);
+        out["active"] = maskToPython(std::move(result.active));
+        out["rootBridge"] = toNumpy(std::move(result.rootBridge));
+        out["rootCost"] = toNumpy(std::move(result.rootCost));
+        out["parentOf"] = toNumpy(std::move(parentOf));
+        out["rootPortEdge"] = toNumpy(std::move(rootPortEdge));
+        out["convergenceTime"] = result.convergenceTime;
+        out["endTime"] = result.endTime;
+        out["bpdus"] = result.bpdus;
+        out["ticks"] = result.ticks;
+        out["changes"] = result.changes;
+        out["converged"] = result.converged;
+        out["loopFree"] = result.loopFree;
+        return out;
+    }, py::arg("graph"), py::arg("config") = StpConfig(), py::arg("priorities") = std::vector<uint16_t>(),
+       py::arg("failures") = std::vector<std::pair<uint64_t, Index>>());
+    // Dict with distances of shape (destinations, n) and the next hops of
+    // vertex v towards destination j in nextHops[offsets[j * n + v]:offsets[j * n + v + 1]]
+    m.def("ecmpNextHops", [](const G& graph, py::array_t<int64_t, py::array::c_style | py::array::forcecast> destinations,
+                             unsigned threads) {
+        auto ids = verticesFromPython<G>(destinations, graph.numVertices());
+        EcmpTable<G> table;
+        {
+            py::gil_scoped_release release;
+            table = ecmpNextHops(graph, ids, threads);
+        }
+        std::vector<int64_t> hops(table.nextHops.begin(), table.nextHops.end());
+        py::dict out;
+        out["distances"] = distancesToPython(std::move(table.distances))
+                               .attr("reshape")(ids.size(), graph.numVertices());
+        out["offsets"] = toNumpy(std::move(table.offsets));
+        out["nextHops"] = toNumpy(std::move(hops));
+        return out;
+    }, py::arg("graph"), py::arg("destinations"), py::arg("threads") = 0);
+    // Path pool dict: pair j owns paths pairOffsets[j]:pairOffsets[j + 1]; path
+    // i is vertices[pathOffsets[i]:pathOffsets[i + 1]] with length lengths[i]
+    m.def("kShortestPaths", [](const G& graph, py::array_t<int64_t, py::array::c_style | py::array::forcecast> sources,
+                               py::array_t<int64_t, py::array::c_style | py::array::forcecast> targets, Index k,
+                               unsigned threads) {
+        auto s = verticesFromPython<G>(sources, graph.numVertices());
+        auto t = verticesFromPython<G>(targets, graph.numVertices());
+        PathPool<G> pool;
+        {
+            py::gil_scoped_release release;
+            pool = kShortestPaths(graph, s, t, k, threads);
+        }
+        std::vector<int64_t> vertices(pool.vertices.begin(), pool.vertices.end());
+        py::dict out;
+        out["pairOffsets"] = toNumpy(std::move(pool.pairOffsets));
+        out["pathOffsets"] = toNumpy(std::move(pool.pathOffsets));
+        out["vertices"] = toNumpy(std::move(vertices));
+        out["lengths"] = toNumpy(std::move(pool.lengths));
+        return out;
+    }, py::arg("graph"), py::arg("sources"), py::arg("targets"), py::arg("k"), py::arg("threads") = 0);
+
+    py::class_<GomoryHuTree<G>>(m, ("GomoryHuTree" + suffix).c_str())
+        .def(py::init<const G&>(), py::arg("graph"), py::call_guard<py::gil_scoped_release>())
+        .def("minCut", &GomoryHuTree<G>::minCut)
+        .def("minCutBatch", &GomoryHuTree<G>::minCutBatch, py::arg("pairs"), py::arg("threads") = 0)
+        .def("minCutMatrix", [](const GomoryHuTree<G>& tree, unsigned threads) {
+            size_t n = tree.parents().size();
+            auto flat = tree.minCutMatrix(threads);
+            std::vector<std::vector<typename GomoryHuTree<G>::Flow>> rows(n);
+            for (size_t i = 0; i < n; i++) rows[i].assign(flat.begin() + i * n, flat.begin() + (i + 1) * n);
+            return rows;
+        }, py::arg("threads") = 0)
+        .def("parents", [](const GomoryHuTree<G>& tree) {
+            std::vector<int64_t> parents;
+            for (Index p : tree.parents()) parents.push_back(vertexToPython<G>(p));
+            return parents;
+        })
+        .def("cutValues", &GomoryHuTree<G>::cutValues);
+
+    // Results of the wrapped algorithms are already in original vertex ids
+    py::class_<ReorderedGraph<G>>(m, ("ReorderedGraph" + suffix).c_str())
+        .def(py::init<const G&, VertexOrder, unsigned>(), py::arg("graph"), py::arg("order") = VertexOrder::RCM,
+             py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("graph", &ReorderedGraph<G>::graph, py::return_value_policy::reference_internal)
+        .def("newIds", &ReorderedGraph<G>::newIds)
+        .def("originalIds", &ReorderedGraph<G>::originalIds)
+        .def("toOriginal", &ReorderedGraph<G>::toOriginal)
+        .def("toReordered", &ReorderedGraph<G>::toReordered)
+        .def("primMST", [](ReorderedGraph<G>& g, Index root) { return mstToPython<G>(g.primMST(root)); },
+             py::arg("root") = 0)
+        .def("maxFlow", &ReorderedGraph<G>::maxFlow, py::arg("s"), py::arg("t"),
+             py::call_guard<py::gil_scoped_release>());
+
+    using CH = ContractionHierarchy<G>;
+    py::class_<CH>(m, ("ContractionHierarchy" + suffix).c_str())
+        .def(py::init<const G&, unsigned, bool>(), py::arg("graph"), py::arg("threads") = 0, py::arg("labels") = false,
+             py::call_guard<py::gil_scoped_release>())
+        .def("distance", [](const CH& ch, Index s, Index t) {
+            std::vector<typename CH::Distance> d{ch.distance(s, t)};
+            return distancesToPython(std::move(d)).at(0);
+        }, py::arg("s"), py::arg("t"))
+        .def("path", [](const CH& ch, Index s, Index t) {
+            std::vector<int64_t> path;
+            for (Index v : ch.path(s, t)) path.push_back(v);
+            return path;
+        }, py::arg("s"), py::arg("t"))
+        .def("distanceBatch", [](const CH& ch, py::array_t<int64_t, py::array::c_style | py::array::forcecast> sources,
+                                 py::array_t<int64_t, py::array::c_style | py::array::forcecast> targets, unsigned threads) {
+            auto s = verticesFromPython<G>(sources, ch.numVertices());
+            auto t = verticesFromPython<G>(targets, ch.numVertices());
+            std::vector<typename CH::Distance> distances;
+            {
+                py::gil_scoped_release release;
+                distances = ch.distanceBatch(s, t, threads);
+            }
+            return distancesToPython(std::move(distances));
+        }, py::arg("sources"), py::arg("targets"), py::arg("threads") = 0)
+        // Returns (distances, offsets, vertices); path i is vertices[offsets[i]:offsets[i + 1]]
+        .def("pathBatch", [](const CH& ch, py::array_t<int64_t, py::array::c_style | py::array::forcecast> sources,
+                             py::array_t<int64_t, py::array::c_style | py::array::forcecast> targets, unsigned threads) {
+            auto s = verticesFromPython<G>(sources, ch.numVertices());
+            auto t = verticesFromPython<G>(targets, ch.numVertices());
+            typename CH::PathBatch batch;
+            {
+                py::gil_scoped_release release;
+                batch = ch.pathBatch(s, t, threads);
+            }
+            std::vector<int64_t> vertices(batch.vertices.begin(), batch.vertices.end());
+            return py::make_tuple(distancesToPython(std::move(batch.distances)), toNumpy(std::move(batch.offsets)),
+                                  toNumpy(std::move(vertices)));
+        }, py::arg("sources"), py::arg("targets"), py::arg("threads") = 0)
+        .def("numVertices", &CH::numVertices)
+        .def("numShortcuts", &CH::numShortcuts)
+        .def("numLabelEntries", &CH::numLabelEntries);
+
+    using FA = FailureAnalysis<G>;
+    py::class_<FA>(m, ("FailureAnalysis" + suffix).c_str())
+        .def(py::init<const G&, unsigned>(), py::arg("graph"), py::arg("threads") = 0, py::keep_alive<1, 2>(),
+             py::call_guard<py::gil_scoped_release>())
+        .def("mstWeight", &FA::mstWeight)
+        .def("mstEdges", [](const FA& fa) {
+            std::vector<uint8_t> mask(fa.mstEdges().begin(), fa.mstEdges().end());
+            return maskToPython(std::move(mask));
+        })
+        // Dict of numpy columns, row i describing the failure of edge i
+        .def("linkFailures", [](const FA& fa, bool stretch) {
+            FailureTable<G> table;
+            {
+                py::gil_scoped_release release;
+                table = fa.linkFailures(stretch);
+            }
+            return failureTableToPython(std::move(table));
+        }, py::arg("stretch") = true)
+        // Same columns, row i describing the failure of vertex i
+        .def("nodeFailures", [](const FA& fa, bool stretch) {
+            FailureTable<G> table;
+            {
+                py::gil_scoped_release release;
+                table = fa.nodeFailures(stretch);
+            }
+            return failureTableToPython(std::move(table));
+        }, py::arg("stretch") = true);
+
+    using ST = SteinerTreeBuilder<G>;
+    py::class_<ST>(m, ("SteinerTreeBuilder" + suffix).c_str())
+        .def(py::init<const G&>(), py::arg("graph"), py::keep_alive<1, 2>(), py::call_guard<py::gil_scoped_release>())
+        .def("build", [](const ST& builder, py::array_t<int64_t, py::array::c_style | py::array::forcecast> terminals) {
+            auto ids = verticesFromPython<G>(terminals, builder.numVertices());
+            SteinerTree<G> tree;
+            {
+                py::gil_scoped_release release;
+                tree = builder.build(ids);
+            }
+            return steinerTreeToPython(builder, std::move(tree));
+        }, py::arg("terminals"))
+        // One dict per multicast group, groups spread across threads
+        .def("buildBatch", [](const ST& builder, const std::vector<py::array_t<int64_t, py::array::c_style | py::array::forcecast>>& groups,
+                              unsigned threads) {
+            std::vector<std::vector<Index>> ids;
+            ids.reserve(groups.size());
+            for (const auto& group : groups) ids.push_back(verticesFromPython<G>(group, builder.numVertices()));
+            std::vector<SteinerTree<G>> trees;
+            {
+                py::gil_scoped_release release;
+                trees = builder.buildBatch(ids, threads);
+            }
+            py::list out;
+            for (auto& tree : trees) out.append(steinerTreeToPython(builder, std::move(tree)));
+            return out;
+        }, py::arg("groups"), py::arg("threads") = 0);
+}
+
+} // namespace
+
 PYBIND11_MODULE(graph_module, m) {
-    py::class_<Graph>(m, "Graph")
-        .def(py::init<int>())
-        .def("addEdge", &Graph::addEdge)
-        .def("primMST", &Graph::primMST);
-} 
\ No newline at end of file
+    py::class_<GeneratorConfig>(m, "GeneratorConfig")
+        .def(py::init<>())
+        .def_readwrite("seed", &GeneratorConfig::seed)
+        .def_readwrite("minWeight", &GeneratorConfig::minWeight)
+        .def_readwrite("maxWeight", &GeneratorConfig::maxWeight)
+        .def_readwrite("threads", &GeneratorConfig::threads);
+
+    py::class_<StpConfig>(m, "StpConfig")
+        .def(py::init<>())
+        .def_readwrite("rapid", &StpConfig::rapid)
+        .def_readwrite("helloTime", &StpConfig::helloTime)
+        .def_readwrite("maxAge", &StpConfig::maxAge)
+        .def_readwrite("forwardDelay", &StpConfig::forwardDelay)
+        .def_readwrite("messageAgeIncrement", &StpConfig::messageAgeIncrement)
+        .def_readwrite("bpduDelay", &StpConfig::bpduDelay)
+        .def_readwrite("duration", &StpConfig::duration)
+        .def_readwrite("threads", &StpConfig::threads);
+
+    py::enum_<PortRole>(m, "PortRole")
+        .value("DISABLED", PortRole::DISABLED)
+        .value("ROOT", PortRole::ROOT)
+        .value("DESIGNATED", PortRole::DESIGNATED)
+        .value("ALTERNATE", PortRole::ALTERNATE)
+        .value("BACKUP", PortRole::BACKUP);
+
+    py::enum_<PortState>(m, "PortState")
+        .value("DISCARDING", PortState::DISCARDING)
+        .value("LISTENING", PortState::LISTENING)
+        .value("LEARNING", PortState::LEARNING)
+        .value("FORWARDING", PortState::FORWARDING);
+
+    py::enum_<VertexOrder>(m, "VertexOrder")
+        .value("IDENTITY", VertexOrder::IDENTITY)
+        .value("DEGREE", VertexOrder::DEGREE)
+        .value("BFS", VertexOrder::BFS)
+        .value("RCM", VertexOrder::RCM);
+
+    // The int-weighted Graph keeps its plain names; every instantiation is
+    // also reachable as Graph_<index>_<weight>
+    bindGraph<Graph>(m, "");
+    m.attr("Graph_u32_i32") = m.attr("Graph");
+#define NETSIM_BIND_GRAPH(I, W, NAME)                                  \
+    if (!std::is_same<BasicGraph<I, W>, Graph>::value) {               \
+        bindGraph<BasicGraph<I, W>>(m, std::string("_") + NAME);       \
+    }
+    NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_BIND_GRAPH)
+#undef NETSIM_BIND_GRAPH
+
+    // Snapshots record their index/weight types; return the matching class
+    m.def("loadSnapshot", [](const std::string& path, bool prefault, bool verify) -> py::object {
+        SnapshotHeader header = readSnapshotHeader(path);
+#define NETSIM_LOAD_SNAPSHOT(I, W, NAME)                                                  \
+        if (snapshotMatches<BasicGraph<I, W>>(header)) {                                  \
+            return py::cast(loadSnapshot<BasicGraph<I, W>>(path, prefault, verify));      \
+        }
+        NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_LOAD_SNAPSHOT)
+#undef NETSIM_LOAD_SNAPSHOT
+        throw std::runtime_error("snapshot: no graph type matches " + path);
+    }, py::arg("path"), py::arg("prefault") = false, py::arg("verify") = true);
+
+    m.def("erdosRenyi", &erdosRenyi<Graph>, py::arg("n"), py::arg("p"),
+          py::arg("config") = GeneratorConfig(), py::call_guard<py::gil_scoped_release>());
+    m.def("barabasiAlbert", &barabasiAlbert<Graph>, py::arg("n"), py::arg("m"),
+          py::arg("config") = GeneratorConfig(), py::call_guard<py::gil_scoped_release>());
+    m.def("waxman", &waxman<Graph>, py::arg("n"), py::arg("alpha"), py::arg("beta"),
+          py::arg("config") = GeneratorConfig(), py::call_guard<py::gil_scoped_release>());
+    m.def("fatTree", &fatTree<Graph>, py::arg("k"), py::arg("includeHosts") = true, py::arg("weight") = 1);
+    m.def("torus", &torus<Graph>, py::arg("dims"), py::arg("weight") = 1);
+}
@@ -0,0 +1,541 @@
+#include "contraction_hierarchy.h"
+#include "parallel.h"
+#include "rng.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+
+// Witness searches give up after settling this many vertices; a missed
+// witness only costs an unnecessary shortcut. Priority estimates, which run
+// far more often, use the smaller limit.
+constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+constexpr size_t ESTIMATE_SETTLE_LIMIT = 50;
+
+// Overlay graph being contracted. Links always lead to vertices that are not
+// contracted yet; a vertex's links when it is contracted become its upward arcs.
+template <typename Index, typename Distance>
+struct Contraction {
+    static constexpr Distance INF = std::numeric_limits<Distance>::max();
+    static constexpr Index NONE = std::numeric_limits<Index>::max();
+
+    struct Link {
+        Index to;
+        Index middle;
+        Distance weight;
+    };
+    struct Shortcut {
+        Index u, x, middle;
+        Distance weight;
+    };
+    // Dijkstra state of one worker
+    struct Witness {
+        std::vector<Distance> dist;
+        std::vector<Index> touched;
+        std::vector<std::pair<Distance, Index>> heap;
+        std::vector<uint8_t> target;       // Neighbors whose distance is still wanted
+    };
+
+    std::vector<std::vector<Link>> adj;
+    std::vector<uint8_t> excluded;         // Contracted in the current round
+    std::vector<Index> contractedNeighbors;
+    std::vector<Index> level;              // 1 + highest level among contracted neighbors
+
+    // Shortest distances from source avoiding `avoid` and this round's vertices,
+    // up to bound; stops early once the `targets` flagged vertices are settled
+    void witness(Witness& w, Index source, Index avoid, Distance bound, size_t limit, size_t targets) const {
+        for (Index v : w.touched) w.dist[v] = INF;
+        w.touched.clear();
+        w.heap.clear();
+        w.dist[source] = 0;
+        w.touched.push_back(source);
+        w.heap.push_back({0, source});
+        size_t settled = 0;
+        auto later = std::greater<std::pair<Distance, Index>>();
+        while (!w.heap.empty()) {
+            std::pop_heap(w.heap.begin(), w.heap.end(), later);
+            auto [d, u] = w.heap.back();
+            w.heap.pop_back();
+            if (d > w.dist[u]) continue;
+            if (d > bound || ++settled > limit) break;
+            if (w.target[u] && --targets == 0) break;
+            for (const Link& link : adj[u]) {
+                if (link.to == avoid || excluded[link.to]) continue;
+                Distance nd = d + link.weight;
+                if (nd < w.dist[link.to]) {
+                    if (w.dist[link.to] == INF) w.touched.push_back(link.to);
+                    w.dist[link.to] = nd;
+                    w.heap.push_back({nd, link.to});
+                    std::push_heap(w.heap.begin(), w.heap.end(), later);
+                }
+            }
+        }
+    }
+
+    // Shortcuts needed to contract v; collected into out when given
+    size_t simulate(Witness& w, Index v, std::vector<Shortcut>* out) const {
+        const auto& links = adj[v];
+        size_t count = 0;
+        for (size_t i = 0; i + 1 < links.size(); i++) {
+            Distance bound = 0;
+            for (size_t j = i + 1; j < links.size(); j++) {
+                bound = std::max(bound, links[i].weight + links[j].weight);
+                w.target[links[j].to] = 1;
+            }
+            witness(w, links[i].to, v, bound, out ? WITNESS_SETTLE_LIMIT : ESTIMATE_SETTLE_LIMIT, links.size() - i - 1);
+            for (size_t j = i + 1; j < links.size(); j++) {
+                w.target[links[j].to] = 0;
+                Distance via = links[i].weight + links[j].weight;
+                if (w.dist[links[j].to] > via) {
+                    count++;
+                    if (out) out->push_back({links[i].to, links[j].to, v, via});
+                }
+            }
+        }
+        return count;
+    }
+
+    // Edge difference, plus contracted neighbors and level to spread the
+    // contraction evenly and keep the hierarchy shallow
+    int64_t priority(Witness& w, Index v) const {
+        int64_t difference = static_cast<int64_t>(simulate(w, v, nullptr)) - static_cast<int64_t>(adj[v].size());
+        return 2 * difference + static_cast<int64_t>(contractedNeighbors[v]) + static_cast<int64_t>(level[v]);
+    }
+
+    void addLink(Index u, Index x, Index middle, Distance weight) {
+        for (Link& link : adj[u]) {
+            if (link.to == x) {
+                if (weight < link.weight) link = {x, middle, weight};
+                return;
+            }
+        }
+        adj[u].push_back({x, middle, weight});
+    }
+
+    void removeLink(Index u, Index x) {
+        auto& links = adj[u];
+        for (size_t i = 0; i < links.size(); i++) {
+            if (links[i].to == x) {
+                links[i] = links.back();
+                links.pop_back();
+                return;
+            }
+        }
+    }
+};
+
+} // namespace
+
+template <typename G>
+ContractionHierarchy<G>::Search::Search(Index n) {
+    for (int d = 0; d < 2; d++) {
+        dist[d].assign(n, UNREACHABLE);
+        via[d].resize(n);
+        from[d].resize(n);
+    }
+}
+
+template <typename G>
+ContractionHierarchy<G>::ContractionHierarchy(const G& graph, unsigned threads, bool labels)
+    : vertices(graph.numVertices()) {
+    using Work = Contraction<Index, Distance>;
+    const auto& g = graph.csr();
+    const Index n = vertices;
+    unsigned workers = resolveThreadCount(threads);
+
+    // Overlay graph without self loops, keeping the lightest of parallel edges
+    Work work;
+    work.adj.resize(n);
+    work.excluded.assign(n, 0);
+    work.contractedNeighbors.assign(n, 0);
+    work.level.assign(n, 0);
+    std::vector<uint64_t> slot(n, UINT64_MAX);
+    for (Index u = 0; u < n; u++) {
+        auto& links = work.adj[u];
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index v = g.targets[a];
+            if (g.weights[a] < typename G::Weight(0)) throw std::invalid_argument("ContractionHierarchy: negative edge weight");
+            if (v == u) continue;
+            Distance weight = static_cast<Distance>(g.weights[a]);
+            if (slot[v] < links.size() && links[slot[v]].to == v) {
+                links[slot[v]].weight = std::min(links[slot[v]].weight, weight);
+            } else {
+                slot[v] = links.size();
+                links.push_back({v, NONE, weight});
+            }
+        }
+    }
+    slot.clear();
+    slot.shrink_to_fit();
+
+    std::vector<typename Work::Witness> witnesses(workers);
+    for (auto& w : witnesses) {
+        w.dist.assign(n, Work::INF);
+        w.target.assign(n, 0);
+    }
+
+    // Run fn(witness, i) for i in [0, count) with one witness state per worker
+    auto forEach = [&](size_t count, auto&& fn) {
+        std::atomic<size_t> next(0);
+        unsigned active = static_cast<unsigned>(std::min<size_t>(workers, std::max<size_t>(1, count / 16)));
+        parallelRun(active, [&](unsigned worker) {
+            for (size_t i = next++; i < count; i = next++) fn(witnesses[worker], i);
+        });
+    };
+
+    std::vector<int64_t> priority(n);
+    forEach(n, [&](typename Work::Witness& w, size_t v) { priority[v] = work.priority(w, static_cast<Index>(v)); });
+
+    std::vector<Index> remaining(n);
+    for (Index v = 0; v < n; v++) remaining[v] = v;
+    rank.assign(n, NONE);
+    std::vector<std::vector<typename Work::Link>> upward(n);
+    std::vector<uint8_t> selected(n, 0);
+    std::vector<std::vector<typename Work::Shortcut>> found;
+    Index nextRank = 0;
+
+    while (!remaining.empty()) {
+        // Independent set: vertices ordered before all their remaining neighbors.
+        // Ties go by a hash; by id, a chain of equal vertices would give one per round.
+        auto before = [&](Index a, Index b) {
+            if (priority[a] != priority[b]) return priority[a] < priority[b];
+            uint64_t ha = counterRandom(0, a), hb = counterRandom(0, b);
+            return ha != hb ? ha < hb : a < b;
+        };
+        forEach(remaining.size(), [&](typename Work::Witness&, size_t i) {
+            Index v = remaining[i];
+            bool minimal = true;
+            for (const auto& link : work.adj[v]) {
+                if (!before(v, link.to)) {
+                    minimal = false;
+                    break;
+                }
+            }
+            selected[v] = minimal;
+        });
+        std::vector<Index> round;
+        std::vector<Index> rest;
+        for (Index v : remaining) (selected[v] ? round : rest).push_back(v);
+        remaining.swap(rest);
+
+        for (Index v : round) work.excluded[v] = 1;
+        found.assign(round.size(), {});
+        forEach(round.size(), [&](typename Work::Witness& w, size_t i) { work.simulate(w, round[i], &found[i]); });
+
+        std::vector<Index> affected;
+        for (size_t i = 0; i < round.size(); i++) {
+            Index v = round[i];
+            rank[v] = nextRank++;
+            for (const auto& link : work.adj[v]) {
+                work.removeLink(link.to, v);
+                work.contractedNeighbors[link.to]++;
+                work.level[link.to] = std::max(work.level[link.to], work.level[v] + 1);
+                affected.push_back(link.to);
+            }
+            upward[v] = std::move(work.adj[v]);
+            work.adj[v] = {};
+            work.excluded[v] = 0;
+            selected[v] = 0;
+        }
+        for (const auto& list : found) {
+            for (const auto& shortcut : list) {
+                work.addLink(shortcut.u, shortcut.x, shortcut.middle, shortcut.weight);
+                work.addLink(shortcut.x, shortcut.u, shortcut.middle, shortcut.weight);
+            }
+        }
+
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+        forEach(affected.size(), [&](typename Work::Witness& w, size_t i) {
+            priority[affected[i]] = work.priority(w, affected[i]);
+        });
+    }
+
+    // Flatten the upward arcs in rank order
+    vertexOfRank.assign(n, NONE);
+    for (Index v = 0; v < n; v++) vertexOfRank[rank[v]] = v;
+    offsets.assign(static_cast<size_t>(n) + 1, 0);
+    for (Index r = 0; r < n; r++) offsets[r + 1] = offsets[r] + upward[vertexOfRank[r]].size();
+    arcs.resize(offsets[n]);
+    for (Index r = 0; r < n; r++) {
+        uint64_t a = offsets[r];
+        for (const auto& link : upward[vertexOfRank[r]]) {
+            Index middle = link.middle == NONE ? NONE : rank[link.middle];
+            if (link.middle != NONE) shortcuts++;
+            arcs[a++] = {rank[link.to], middle, link.weight};
+        }
+    }
+    if (labels) buildLabels(workers);
+}
+
+// Labels are built from the top of the hierarchy down. The candidates of a
+// vertex are itself and the labels of its upward neighbors extended by the
+// arc to them; a candidate hub is dropped when another candidate reaches it
+// more cheaply through the hub's own label. Vertices at the same depth below
+// the top read only labels of shallower vertices, so each depth is built in
+// parallel.
+template <typename G>
+void ContractionHierarchy<G>::buildLabels(unsigned workers) {
+    const Index n = vertices;
+    std::vector<Index> depth(n, 0);
+    Index maxDepth = 0;
+    for (Index r = n; r-- > 0;) {
+        for (uint64_t a = offsets[r]; a < offsets[r + 1]; a++) depth[r] = std::max(depth[r], depth[arcs[a].to] + 1);
+        maxDepth = std::max(maxDepth, depth[r]);
+    }
+    std::vector<uint64_t> start(static_cast<size_t>(maxDepth) + 2, 0);
+    for (Index r = 0; r < n; r++) start[depth[r] + 1]++;
+    for (Index d = 0; d <= maxDepth; d++) start[d + 1] += start[d];
+    std::vector<Index> order(n);
+    for (Index r = 0; r < n; r++) order[start[depth[r]]++] = r;
+    for (Index d = maxDepth + 1; d > 0; d--) start[d] = start[d - 1];
+    start[0] = 0;
+
+    struct Candidates {
+        std::vector<Distance> best;
+        std::vector<Index> hubs;
+    };
+    std::vector<Candidates> scratch(n > 0 ? workers : 0);
+    for (auto& c : scratch) c.best.assign(n, UNREACHABLE);
+    std::vector<std::vector<std::pair<Index, Distance>>> label(n);
+
+    auto build = [&](Candidates& c, Index r) {
+        c.best[r] = 0;
+        c.hubs.push_back(r);
+        for (uint64_t a = offsets[r]; a < offsets[r + 1]; a++) {
+            for (const auto& [hub, d] : label[arcs[a].to]) {
+                if (c.best[hub] == UNREACHABLE) c.hubs.push_back(hub);
+                c.best[hub] = std::min(c.best[hub], d + arcs[a].weight);
+            }
+        }
+        std::sort(c.hubs.begin(), c.hubs.end());
+        for (Index hub : c.hubs) {
+            bool covered = false;
+            if (hub != r) {
+                for (const auto& [x, d] : label[hub]) {
+                    if (x != hub && c.best[x] != UNREACHABLE && c.best[x] + d < c.best[hub]) {
+                        covered = true;
+                        break;
+                    }
+                }
+            }
+            if (!covered) label[r].push_back({hub, c.best[hub]});
+        }
+        for (Index hub : c.hubs) c.best[hub] = UNREACHABLE;
+        c.hubs.clear();
+    };
+    for (Index d = 0; d <= maxDepth && n > 0; d++) {
+        const size_t count = start[d + 1] - start[d];
+        std::atomic<size_t> next(0);
+        unsigned active = static_cast<unsigned>(std::min<size_t>(workers, std::max<size_t>(1, count / 16)));
+        parallelRun(active, [&](unsigned worker) {
+            for (size_t i = next++; i < count; i = next++) build(scratch[worker], order[start[d] + i]);
+        });
+    }
+
+    labelOffsets.assign(static_cast<size_t>(n) + 1, 0);
+    for (Index r = 0; r < n; r++) labelOffsets[r + 1] = labelOffsets[r] + label[r].size();
+    labelHubs.resize(labelOffsets[n]);
+    labelDistances.resize(labelOffsets[n]);
+    for (Index r = 0; r < n; r++) {
+        uint64_t i = labelOffsets[r];
+        for (const auto& [hub, d] : label[r]) {
+            labelHubs[i] = hub;
+            labelDistances[i++] = d;
+        }
+        label[r] = {};
+    }
+}
+
+template <typename G>
+typename ContractionHierarchy<G>::Distance ContractionHierarchy<G>::run(Search& search, Index s, Index t,
+                                                                        std::vector<Index>* path) const {
+    auto later = std::greater<std::pair<Distance, Index>>();
+    for (int d = 0; d < 2; d++) {
+        for (Index v : search.touched[d]) search.dist[d][v] = UNREACHABLE;
+        search.touched[d].clear();
+        search.heap[d].clear();
+    }
+    const Index start[2] = {s, t};
+    for (int d = 0; d < 2; d++) {
+        search.dist[d][start[d]] = 0;
+        search.touched[d].push_back(start[d]);
+        search.heap[d].push_back({0, start[d]});
+    }
+
+    Distance best = UNREACHABLE;
+    Index meet = NONE;
+    while (true) {
+        // Advance the direction with the smaller key; a side stops once its key reaches best
+        int d = -1;
+        for (int side = 0; side < 2; side++) {
+            auto& heap = search.heap[side];
+            if (heap.empty() || heap.front().first >= best) continue;
+            if (d < 0 || heap.front().first < search.heap[d].front().first) d = side;
+        }
+        if (d < 0) break;
+
+        auto& heap = search.heap[d];
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto [key, u] = heap.back();
+        heap.pop_back();
+        if (key > search.dist[d][u]) continue;
+        if (search.dist[1 - d][u] != UNREACHABLE && key + search.dist[1 - d][u] < best) {
+            best = key + search.dist[1 - d][u];
+            meet = u;
+        }
+        // Stall on demand: u is reached more cheaply from above, so nothing
+        // it would relax can lie on a shortest path
+        bool stalled = false;
+        for (uint64_t a = offsets[u]; a < offsets[u + 1] && !stalled; a++) {
+            Distance above = search.dist[d][arcs[a].to];
+            stalled = above != UNREACHABLE && above + arcs[a].weight < key;
+        }
+        if (stalled) continue;
+        for (uint64_t a = offsets[u]; a < offsets[u + 1]; a++) {
+            Index v = arcs[a].to;
+            Distance nd = key + arcs[a].weight;
+            if (nd < search.dist[d][v]) {
+                if (search.dist[d][v] == UNREACHABLE) search.touched[d].push_back(v);
+                search.dist[d][v] = nd;
+                search.from[d][v] = u;
+                search.via[d][v] = a;
+                heap.push_back({nd, v});
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+
+    if (path) {
+        path->clear();
+        if (best == UNREACHABLE) return best;
+        // Upward chain s -> meet, then the backward search's chain meet -> t
+        std::vector<Index> chain;
+        for (Index v = meet; v != s; v = search.from[0][v]) chain.push_back(v);
+        path->push_back(s);
+        Index at = s;
+        for (size_t i = chain.size(); i-- > 0;) {
+            unpack(at, chain[i], arcs[search.via[0][chain[i]]].middle, *path);
+            at = chain[i];
+        }
+        for (Index v = meet; v != t; v = search.from[1][v]) {
+            unpack(v, search.from[1][v], arcs[search.via[1][v]].middle, *path);
+        }
+        for (Index& v : *path) v = vertexOfRank[v];
+    }
+    return best;
+}
+
+// Lightest sum over the hubs the two labels share
+template <typename G>
+typename ContractionHierarchy<G>::Distance ContractionHierarchy<G>::labelDistance(Index s, Index t) const {
+    uint64_t i = labelOffsets[s], iEnd = labelOffsets[s + 1];
+    uint64_t j = labelOffsets[t], jEnd = labelOffsets[t + 1];
+    Distance best = UNREACHABLE;
+    while (i < iEnd && j < jEnd) {
+        if (labelHubs[i] < labelHubs[j]) {
+            i++;
+        } else if (labelHubs[j] < labelHubs[i]) {
+            j++;
+        } else {
+            best = std::min(best, labelDistances[i++] + labelDistances[j++]);
+        }
+    }
+    return best;
+}
+
+template <typename G>
+uint64_t ContractionHierarchy<G>::findArc(Index from, Index to) const {
+    for (uint64_t a = offsets[from]; a < offsets[from + 1]; a++) {
+        if (arcs[a].to == to) return a;
+    }
+    throw std::logic_error("ContractionHierarchy: missing arc while unpacking a shortcut");
+}
+
+template <typename G>
+void ContractionHierarchy<G>::unpack(Index from, Index to, Index middle, std::vector<Index>& out) const {
+    // Segments still to expand, the next one on top
+    std::vector<std::pair<std::pair<Index, Index>, Index>> stack{{{from, to}, middle}};
+    while (!stack.empty()) {
+        auto [ends, mid] = stack.back();
+        stack.pop_back();
+        if (mid == NONE) {
+            out.push_back(ends.second);
+            continue;
+        }
+        // Both halves are arcs up from the bypassed vertex
+        stack.push_back({{mid, ends.second}, arcs[findArc(mid, ends.second)].middle});
+        stack.push_back({{ends.first, mid}, arcs[findArc(mid, ends.first)].middle});
+    }
+}
+
+template <typename G>
+typename ContractionHierarchy<G>::Distance ContractionHierarchy<G>::distance(Index s, Index t) const {
+    if (s >= vertices || t >= vertices) throw std::out_of_range("ContractionHierarchy::distance: vertex out of range");
+    if (!labelOffsets.empty()) return labelDistance(rank[s], rank[t]);
+    if (!scratch) scratch.reset(new Search(vertices));
+    return run(*scratch, rank[s], rank[t], nullptr);
+}
+
+template <typename G>
+std::vector<typename G::Index> ContractionHierarchy<G>::path(Index s, Index t) const {
+    if (s >= vertices || t >= vertices) throw std::out_of_range("ContractionHierarchy::path: vertex out of range");
+    if (!scratch) scratch.reset(new Search(vertices));
+    std::vector<Index> result;
+    run(*scratch, rank[s], rank[t], &result);
+    return result;
+}
+
+template <typename G>
+std::vector<typename ContractionHierarchy<G>::Distance> ContractionHierarchy<G>::distanceBatch(
+    const std::vector<Index>& sources, const std::vector<Index>& targets, unsigned threads) const {
+    if (sources.size() != targets.size()) throw std::invalid_argument("distanceBatch: sources and targets differ in length");
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i] >= vertices || targets[i] >= vertices) throw std::out_of_range("distanceBatch: vertex out of range");
+    }
+    std::vector<Distance> distances(sources.size());
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, sources.size() / 64)));
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned) {
+        std::unique_ptr<Search> search;
+        if (labelOffsets.empty()) search.reset(new Search(vertices));
+        for (size_t i = next.fetch_add(64); i < sources.size(); i = next.fetch_add(64)) {
+            for (size_t q = i; q < std::min(sources.size(), i + 64); q++) {
+                Index s = rank[sources[q]], t = rank[targets[q]];
+                distances[q] = search ? run(*search, s, t, nullptr) : labelDistance(s, t);
+            }
+        }
+    });
+    return distances;
+}
+
+template <typename G>
+typename ContractionHierarchy<G>::PathBatch ContractionHierarchy<G>::pathBatch(
+    const std::vector<Index>& sources, const std::vector<Index>& targets, unsigned threads) const {
+    if (sources.size() != targets.size()) throw std::invalid_argument("pathBatch: sources and targets differ in length");
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i] >= vertices || targets[i] >= vertices) throw std::out_of_range("pathBatch: vertex out of range");
+    }
+    PathBatch batch;
+    batch.distances.resize(sources.size());
+    std::vector<std::vector<Index>> paths(sources.size());
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, sources.size() / 64)));
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned) {
+        Search search(vertices);
+        for (size_t i = next++; i < sources.size(); i = next++) {
+            batch.distances[i] = run(search, rank[sources[i]], rank[targets[i]], &paths[i]);
+        }
+    });
+
+    batch.offsets.assign(sources.size() + 1, 0);
+    for (size_t i = 0; i < paths.size(); i++) batch.offsets[i + 1] = batch.offsets[i] + paths[i].size();
+    batch.vertices.reserve(batch.offsets.back());
+    for (const auto& p : paths) batch.vertices.insert(batch.vertices.end(), p.begin(), p.end());
+    return batch;
+}
+
+#define NETSIM_INSTANTIATE_CH(I, W, NAME) template class ContractionHierarchy<BasicGraph<I, W>>;
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_CH)
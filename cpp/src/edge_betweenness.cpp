@@ -0,0 +1,173 @@
+#include "edge_betweenness.h"
+#include "parallel.h"
+#include "rng.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Brandes accumulation from a list of sources; returns per-edge sums of the
+// pair dependencies over ordered pairs (s, t) with s in `sources`
+template <typename G>
+std::vector<double> accumulateSources(const G& graph, const std::vector<typename G::Index>& sources, bool weighted,
+                                      unsigned threads) {
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+    using Entry = std::pair<Distance, Index>;
+    const Distance INF = std::numeric_limits<Distance>::max();
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    const size_t m = graph.numEdges();
+    auto later = std::greater<Entry>();
+
+    if (weighted) {
+        for (size_t a = 0; a < g.weights.size(); a++) {
+            if (!(g.weights[a] > typename G::Weight(0))) throw std::invalid_argument("edgeBetweenness: weights must be positive");
+        }
+    }
+
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, sources.size())));
+    std::vector<std::vector<double>> partial(workers);
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned worker) {
+        std::vector<double>& acc = partial[worker];
+        acc.assign(m, 0.0);
+        std::vector<Distance> dist(n, INF);
+        std::vector<double> sigma(n, 0.0), delta(n, 0.0);
+        std::vector<Index> order;          // Vertices in non-decreasing distance
+        std::vector<Entry> heap;
+
+        for (size_t i = next++; i < sources.size(); i = next++) {
+            Index s = sources[i];
+            dist[s] = 0;
+            sigma[s] = 1.0;
+            order.clear();
+            if (weighted) {
+                heap.assign(1, {0, s});
+                while (!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), later);
+                    Entry top = heap.back();
+                    heap.pop_back();
+                    Index u = top.second;
+                    if (top.first > dist[u]) continue;
+                    order.push_back(u);
+                    for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                        Index v = g.targets[a];
+                        Distance nd = top.first + g.weights[a];
+                        if (nd < dist[v]) {
+                            dist[v] = nd;
+                            sigma[v] = sigma[u];
+                            heap.push_back({nd, v});
+                            std::push_heap(heap.begin(), heap.end(), later);
+                        } else if (nd == dist[v]) {
+                            sigma[v] += sigma[u];
+                        }
+                    }
+                }
+            } else {
+                // `order` doubles as the BFS queue
+                order.push_back(s);
+                for (size_t head = 0; head < order.size(); head++) {
+                    Index u = order[head];
+                    for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                        Index v = g.targets[a];
+                        if (dist[v] == INF) {
+                            dist[v] = dist[u] + 1;
+                            order.push_back(v);
+                        }
+                        if (dist[v] == dist[u] + 1) sigma[v] += sigma[u];
+                    }
+                }
+            }
+
+            // Dependencies flow back from the farthest vertices; predecessors
+            // are found again from the distances instead of being stored
+            for (size_t k = order.size(); k-- > 0;) {
+                Index w = order[k];
+                double share = (1.0 + delta[w]) / sigma[w];
+                for (uint64_t a = g.offsets[w]; a < g.offsets[w + 1]; a++) {
+                    Index v = g.targets[a];
+                    if (dist[v] == INF || dist[v] + (weighted ? Distance(g.weights[a]) : Distance(1)) != dist[w]) continue;
+                    double c = sigma[v] * share;
+                    acc[g.edgeIds[a]] += c;
+                    delta[v] += c;
+                }
+            }
+            for (Index v : order) {
+                dist[v] = INF;
+                sigma[v] = 0.0;
+                delta[v] = 0.0;
+            }
+        }
+    });
+
+    std::vector<double> total = std::move(partial[0]);
+    parallelFor(0, m, threads, [&](size_t e) {
+        for (unsigned w = 1; w < workers; w++) total[e] += partial[w][e];
+    }, 4096);
+    return total;
+}
+
+} // namespace
+
+template <typename G>
+EdgeBetweenness<G> edgeBetweenness(const G& graph, bool weighted, unsigned threads) {
+    using Index = typename G::Index;
+    std::vector<Index> sources(graph.numVertices());
+    for (Index v = 0; v < graph.numVertices(); v++) sources[v] = v;
+
+    EdgeBetweenness<G> result;
+    result.centrality = accumulateSources(graph, sources, weighted, threads);
+    // Every unordered pair was counted from both ends
+    for (double& c : result.centrality) c *= 0.5;
+    result.sources = graph.numVertices();
+    return result;
+}
+
+template <typename G>
+EdgeBetweenness<G> edgeBetweennessSampled(const G& graph, typename G::Index samples, double delta, uint64_t seed,
+                                          bool weighted, unsigned threads) {
+    using Index = typename G::Index;
+    const Index n = graph.numVertices();
+    if (samples == 0) throw std::invalid_argument("edgeBetweennessSampled: samples must be positive");
+    if (!(delta > 0.0 && delta < 1.0)) throw std::invalid_argument("edgeBetweennessSampled: delta must be in (0, 1)");
+    if (samples >= n) return edgeBetweenness(graph, weighted, threads);
+
+    // Distinct pivots by a partial Fisher-Yates shuffle
+    std::vector<Index> pool(n);
+    for (Index v = 0; v < n; v++) pool[v] = v;
+    Xoshiro256pp rng(seed);
+    for (Index i = 0; i < samples; i++) std::swap(pool[i], pool[i + rng.below(n - i)]);
+    pool.resize(samples);
+
+    EdgeBetweenness<G> result;
+    result.centrality = accumulateSources(graph, pool, weighted, threads);
+    const double scale = 0.5 * static_cast<double>(n) / samples;
+    for (double& c : result.centrality) c *= scale;
+    result.sources = samples;
+
+    // A source's dependency on an edge is at most n - 1, so the normalized
+    // per-pivot values lie in [0, 1]; Hoeffding's bound also holds when
+    // sampling without replacement
+    const double m = static_cast<double>(std::max<uint64_t>(1, graph.numEdges()));
+    const double epsilon = std::sqrt(std::log(2.0 * m / delta) / (2.0 * samples));
+    result.errorBound = epsilon * 0.5 * static_cast<double>(n) * static_cast<double>(n - 1);
+    return result;
+}
+
+uint64_t betweennessSamples(uint64_t edges, double epsilon, double delta) {
+    if (!(epsilon > 0.0)) throw std::invalid_argument("betweennessSamples: epsilon must be positive");
+    if (!(delta > 0.0 && delta < 1.0)) throw std::invalid_argument("betweennessSamples: delta must be in (0, 1)");
+    const double m = static_cast<double>(std::max<uint64_t>(1, edges));
+    return static_cast<uint64_t>(std::ceil(std::log(2.0 * m / delta) / (2.0 * epsilon * epsilon)));
+}
+
+#define NETSIM_INSTANTIATE_BETWEENNESS(I, W, NAME)                                                         \
+    template EdgeBetweenness<BasicGraph<I, W>> edgeBetweenness(const BasicGraph<I, W>&, bool, unsigned);   \
+    template EdgeBetweenness<BasicGraph<I, W>> edgeBetweennessSampled(const BasicGraph<I, W>&, I, double,  \
+                                                                      uint64_t, bool, unsigned);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_BETWEENNESS)
@@ -0,0 +1,285 @@
+#include "external_mst.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Smallest read/write buffer per open file
+constexpr uint64_t MIN_BUFFER_BYTES = uint64_t(1) << 20;
+
+template <typename G>
+bool lighter(const typename G::Edge& a, const typename G::Edge& b) {
+    if (a.weight != b.weight) return a.weight < b.weight;
+    return a.u != b.u ? a.u < b.u : a.v < b.v;
+}
+
+template <typename G>
+void encodeEdge(const typename G::Edge& edge, uint8_t* out) {
+    using Index = typename G::Index;
+    std::memcpy(out, &edge.u, sizeof(Index));
+    std::memcpy(out + sizeof(Index), &edge.v, sizeof(Index));
+    std::memcpy(out + 2 * sizeof(Index), &edge.weight, sizeof(typename G::Weight));
+}
+
+template <typename G>
+void decodeEdge(const uint8_t* in, typename G::Edge& edge) {
+    using Index = typename G::Index;
+    std::memcpy(&edge.u, in, sizeof(Index));
+    std::memcpy(&edge.v, in + sizeof(Index), sizeof(Index));
+    std::memcpy(&edge.weight, in + 2 * sizeof(Index), sizeof(typename G::Weight));
+}
+
+// Buffered sequential reader of an edge file
+template <typename G>
+class EdgeReader {
+public:
+    EdgeReader(const std::string& path, uint64_t bufferBytes) : path(path) {
+        file = std::fopen(path.c_str(), "rb");
+        if (!file) throw std::runtime_error("externalMST: cannot open " + path);
+        buffer.resize(std::max<uint64_t>(1, bufferBytes / RECORD) * RECORD);
+        std::fseek(file, 0, SEEK_END);
+        records = static_cast<uint64_t>(std::ftell(file)) / RECORD;
+        std::fseek(file, 0, SEEK_SET);
+    }
+    ~EdgeReader() {
+        if (file) std::fclose(file);
+    }
+    EdgeReader(const EdgeReader&) = delete;
+    EdgeReader& operator=(const EdgeReader&) = delete;
+
+    uint64_t size() const { return records; }
+
+    bool next(typename G::Edge& edge) {
+        if (pos == length && !refill()) return false;
+        decodeEdge<G>(buffer.data() + pos, edge);
+        pos += RECORD;
+        return true;
+    }
+
+    // Append up to `count` edges; false once the file is exhausted
+    bool read(std::vector<typename G::Edge>& out, uint64_t count) {
+        typename G::Edge edge;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!next(edge)) return false;
+            out.push_back(edge);
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t RECORD = edgeRecordBytes<G>();
+
+    std::string path;
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> buffer;
+    size_t pos = 0, length = 0;
+    uint64_t records = 0;
+
+    bool refill() {
+        length = std::fread(buffer.data(), 1, buffer.size(), file);
+        pos = 0;
+        if (length % RECORD != 0) throw std::runtime_error("externalMST: truncated edge record in " + path);
+        return length > 0;
+    }
+};
+
+// Buffered sequential writer of an edge file
+template <typename G>
+class EdgeWriter {
+public:
+    EdgeWriter(const std::string& path, uint64_t bufferBytes) : path(path) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("externalMST: cannot create " + path);
+        buffer.resize(std::max<uint64_t>(1, bufferBytes / RECORD) * RECORD);
+    }
+    ~EdgeWriter() {
+        if (file) std::fclose(file);
+    }
+    EdgeWriter(const EdgeWriter&) = delete;
+    EdgeWriter& operator=(const EdgeWriter&) = delete;
+
+    void write(const typename G::Edge& edge) {
+        if (pos == buffer.size()) flush();
+        encodeEdge<G>(edge, buffer.data() + pos);
+        pos += RECORD;
+    }
+
+    void close() {
+        flush();
+        std::FILE* f = file;
+        file = nullptr;
+        if (std::fclose(f) != 0) throw std::runtime_error("externalMST: write failed: " + path);
+    }
+
+private:
+    static constexpr size_t RECORD = edgeRecordBytes<G>();
+
+    std::string path;
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> buffer;
+    size_t pos = 0;
+
+    void flush() {
+        if (pos && std::fwrite(buffer.data(), 1, pos, file) != pos) {
+            throw std::runtime_error("externalMST: write failed: " + path);
+        }
+        pos = 0;
+    }
+};
+
+// Temporary run files, removed however the computation ends
+struct RunFiles {
+    std::vector<std::string> paths;
+    ~RunFiles() {
+        for (const auto& path : paths) std::remove(path.c_str());
+    }
+};
+
+// Sort blocks on separate threads, then merge neighbouring blocks pairwise
+template <typename T, typename Less>
+void parallelSort(std::vector<T>& values, unsigned threads, Less less) {
+    const size_t blocks = std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, values.size() / 65536));
+    std::vector<size_t> bounds(blocks + 1);
+    for (size_t b = 0; b <= blocks; b++) bounds[b] = values.size() * b / blocks;
+    parallelFor(0, blocks, threads, [&](size_t b) {
+        std::sort(values.begin() + bounds[b], values.begin() + bounds[b + 1], less);
+    });
+    for (size_t width = 1; width < blocks; width *= 2) {
+        parallelFor(0, (blocks + 2 * width - 1) / (2 * width), threads, [&](size_t pair) {
+            size_t first = pair * 2 * width;
+            size_t middle = std::min(blocks, first + width);
+            size_t last = std::min(blocks, first + 2 * width);
+            std::inplace_merge(values.begin() + bounds[first], values.begin() + bounds[middle],
+                               values.begin() + bounds[last], less);
+        });
+    }
+}
+
+// Run files are named after the tree file, in tempDir or next to it
+std::string runPrefix(const std::string& treeFile, const std::string& tempDir) {
+    size_t slash = treeFile.find_last_of('/');
+    std::string name = slash == std::string::npos ? treeFile : treeFile.substr(slash + 1);
+    if (!tempDir.empty()) return tempDir + "/" + name + ".run";
+    return treeFile + ".run";
+}
+
+} // namespace
+
+template <typename G>
+void writeEdgeFile(const G& graph, const std::string& path) {
+    EdgeWriter<G> out(path, uint64_t(1) << 22);
+    for (const auto& edge : graph.edgeList()) out.write(edge);
+    out.close();
+}
+
+template <typename G>
+ExternalMstStats<G> externalMST(const std::string& edgeFile, typename G::Index vertices, const std::string& treeFile,
+                                uint64_t memoryBytes, const std::string& tempDir, unsigned threads) {
+    using Index = typename G::Index;
+    using Edge = typename G::Edge;
+    constexpr size_t RECORD = edgeRecordBytes<G>();
+    const uint64_t blockEdges = std::max<uint64_t>(1024, memoryBytes / sizeof(Edge));
+    auto less = [](const Edge& a, const Edge& b) { return lighter<G>(a, b); };
+
+    ExternalMstStats<G> stats;
+    UnionFind<Index> forest(vertices);
+    RunFiles runs;
+    std::vector<Edge> block;
+    std::vector<Edge> kept;
+
+    // Sorted runs, each reduced to the spanning forest of its block
+    {
+        EdgeReader<G> in(edgeFile, std::max(MIN_BUFFER_BYTES, std::min<uint64_t>(memoryBytes / 8, uint64_t(1) << 26)));
+        bool more = true;
+        while (more) {
+            block.clear();
+            block.reserve(std::min(blockEdges, in.size() - stats.inputEdges));
+            more = in.read(block, blockEdges);
+            stats.inputEdges += block.size();
+            if (block.empty() && stats.runs > 0) break;
+            for (const Edge& e : block) {
+                if (e.u >= vertices || e.v >= vertices) throw std::out_of_range("externalMST: vertex out of range in " + edgeFile);
+            }
+            block.erase(std::remove_if(block.begin(), block.end(), [](const Edge& e) { return e.u == e.v; }), block.end());
+            parallelSort(block, threads, less);
+
+            forest.reset(vertices);
+            kept.clear();
+            for (const Edge& e : block) {
+                if (forest.unite(e.u, e.v)) kept.push_back(e);
+            }
+            std::vector<Edge>().swap(block);
+
+            if (!more && stats.runs == 0) {
+                // The whole input was one block: its forest is the answer
+                EdgeWriter<G> out(treeFile, std::max(MIN_BUFFER_BYTES, uint64_t(1) << 22));
+                for (const Edge& e : kept) {
+                    out.write(e);
+                    stats.weight += e.weight;
+                }
+                out.close();
+                stats.runEdges = stats.treeEdges = kept.size();
+                stats.components = vertices - stats.treeEdges;
+                return stats;
+            }
+
+            runs.paths.push_back(runPrefix(treeFile, tempDir) + std::to_string(stats.runs));
+            EdgeWriter<G> out(runs.paths.back(), std::max(MIN_BUFFER_BYTES, uint64_t(1) << 22));
+            for (const Edge& e : kept) out.write(e);
+            out.close();
+            stats.runs++;
+            stats.runEdges += kept.size();
+        }
+    }
+    std::vector<Edge>().swap(kept);
+
+    // k-way merge of the runs straight into Kruskal's scan
+    const uint64_t buffer = std::max(MIN_BUFFER_BYTES, memoryBytes / (runs.paths.size() + 1) / RECORD * RECORD);
+    std::vector<std::unique_ptr<EdgeReader<G>>> readers;
+    using Head = std::pair<Edge, size_t>;
+    auto later = [](const Head& a, const Head& b) {
+        return lighter<G>(b.first, a.first) || (!lighter<G>(a.first, b.first) && a.second > b.second);
+    };
+    std::vector<Head> heads;
+    for (size_t r = 0; r < runs.paths.size(); r++) {
+        readers.emplace_back(new EdgeReader<G>(runs.paths[r], buffer));
+        Edge e;
+        if (readers[r]->next(e)) heads.push_back({e, r});
+    }
+    std::make_heap(heads.begin(), heads.end(), later);
+
+    forest.reset(vertices);
+    EdgeWriter<G> out(treeFile, buffer);
+    const uint64_t complete = vertices > 0 ? vertices - 1 : 0;
+    while (!heads.empty() && stats.treeEdges < complete) {
+        std::pop_heap(heads.begin(), heads.end(), later);
+        Head head = heads.back();
+        heads.pop_back();
+        if (forest.unite(head.first.u, head.first.v)) {
+            out.write(head.first);
+            stats.weight += head.first.weight;
+            stats.treeEdges++;
+        }
+        if (readers[head.second]->next(head.first)) {
+            heads.push_back(head);
+            std::push_heap(heads.begin(), heads.end(), later);
+        }
+    }
+    out.close();
+    stats.components = vertices - stats.treeEdges;
+    return stats;
+}
+
+#define NETSIM_INSTANTIATE_EXTERNAL_MST(I, W, NAME)                                                           \
+    template void writeEdgeFile(const BasicGraph<I, W>&, const std::string&);                                 \
+    template ExternalMstStats<BasicGraph<I, W>> externalMST<BasicGraph<I, W>>(const std::string&, I,          \
+        const std::string&, uint64_t, const std::string&, unsigned);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_EXTERNAL_MST)
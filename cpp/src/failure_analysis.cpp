@@ -0,0 +1,375 @@
+#include "failure_analysis.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Per-worker sums for the stretch columns
+struct StretchTotals {
+    std::vector<uint64_t> affected, disconnected;
+    std::vector<uint64_t> lostPositive, stretchedPositive; // Same, restricted to pairs at distance > 0
+    std::vector<double> sum, max;
+
+    explicit StretchTotals(size_t rows)
+        : affected(rows, 0), disconnected(rows, 0), lostPositive(rows, 0), stretchedPositive(rows, 0),
+          sum(rows, 0.0), max(rows, 1.0) {}
+};
+
+} // namespace
+
+template <typename G>
+FailureAnalysis<G>::FailureAnalysis(const G& graph, unsigned threads)
+    : graph(graph), threads(threads), edges(graph.edgeList()) {
+    const Index n = graph.numVertices();
+    for (const auto& e : edges) {
+        if (e.weight < typename G::Weight(0)) throw std::invalid_argument("FailureAnalysis: negative edge weight");
+    }
+
+    // Kruskal; ties broken by edge id so the forest is deterministic
+    std::vector<Index> byWeight(edges.size());
+    for (size_t i = 0; i < edges.size(); i++) byWeight[i] = static_cast<Index>(i);
+    std::sort(byWeight.begin(), byWeight.end(), [&](Index a, Index b) {
+        return edges[a].weight != edges[b].weight ? edges[a].weight < edges[b].weight : a < b;
+    });
+    inTree.assign(edges.size(), false);
+    UnionFind<Index> sets(n);
+    for (Index e : byWeight) {
+        if (sets.unite(edges[e].u, edges[e].v)) {
+            inTree[e] = true;
+            baseWeight += edges[e].weight;
+        } else if (edges[e].u != edges[e].v) {
+            nonTree.push_back(e);
+        }
+    }
+
+    // Forest adjacency, then an iterative DFS for parents and preorder intervals
+    std::vector<uint64_t> offsets(static_cast<size_t>(n) + 1, 0);
+    for (size_t e = 0; e < edges.size(); e++) {
+        if (!inTree[e]) continue;
+        offsets[edges[e].u + 1]++;
+        offsets[edges[e].v + 1]++;
+    }
+    for (Index v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+    std::vector<Index> treeEdges(offsets[n]);
+    std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t e = 0; e < edges.size(); e++) {
+        if (!inTree[e]) continue;
+        treeEdges[fill[edges[e].u]++] = static_cast<Index>(e);
+        treeEdges[fill[edges[e].v]++] = static_cast<Index>(e);
+    }
+
+    parent.assign(n, NONE);
+    parentEdge.assign(n, NONE);
+    depth.assign(n, 0);
+    enter.assign(n, NONE);
+    leave.assign(n, 0);
+    Index clock = 0;
+    std::vector<std::pair<Index, uint64_t>> stack; // Vertex and its next tree arc
+    for (Index root = 0; root < n; root++) {
+        if (enter[root] != NONE) continue;
+        enter[root] = clock++;
+        stack.push_back({root, offsets[root]});
+        while (!stack.empty()) {
+            auto& top = stack.back();
+            Index u = top.first;
+            if (top.second == offsets[u + 1]) {
+                leave[u] = clock;
+                stack.pop_back();
+                continue;
+            }
+            Index e = treeEdges[top.second++];
+            Index v = edges[e].u == u ? edges[e].v : edges[e].u;
+            if (e == parentEdge[u]) continue;
+            parent[v] = u;
+            parentEdge[v] = e;
+            depth[v] = depth[u] + 1;
+            enter[v] = clock++;
+            stack.push_back({v, offsets[v]});
+        }
+    }
+}
+
+template <typename G>
+FailureTable<G> FailureAnalysis<G>::linkFailures(bool stretch) const {
+    const size_t m = edges.size();
+    FailureTable<G> table;
+    table.mstDelta.assign(m, 0);
+    table.mstSplits.assign(m, 0);
+    table.replacement.assign(m, NONE);
+
+    // Non-tree edges in ascending weight claim the still unclaimed tree edges
+    // on their tree path; `up` skips over claimed edges (path compression)
+    std::vector<Index> up(graph.numVertices());
+    for (Index v = 0; v < graph.numVertices(); v++) up[v] = v;
+    auto top = [&](Index v) {
+        Index root = v;
+        while (up[root] != root) root = up[root];
+        while (up[v] != root) {
+            Index next = up[v];
+            up[v] = root;
+            v = next;
+        }
+        return root;
+    };
+    for (Index e : nonTree) {
+        Index x = top(edges[e].u);
+        Index y = top(edges[e].v);
+        while (x != y) {
+            if (depth[x] < depth[y]) std::swap(x, y);
+            table.replacement[parentEdge[x]] = e;
+            up[x] = parent[x];
+            x = top(x);
+        }
+    }
+
+    for (size_t e = 0; e < m; e++) {
+        if (!inTree[e]) continue;
+        Index r = table.replacement[e];
+        if (r != NONE) {
+            table.mstDelta[e] = static_cast<Distance>(edges[r].weight) - static_cast<Distance>(edges[e].weight);
+        } else {
+            table.mstDelta[e] = -static_cast<Distance>(edges[e].weight);
+            table.mstSplits[e] = 1;
+        }
+    }
+
+    if (stretch) stretchImpact(table, false);
+    return table;
+}
+
+template <typename G>
+FailureTable<G> FailureAnalysis<G>::nodeFailures(bool stretch) const {
+    const Index n = graph.numVertices();
+    FailureTable<G> table;
+    table.mstDelta.assign(n, 0);
+    table.mstSplits.assign(n, 0);
+    table.replacement.assign(n, NONE);
+
+    // Tree children of each vertex, in preorder
+    std::vector<uint64_t> childOffsets(static_cast<size_t>(n) + 1, 0);
+    for (Index v = 0; v < n; v++) {
+        if (parent[v] != NONE) childOffsets[parent[v] + 1]++;
+    }
+    for (Index v = 0; v < n; v++) childOffsets[v + 1] += childOffsets[v];
+    std::vector<Index> children(childOffsets[n]);
+    {
+        std::vector<Index> byEnter(n);
+        for (Index v = 0; v < n; v++) byEnter[enter[v]] = v;
+        std::vector<uint64_t> fill(childOffsets.begin(), childOffsets.end() - 1);
+        for (Index v : byEnter) {
+            if (parent[v] != NONE) children[fill[parent[v]]++] = v;
+        }
+    }
+
+    // Removing v splits its tree into the child subtrees and the part above v;
+    // non-tree edges in weight order reconnect them (Kruskal on the pieces)
+    parallelFor(0, n, threads, [&](size_t i) {
+        Index v = static_cast<Index>(i);
+        const Index* first = children.data() + childOffsets[v];
+        const Index* last = children.data() + childOffsets[v + 1];
+        Distance lost = 0;
+        for (const Index* c = first; c != last; c++) lost += edges[parentEdge[*c]].weight;
+        if (parent[v] != NONE) lost += edges[parentEdge[v]].weight;
+
+        Index pieces = static_cast<Index>(last - first) + (parent[v] != NONE ? 1 : 0);
+        table.mstDelta[v] = -lost;
+        if (pieces <= 1) return;
+
+        // Piece 0 is everything outside v's subtree, piece k + 1 the subtree of child k
+        auto piece = [&](Index x) -> Index {
+            if (enter[x] < enter[v] || enter[x] >= leave[v]) return 0;
+            const Index* c = std::upper_bound(first, last, x, [&](Index a, Index b) { return enter[a] < enter[b]; });
+            return static_cast<Index>(c - first);
+        };
+        UnionFind<Index> sets(static_cast<size_t>(last - first) + 1);
+        Index joins = 0;
+        for (Index e : nonTree) {
+            if (edges[e].u == v || edges[e].v == v) continue;
+            Index a = piece(edges[e].u), b = piece(edges[e].v);
+            if (a != b && sets.unite(a, b)) {
+                table.mstDelta[v] += edges[e].weight;
+                if (++joins == pieces - 1) break;
+            }
+        }
+        table.mstSplits[v] = pieces - 1 - joins;
+    }, 16);
+
+    if (stretch) stretchImpact(table, true);
+    return table;
+}
+
+template <typename G>
+void FailureAnalysis<G>::stretchImpact(FailureTable<G>& table, bool nodes) const {
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    const size_t rows = nodes ? n : edges.size();
+    const Distance INF = std::numeric_limits<Distance>::max();
+    using Entry = std::pair<Distance, Index>;
+    auto later = std::greater<Entry>();
+
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<Index>(1, n)));
+    std::vector<StretchTotals> totals;
+    for (unsigned w = 0; w < workers; w++) totals.emplace_back(rows);
+    std::vector<uint64_t> reach(n, 0);     // Pairs (s, t) at distance > 0 for each source s
+    std::atomic<size_t> next(0);
+
+    parallelRun(workers, [&](unsigned worker) {
+        StretchTotals& total = totals[worker];
+        std::vector<Distance> dist(n, INF), detour(n, INF);
+        std::vector<Index> via(n, NONE);   // Tree parent in the shortest path tree
+        std::vector<Index> viaEdge(n, NONE);
+        std::vector<Index> pre(n, NONE), size(n, 0), order;
+        std::vector<uint64_t> childOffsets(static_cast<size_t>(n) + 1), cursor;
+        std::vector<Index> children;
+        std::vector<Entry> heap;
+        std::vector<std::pair<Index, uint64_t>> stack;
+
+        for (size_t next_s = next++; next_s < n; next_s = next++) {
+            Index s = static_cast<Index>(next_s);
+            // Baseline shortest path tree from s
+            std::fill(dist.begin(), dist.end(), INF);
+            std::fill(via.begin(), via.end(), NONE);
+            dist[s] = 0;
+            heap.assign(1, {0, s});
+            while (!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), later);
+                Entry top = heap.back();
+                heap.pop_back();
+                Index u = top.second;
+                if (top.first > dist[u]) continue;
+                for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                    Index v = g.targets[a];
+                    Distance nd = top.first + g.weights[a];
+                    if (nd < dist[v]) {
+                        dist[v] = nd;
+                        via[v] = u;
+                        viaEdge[v] = g.edgeIds[a];
+                        heap.push_back({nd, v});
+                        std::push_heap(heap.begin(), heap.end(), later);
+                    }
+                }
+            }
+
+            // Preorder of the tree so every subtree is a contiguous range
+            std::fill(childOffsets.begin(), childOffsets.end(), 0);
+            for (Index v = 0; v < n; v++) {
+                if (via[v] != NONE) childOffsets[via[v] + 1]++;
+                if (v != s && dist[v] != INF && dist[v] > 0) reach[s]++;
+            }
+            for (Index v = 0; v < n; v++) childOffsets[v + 1] += childOffsets[v];
+            children.resize(childOffsets[n]);
+            cursor.assign(childOffsets.begin(), childOffsets.end() - 1);
+            for (Index v = 0; v < n; v++) {
+                if (via[v] != NONE) children[cursor[via[v]]++] = v;
+            }
+            std::fill(pre.begin(), pre.end(), NONE);
+            order.clear();
+            stack.assign(1, {s, childOffsets[s]});
+            pre[s] = 0;
+            order.push_back(s);
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                if (top.second == childOffsets[top.first + 1]) {
+                    size[top.first] = static_cast<Index>(order.size()) - pre[top.first];
+                    stack.pop_back();
+                    continue;
+                }
+                Index c = children[top.second++];
+                pre[c] = static_cast<Index>(order.size());
+                order.push_back(c);
+                stack.push_back({c, childOffsets[c]});
+            }
+
+            // Re-solve the vertices below each failure, entering from outside it
+            for (Index c : order) {
+                if (c == s) continue;
+                Index begin = nodes ? pre[c] + 1 : pre[c];
+                Index end = pre[c] + size[c];
+                if (begin == end) continue;
+                Index failedEdge = nodes ? NONE : viaEdge[c];
+                Index failedVertex = nodes ? c : NONE;
+                auto inside = [&](Index x) { return pre[x] != NONE && pre[x] >= begin && pre[x] < end; };
+
+                heap.clear();
+                for (Index i = begin; i < end; i++) {
+                    Index x = order[i];
+                    Distance best = INF;
+                    for (uint64_t a = g.offsets[x]; a < g.offsets[x + 1]; a++) {
+                        Index y = g.targets[a];
+                        if (y == failedVertex || g.edgeIds[a] == failedEdge || dist[y] == INF || inside(y)) continue;
+                        best = std::min(best, dist[y] + g.weights[a]);
+                    }
+                    detour[x] = best;
+                    if (best != INF) heap.push_back({best, x});
+                }
+                std::make_heap(heap.begin(), heap.end(), later);
+                while (!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), later);
+                    Entry top = heap.back();
+                    heap.pop_back();
+                    Index u = top.second;
+                    if (top.first > detour[u]) continue;
+                    for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                        Index v = g.targets[a];
+                        if (!inside(v) || g.edgeIds[a] == failedEdge) continue;
+                        Distance nd = top.first + g.weights[a];
+                        if (nd < detour[v]) {
+                            detour[v] = nd;
+                            heap.push_back({nd, v});
+                            std::push_heap(heap.begin(), heap.end(), later);
+                        }
+                    }
+                }
+
+                size_t row = nodes ? c : viaEdge[c];
+                for (Index i = begin; i < end; i++) {
+                    Index x = order[i];
+                    if (detour[x] == INF) {
+                        total.disconnected[row]++;
+                        if (dist[x] > 0) total.lostPositive[row]++;
+                    } else if (detour[x] > dist[x]) {
+                        total.affected[row]++;
+                        if (dist[x] > 0) {
+                            double ratio = static_cast<double>(detour[x]) / static_cast<double>(dist[x]);
+                            total.stretchedPositive[row]++;
+                            total.sum[row] += ratio;
+                            total.max[row] = std::max(total.max[row], ratio);
+                        }
+                    }
+                    detour[x] = INF;
+                }
+            }
+        }
+    });
+
+    uint64_t pairs = 0;
+    for (uint64_t r : reach) pairs += r;
+    table.affectedPairs.assign(rows, 0);
+    table.disconnectedPairs.assign(rows, 0);
+    table.meanStretch.assign(rows, 1.0);
+    table.maxStretch.assign(rows, 1.0);
+    for (size_t row = 0; row < rows; row++) {
+        uint64_t lost = 0, stretched = 0;
+        double sum = 0;
+        for (const auto& total : totals) {
+            table.affectedPairs[row] += total.affected[row];
+            table.disconnectedPairs[row] += total.disconnected[row];
+            table.maxStretch[row] = std::max(table.maxStretch[row], total.max[row]);
+            lost += total.lostPositive[row];
+            stretched += total.stretchedPositive[row];
+            sum += total.sum[row];
+        }
+        // Unaffected pairs keep stretch 1; pairs from or to a failed vertex do not count
+        uint64_t base = nodes ? pairs - 2 * reach[row] : pairs;
+        uint64_t connected = base - lost;
+        if (connected > 0) table.meanStretch[row] = (static_cast<double>(connected - stretched) + sum) / connected;
+    }
+}
+
+#define NETSIM_INSTANTIATE_FAILURE(I, W, NAME) template class FailureAnalysis<BasicGraph<I, W>>;
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_FAILURE)
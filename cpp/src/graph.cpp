@@ -1,35 +1,195 @@
 #include "graph.h"
+#include "parallel.h"
 #include <queue>
 #include <vector>
-#include <climits>
+#include <limits>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
 
-Graph::Graph(int vertices) : vertices(vertices) {
-    adjList.resize(vertices);
+// Below this many pending edges the CSR merge runs on the calling thread
+constexpr size_t PARALLEL_MERGE_THRESHOLD = 1 << 16;
+
+template <typename I, typename W>
+BasicGraph<I, W>::BasicGraph(Index vertices) : vertices(vertices) {
+    if (vertices == NO_VERTEX) throw std::invalid_argument("Graph: too many vertices for the index type");
+    adjacency.offsets.assign(static_cast<size_t>(vertices) + 1, 0);
+}
+
+template <typename I, typename W>
+BasicGraph<I, W>::BasicGraph(Index vertices, std::vector<Edge> edges) : BasicGraph(vertices) {
+    for (const Edge& e : edges) {
+        if (e.u >= vertices || e.v >= vertices) {
+            throw std::out_of_range("Graph: edge endpoint out of range");
+        }
+    }
+    pending = std::move(edges);
+}
+
+template <typename I, typename W>
+BasicGraph<I, W>::BasicGraph(Index vertices, CSR arrays) : vertices(vertices), adjacency(std::move(arrays)) {
+    if (vertices == NO_VERTEX) throw std::invalid_argument("Graph: too many vertices for the index type");
+    if (adjacency.offsets.size() != static_cast<size_t>(vertices) + 1 ||
+        adjacency.offsets[vertices] != adjacency.targets.size() ||
+        adjacency.weights.size() != adjacency.targets.size() ||
+        adjacency.edgeIds.size() != adjacency.targets.size() ||
+        adjacency.targets.size() % 2 != 0) {
+        throw std::invalid_argument("Graph: inconsistent CSR arrays");
+    }
+}
+
+template <typename I, typename W>
+void BasicGraph<I, W>::addEdge(Index u, Index v, Weight weight) {
+    if (u >= vertices || v >= vertices) {
+        throw std::out_of_range("Graph::addEdge: vertex out of range");
+    }
+    std::lock_guard<std::mutex> lock(merging.mutex);
+    pending.push_back({u, v, weight}); // Undirected graph, both arcs are created on merge
+}
+
+template <typename I, typename W>
+void BasicGraph<I, W>::addEdges(const std::vector<Edge>& edges) {
+    for (const Edge& e : edges) {
+        if (e.u >= vertices || e.v >= vertices) {
+            throw std::out_of_range("Graph::addEdges: vertex out of range");
+        }
+    }
+    std::lock_guard<std::mutex> lock(merging.mutex);
+    pending.insert(pending.end(), edges.begin(), edges.end());
 }
 
-void Graph::addEdge(int u, int v, int weight) {
-    adjList[u].push_back({v, weight});
-    adjList[v].push_back({u, weight}); // Undirected graph
+template <typename I, typename W>
+uint64_t BasicGraph<I, W>::numEdges() const {
+    std::lock_guard<std::mutex> lock(merging.mutex);
+    return adjacency.targets.size() / 2 + pending.size();
 }
 
-std::vector<std::pair<int, int>> Graph::primMST() {
-    std::vector<int> key(vertices, INT_MAX);
-    std::vector<int> parent(vertices, -1);
+template <typename I, typename W>
+const typename BasicGraph<I, W>::CSR& BasicGraph<I, W>::csr() const {
+    std::lock_guard<std::mutex> lock(merging.mutex);
+    if (pending.empty()) return adjacency;
+
+    const uint64_t oldEdges = adjacency.targets.size() / 2;
+    if (oldEdges + pending.size() > static_cast<uint64_t>(NO_VERTEX)) {
+        throw std::length_error("Graph: too many edges for the index type");
+    }
+    unsigned threads = pending.size() >= PARALLEL_MERGE_THRESHOLD ? 0 : 1;
+    unsigned workers = resolveThreadCount(threads);
+    const size_t n = vertices;
+
+    // Count the new arcs of every vertex
+    std::unique_ptr<std::atomic<uint64_t>[]> cursor(new std::atomic<uint64_t>[n]);
+    parallelFor(0, n, threads, [&](size_t u) { cursor[u].store(0, std::memory_order_relaxed); }, 4096);
+    parallelFor(0, pending.size(), threads, [&](size_t i) {
+        cursor[pending[i].u].fetch_add(1, std::memory_order_relaxed);
+        cursor[pending[i].v].fetch_add(1, std::memory_order_relaxed);
+    }, 4096);
+
+    CSR merged;
+    merged.offsets.assign(n + 1, 0);
+    for (size_t u = 0; u < n; u++) {
+        uint64_t oldDegree = adjacency.offsets[u + 1] - adjacency.offsets[u];
+        merged.offsets[u + 1] = merged.offsets[u] + oldDegree + cursor[u].load(std::memory_order_relaxed);
+    }
+    uint64_t arcs = merged.offsets[n];
+    merged.targets.resize(arcs);
+    merged.weights.resize(arcs);
+    merged.edgeIds.resize(arcs);
+
+    // Existing arcs keep their place at the front of each segment
+    parallelFor(0, n, threads, [&](size_t u) {
+        uint64_t from = adjacency.offsets[u];
+        uint64_t count = adjacency.offsets[u + 1] - from;
+        uint64_t to = merged.offsets[u];
+        std::copy_n(adjacency.targets.begin() + from, count, merged.targets.begin() + to);
+        std::copy_n(adjacency.weights.begin() + from, count, merged.weights.begin() + to);
+        std::copy_n(adjacency.edgeIds.begin() + from, count, merged.edgeIds.begin() + to);
+        cursor[u].store(to + count, std::memory_order_relaxed);
+    }, 4096);
+
+    // Scatter new edge ids; a parallel scatter is then sorted per segment so
+    // arcs stay in insertion order
+    parallelFor(0, pending.size(), threads, [&](size_t i) {
+        Index id = static_cast<Index>(oldEdges + i);
+        merged.edgeIds[cursor[pending[i].u].fetch_add(1, std::memory_order_relaxed)] = id;
+        merged.edgeIds[cursor[pending[i].v].fetch_add(1, std::memory_order_relaxed)] = id;
+    }, 4096);
+
+    parallelFor(0, n, threads, [&](size_t u) {
+        uint64_t begin = merged.offsets[u] + (adjacency.offsets[u + 1] - adjacency.offsets[u]);
+        uint64_t end = merged.offsets[u + 1];
+        if (workers > 1) std::sort(merged.edgeIds.begin() + begin, merged.edgeIds.begin() + end);
+        for (uint64_t a = begin; a < end; a++) {
+            const Edge& e = pending[merged.edgeIds[a] - oldEdges];
+            merged.targets[a] = (e.u == static_cast<Index>(u)) ? e.v : e.u;
+            merged.weights[a] = e.weight;
+        }
+    }, 1024);
+
+    adjacency = std::move(merged);
+    pending.clear();
+    pending.shrink_to_fit();
+    return adjacency;
+}
+
+template <typename I, typename W>
+std::vector<typename BasicGraph<I, W>::Edge> BasicGraph<I, W>::edgeList() const {
+    const CSR& g = csr();
+    std::vector<Edge> edges(g.targets.size() / 2);
+    parallelFor(0, vertices, edges.size() >= PARALLEL_MERGE_THRESHOLD ? 0 : 1, [&](size_t u) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            if (u <= g.targets[a]) edges[g.edgeIds[a]] = {static_cast<Index>(u), g.targets[a], g.weights[a]};
+        }
+    }, 4096);
+    return edges;
+}
+
+template <typename I, typename W>
+std::vector<std::pair<I, I>> BasicGraph<I, W>::primMST(Index root) {
+    if (vertices == 0) return {};
+    SpanningTree tree = primTree(root, true);
+    std::vector<std::pair<Index, Index>> mst;
+    mst.reserve(vertices - 1);
+    for (Index i = 0; i < vertices; i++) {
+        if (i != root) mst.push_back({tree.parentOf[i], i});
+    }
+    return mst;
+}
+
+template <typename I, typename W>
+typename BasicGraph<I, W>::SpanningTree BasicGraph<I, W>::primTree(Index root, bool parentsOnly) const {
+    SpanningTree tree;
+    tree.root = root;
+    if (vertices == 0) return tree;
+    if (root >= vertices) throw std::out_of_range("Graph::primMST: root out of range");
+    const CSR& g = csr();
+
+    std::vector<Weight> key(vertices, std::numeric_limits<Weight>::max());
+    std::vector<Index> parent(vertices, NO_VERTEX);
     std::vector<bool> inMST(vertices, false);
-    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> pq;
+    std::priority_queue<std::pair<Weight, Index>, std::vector<std::pair<Weight, Index>>, std::greater<std::pair<Weight, Index>>> pq;
 
-    key[0] = 0;
-    pq.push({0, 0});
+    key[root] = 0;
+    pq.push({0, root});
 
     while (!pq.empty()) {
-        int u = pq.top().second;
+        Index u = pq.top().second;
         pq.pop();
+        if (inMST[u]) continue; // Stale entry, u was reached more cheaply
         inMST[u] = true;
+        if (u != root) {
+            tree.treeEdges++;
+            tree.totalWeight += key[u];
+        }
 
-        for (auto& edge : adjList[u]) {
-            int v = edge.first;
-            int weight = edge.second;
-            if (!inMST[v] && weight < key[v]) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index v = g.targets[a];
+            Weight weight = g.weights[a];
+            // parent tells reached from unreached: with narrow weights an
+            // edge may weigh exactly the key's initial max()
+            if (!inMST[v] && (parent[v] == NO_VERTEX || weight < key[v])) {
                 parent[v] = u;
                 key[v] = weight;
                 pq.push({key[v], v});
@@ -37,9 +197,21 @@ std::vector<std::pair<int, int>> Graph::primMST() {
         }
     }
 
-    std::vector<std::pair<int, int>> mst;
-    for (int i = 1; i < vertices; i++) {
-        mst.push_back({parent[i], i});
+    if (parentsOnly) {
+        tree.parentOf = std::move(parent);
+        return tree;
     }
-    return mst;
+    tree.parents.reserve(tree.treeEdges);
+    tree.children.reserve(tree.treeEdges);
+    tree.weights.reserve(tree.treeEdges);
+    for (Index v = 0; v < vertices; v++) {
+        if (parent[v] == NO_VERTEX) continue;
+        tree.parents.push_back(parent[v]);
+        tree.children.push_back(v);
+        tree.weights.push_back(key[v]);
+    }
+    return tree;
 }
+
+#define NETSIM_INSTANTIATE_GRAPH(I, W, NAME) template class BasicGraph<I, W>;
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_GRAPH)
@@ -0,0 +1,287 @@
+#include "graph_generators.h"
+#include "parallel.h"
+#include "rng.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+// Random graphs are produced in this many fixed row blocks, each with its own
+// random stream, so the output does not depend on the number of threads.
+constexpr size_t ROW_BLOCKS = 1024;
+
+// Salt separating the weight stream from the structure stream
+constexpr uint64_t WEIGHT_STREAM = 0xA5A5A5A5A5A5A5A5ULL;
+
+template <typename W>
+void checkConfig(const GeneratorConfig& config) {
+    if (config.minWeight > config.maxWeight) {
+        throw std::invalid_argument("GeneratorConfig: minWeight must not exceed maxWeight");
+    }
+    if (config.minWeight < static_cast<double>(std::numeric_limits<W>::lowest()) ||
+        config.maxWeight > static_cast<double>(std::numeric_limits<W>::max())) {
+        throw std::invalid_argument("GeneratorConfig: weight range does not fit the weight type");
+    }
+}
+
+// Weight at fraction [0, 1) of the configured range; integer weights cover
+// [minWeight, maxWeight] inclusive
+template <typename W>
+W scaleWeight(double fraction, const GeneratorConfig& config) {
+    if (std::is_floating_point<W>::value) {
+        return static_cast<W>(config.minWeight + fraction * (config.maxWeight - config.minWeight));
+    }
+    double low = std::ceil(config.minWeight);
+    double span = std::floor(config.maxWeight) - low + 1;
+    return static_cast<W>(low + std::min(std::floor(fraction * span), span - 1));
+}
+
+template <typename W>
+W drawWeight(uint64_t bits, const GeneratorConfig& config) {
+    return scaleWeight<W>((bits >> 11) * 0x1.0p-53, config);
+}
+
+// Concatenate per-block edge lists in block order
+template <typename G>
+std::vector<typename G::Edge> joinBlocks(std::vector<std::vector<typename G::Edge>>& blocks, unsigned threads) {
+    std::vector<size_t> start(blocks.size() + 1, 0);
+    for (size_t b = 0; b < blocks.size(); b++) {
+        start[b + 1] = start[b] + blocks[b].size();
+    }
+    if (start.back() >= static_cast<uint64_t>(G::NO_VERTEX)) {
+        throw std::length_error("generator: edge count exceeds Graph capacity");
+    }
+    std::vector<typename G::Edge> edges(start.back());
+    parallelFor(0, blocks.size(), threads, [&](size_t b) {
+        std::copy(blocks[b].begin(), blocks[b].end(), edges.begin() + start[b]);
+        std::vector<typename G::Edge>().swap(blocks[b]);
+    });
+    return edges;
+}
+
+// First row of each block, chosen so blocks cover about the same number of
+// candidate pairs (row v has v candidates w < v)
+std::vector<uint64_t> balancedRows(uint64_t n) {
+    size_t blocks = static_cast<size_t>(std::min<uint64_t>(ROW_BLOCKS, std::max<uint64_t>(1, n)));
+    std::vector<uint64_t> rows(blocks + 1);
+    for (size_t b = 0; b <= blocks; b++) {
+        double fraction = static_cast<double>(b) / blocks;
+        rows[b] = static_cast<uint64_t>(std::llround(n * std::sqrt(fraction)));
+    }
+    rows[0] = 0;
+    rows[blocks] = n;
+    for (size_t b = 1; b <= blocks; b++) {
+        rows[b] = std::min(n, std::max(rows[b], rows[b - 1]));
+    }
+    return rows;
+}
+
+// Visit the pairs (v, w), w < v, of rows [rowBegin, rowEnd) that survive
+// independent sampling with probability p (Batagelj-Brandes skipping).
+template <typename Visit>
+void skipPairs(uint64_t rowBegin, uint64_t rowEnd, double p, Xoshiro256pp& rng, Visit&& visit) {
+    if (p <= 0.0) return;
+    if (p >= 1.0) {
+        for (uint64_t v = rowBegin; v < rowEnd; v++) {
+            for (uint64_t w = 0; w < v; w++) visit(v, w);
+        }
+        return;
+    }
+    const double logq = std::log1p(-p);
+    uint64_t v = std::max<uint64_t>(rowBegin, 1);
+    uint64_t w = 0;
+    bool first = true;
+    while (v < rowEnd) {
+        double skip = std::floor(std::log1p(-rng.uniform()) / logq);
+        uint64_t step = static_cast<uint64_t>(std::min(skip, 9.0e18)) + (first ? 0 : 1);
+        first = false;
+        w += step;
+        while (w >= v && v < rowEnd) {
+            w -= v;
+            v++;
+        }
+        if (v < rowEnd) visit(v, w);
+    }
+}
+
+} // namespace
+
+template <typename G>
+G erdosRenyi(typename G::Index n, double p, const GeneratorConfig& config) {
+    using Index = typename G::Index;
+    using Weight = typename G::Weight;
+    if (p < 0.0 || p > 1.0) throw std::invalid_argument("erdosRenyi: p must be in [0, 1]");
+    checkConfig<Weight>(config);
+
+    std::vector<uint64_t> rows = balancedRows(n);
+    std::vector<std::vector<typename G::Edge>> blocks(rows.size() - 1);
+    parallelFor(0, blocks.size(), config.threads, [&](size_t b) {
+        Xoshiro256pp rng(config.seed, b);
+        Xoshiro256pp weights(config.seed ^ WEIGHT_STREAM, b);
+        double expected = p * ((double)rows[b + 1] * (rows[b + 1] - 1) - (double)rows[b] * (rows[b] - 1)) / 2;
+        blocks[b].reserve(static_cast<size_t>(std::min(expected * 1.05, 1e9)) + 16);
+        skipPairs(rows[b], rows[b + 1], p, rng, [&](uint64_t v, uint64_t w) {
+            blocks[b].push_back({static_cast<Index>(w), static_cast<Index>(v), drawWeight<Weight>(weights(), config)});
+        });
+    });
+
+    G g(n, joinBlocks<G>(blocks, config.threads));
+    g.csr();
+    return g;
+}
+
+template <typename G>
+G barabasiAlbert(typename G::Index n, typename G::Index m, const GeneratorConfig& config) {
+    using Index = typename G::Index;
+    using Weight = typename G::Weight;
+    if (m < 1) throw std::invalid_argument("barabasiAlbert: m must be at least 1");
+    checkConfig<Weight>(config);
+    uint64_t total = n > 1 ? static_cast<uint64_t>(n - 1) * m : 0;
+    if (n > 1 && total / m != static_cast<uint64_t>(n - 1)) throw std::length_error("barabasiAlbert: edge count overflow");
+    if (total >= static_cast<uint64_t>(G::NO_VERTEX)) {
+        throw std::length_error("barabasiAlbert: edge count exceeds Graph capacity");
+    }
+
+    // Edge e leaves vertex e / m + 1. Its target is the endpoint stored at a
+    // uniformly random earlier position of the endpoint array; odd positions
+    // are targets themselves and are resolved by following them back.
+    const uint64_t perVertex = m;
+    auto source = [perVertex](uint64_t e) { return e / perVertex + 1; };
+    auto target = [&](uint64_t e) -> uint64_t {
+        while (true) {
+            uint64_t v = source(e);
+            if (v == 1) return 0;
+            uint64_t span = 2 * (v - 1) * perVertex;
+            uint64_t bits = counterRandom(config.seed, e);
+            uint64_t pos = static_cast<uint64_t>((static_cast<unsigned __int128>(bits) * span) >> 64);
+            if ((pos & 1) == 0) return source(pos / 2);
+            e = pos / 2;
+        }
+    };
+
+    std::vector<typename G::Edge> edges(total);
+    parallelFor(0, total, config.threads, [&](size_t e) {
+        edges[e] = {static_cast<Index>(source(e)), static_cast<Index>(target(e)),
+                    drawWeight<Weight>(counterRandom(config.seed ^ WEIGHT_STREAM, e), config)};
+    }, 1 << 14);
+
+    G g(n, std::move(edges));
+    g.csr();
+    return g;
+}
+
+template <typename G>
+G waxman(typename G::Index n, double alpha, double beta, const GeneratorConfig& config) {
+    using Index = typename G::Index;
+    using Weight = typename G::Weight;
+    if (alpha < 0.0 || alpha > 1.0 || beta <= 0.0) {
+        throw std::invalid_argument("waxman: need alpha in [0, 1] and beta > 0");
+    }
+    checkConfig<Weight>(config);
+
+    std::vector<double> x(n), y(n);
+    parallelFor(0, n, config.threads, [&](size_t i) {
+        x[i] = (counterRandom(config.seed, 2 * i) >> 11) * 0x1.0p-53;
+        y[i] = (counterRandom(config.seed, 2 * i + 1) >> 11) * 0x1.0p-53;
+    }, 1 << 14);
+
+    const double maxDistance = std::sqrt(2.0);
+    std::vector<uint64_t> rows = balancedRows(n);
+    std::vector<std::vector<typename G::Edge>> blocks(rows.size() - 1);
+    parallelFor(0, blocks.size(), config.threads, [&](size_t b) {
+        Xoshiro256pp rng(config.seed, b);
+        Xoshiro256pp accept(config.seed ^ WEIGHT_STREAM, b);
+        // Candidates are drawn with probability alpha, then thinned by distance
+        skipPairs(rows[b], rows[b + 1], alpha, rng, [&](uint64_t v, uint64_t w) {
+            double d = std::hypot(x[v] - x[w], y[v] - y[w]);
+            if (accept.uniform() < std::exp(-d / (beta * maxDistance))) {
+                double fraction = std::min(d / maxDistance, std::nextafter(1.0, 0.0));
+                blocks[b].push_back({static_cast<Index>(w), static_cast<Index>(v), scaleWeight<Weight>(fraction, config)});
+            }
+        });
+    });
+
+    G g(n, joinBlocks<G>(blocks, config.threads));
+    g.csr();
+    return g;
+}
+
+template <typename G>
+G fatTree(typename G::Index k, bool includeHosts, typename G::Weight weight) {
+    using Index = typename G::Index;
+    if (k < 2 || k % 2 != 0) throw std::invalid_argument("fatTree: k must be even and at least 2");
+    const uint64_t half = k / 2;
+    const uint64_t cores = half * half;
+    const uint64_t switches = cores + static_cast<uint64_t>(k) * k;
+    const uint64_t hosts = includeHosts ? k * half * half : 0;
+    if (switches + hosts >= static_cast<uint64_t>(G::NO_VERTEX)) throw std::length_error("fatTree: k too large for the index type");
+
+    std::vector<typename G::Edge> edges;
+    edges.reserve(static_cast<size_t>(k) * half * half * (includeHosts ? 3 : 2));
+    auto link = [&](uint64_t u, uint64_t v) { edges.push_back({static_cast<Index>(u), static_cast<Index>(v), weight}); };
+    for (uint64_t pod = 0; pod < k; pod++) {
+        const uint64_t agg = cores + pod * k;
+        const uint64_t edge = agg + half;
+        // Aggregation switch i of every pod reaches cores [i * half, (i + 1) * half)
+        for (uint64_t i = 0; i < half; i++) {
+            for (uint64_t j = 0; j < half; j++) link(i * half + j, agg + i);
+        }
+        for (uint64_t i = 0; i < half; i++) {
+            for (uint64_t j = 0; j < half; j++) link(agg + i, edge + j);
+        }
+        if (includeHosts) {
+            for (uint64_t j = 0; j < half; j++) {
+                uint64_t firstHost = switches + (pod * half + j) * half;
+                for (uint64_t h = 0; h < half; h++) link(edge + j, firstHost + h);
+            }
+        }
+    }
+
+    G g(static_cast<Index>(switches + hosts), std::move(edges));
+    g.csr();
+    return g;
+}
+
+template <typename G>
+G torus(const std::vector<typename G::Index>& dims, typename G::Weight weight) {
+    using Index = typename G::Index;
+    if (dims.size() != 2 && dims.size() != 3) throw std::invalid_argument("torus: need 2 or 3 dimensions");
+    uint64_t n = 1;
+    for (Index d : dims) {
+        if (d < 1) throw std::invalid_argument("torus: dimensions must be positive");
+        if (n * d / d != n || n * d >= static_cast<uint64_t>(G::NO_VERTEX)) {
+            throw std::length_error("torus: vertex count exceeds Graph capacity");
+        }
+        n *= d;
+    }
+
+    std::vector<typename G::Edge> edges;
+    edges.reserve(static_cast<size_t>(n) * dims.size());
+    for (uint64_t id = 0; id < n; id++) {
+        uint64_t stride = 1;
+        for (Index d : dims) {
+            uint64_t c = (id / stride) % d;
+            // A ring of two is a single link; a ring of one has none
+            if (d > 2 || (d == 2 && c == 0)) {
+                uint64_t next = c + 1 < d ? id + stride : id - stride * c;
+                edges.push_back({static_cast<Index>(id), static_cast<Index>(next), weight});
+            }
+            stride *= d;
+        }
+    }
+
+    G g(static_cast<Index>(n), std::move(edges));
+    g.csr();
+    return g;
+}
+
+#define NETSIM_INSTANTIATE_GENERATORS(I, W, NAME)                                                              \
+    template BasicGraph<I, W> erdosRenyi<BasicGraph<I, W>>(I, double, const GeneratorConfig&);                \
+    template BasicGraph<I, W> barabasiAlbert<BasicGraph<I, W>>(I, I, const GeneratorConfig&);                 \
+    template BasicGraph<I, W> waxman<BasicGraph<I, W>>(I, double, double, const GeneratorConfig&);            \
+    template BasicGraph<I, W> fatTree<BasicGraph<I, W>>(I, bool, W);                                          \
+    template BasicGraph<I, W> torus<BasicGraph<I, W>>(const std::vector<I>&, W);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_GENERATORS)
@@ -0,0 +1,499 @@
+#include "graph_partition.h"
+#include "parallel.h"
+#include "rng.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+
+// Coarsening stops below this many vertices per part, or when a level
+// shrinks the graph by less than COARSENING_MIN_SHRINK
+constexpr uint64_t COARSEST_PER_PART = 30;
+constexpr double COARSENING_MIN_SHRINK = 0.05;
+constexpr int MATCHING_ROUNDS = 3;
+constexpr int INITIAL_TRIES = 8;
+constexpr int LP_ROUNDS = 5;
+constexpr int FM_PASSES = 2;
+// FM gives up after this many moves without a new best cut
+constexpr size_t FM_PATIENCE = 200;
+
+// One level of the hierarchy: weighted vertices and weighted arcs
+template <typename Index>
+struct Level {
+    std::vector<uint64_t> offsets;
+    std::vector<Index> targets;
+    std::vector<int64_t> edgeWeights;
+    std::vector<int64_t> vertexWeights;
+    std::vector<Index> coarseOf;           // Vertex of the next coarser level
+
+    Index size() const { return static_cast<Index>(vertexWeights.size()); }
+};
+
+// Connection weight of one vertex to each part, reset through `touched`
+template <typename Index>
+struct PartConnections {
+    std::vector<int64_t> weight;
+    std::vector<Index> touched;
+
+    explicit PartConnections(Index parts) : weight(parts, 0) {}
+
+    void gather(const Level<Index>& level, const std::vector<Index>& part, Index v) {
+        clear();
+        for (uint64_t a = level.offsets[v]; a < level.offsets[v + 1]; a++) {
+            Index p = part[level.targets[a]];
+            if (weight[p] == 0) touched.push_back(p);
+            weight[p] += level.edgeWeights[a];
+        }
+    }
+
+    void clear() {
+        for (Index p : touched) weight[p] = 0;
+        touched.clear();
+    }
+};
+
+template <typename Index>
+class Partitioner {
+public:
+    static constexpr Index NONE = std::numeric_limits<Index>::max();
+
+    Partitioner(Index parts, double epsilon, uint64_t seed, unsigned threads)
+        : parts(parts), epsilon(epsilon), seed(seed), threads(resolveThreadCount(threads)) {}
+
+    std::vector<Index> run(Level<Index> finest) {
+        const int64_t total = std::accumulate(finest.vertexWeights.begin(), finest.vertexWeights.end(), int64_t(0));
+        const int64_t average = (total + parts - 1) / parts;
+        finalMax = static_cast<int64_t>(std::floor((1.0 + epsilon) * average));
+
+        std::vector<Level<Index>> levels;
+        levels.push_back(std::move(finest));
+        const int64_t heaviest = std::max<int64_t>(1, total / static_cast<int64_t>(COARSEST_PER_PART * parts) * 3 / 2);
+        while (levels.back().size() > COARSEST_PER_PART * parts) {
+            Level<Index> coarse = coarsen(levels.back(), heaviest, levels.size());
+            if (coarse.size() > (1.0 - COARSENING_MIN_SHRINK) * levels.back().size()) {
+                levels.back().coarseOf.clear();
+                break;
+            }
+            levels.push_back(std::move(coarse));
+        }
+
+        std::vector<Index> part = initialPartition(levels.back(), average);
+        for (size_t l = levels.size(); l-- > 0;) {
+            const Level<Index>& level = levels[l];
+            if (l + 1 < levels.size()) {
+                std::vector<Index> fine(level.size());
+                parallelFor(0, level.size(), threads, [&](size_t v) { fine[v] = part[level.coarseOf[v]]; }, 4096);
+                part = std::move(fine);
+                levels[l + 1] = Level<Index>();
+            }
+            refine(level, part, maxWeightFor(level, average));
+        }
+        return part;
+    }
+
+private:
+    Index parts;
+    double epsilon;
+    uint64_t seed;
+    unsigned threads;
+    int64_t finalMax = 0;
+
+    // Coarse levels may not be able to meet the final bound exactly
+    int64_t maxWeightFor(const Level<Index>& level, int64_t average) const {
+        int64_t heaviest = *std::max_element(level.vertexWeights.begin(), level.vertexWeights.end());
+        return heaviest > 1 ? std::max(finalMax, average + heaviest) : std::max<int64_t>(finalMax, 1);
+    }
+
+    // Parallel heavy-edge matching by mutual proposals, then contraction
+    Level<Index> coarsen(Level<Index>& fine, int64_t heaviest, size_t depth) {
+        const Index n = fine.size();
+        std::vector<Index> mate(n, NONE), proposal(n, NONE);
+        for (int round = 0; round < MATCHING_ROUNDS; round++) {
+            const uint64_t stream = seed * 0x9E3779B97F4A7C15ULL + depth * MATCHING_ROUNDS + round;
+            parallelFor(0, n, threads, [&](size_t v) {
+                proposal[v] = NONE;
+                if (mate[v] != NONE) return;
+                int64_t best = 0;
+                uint64_t bestTie = 0;
+                for (uint64_t a = fine.offsets[v]; a < fine.offsets[v + 1]; a++) {
+                    Index u = fine.targets[a];
+                    if (u == v || mate[u] != NONE || fine.vertexWeights[v] + fine.vertexWeights[u] > heaviest) continue;
+                    uint64_t tie = counterRandom(stream, u);
+                    if (fine.edgeWeights[a] > best || (fine.edgeWeights[a] == best && tie > bestTie)) {
+                        best = fine.edgeWeights[a];
+                        bestTie = tie;
+                        proposal[v] = u;
+                    }
+                }
+            }, 1024);
+            parallelFor(0, n, threads, [&](size_t v) {
+                Index u = proposal[v];
+                if (u != NONE && proposal[u] == v) mate[v] = u;
+            }, 4096);
+        }
+
+        // A pair is represented by its smaller vertex
+        fine.coarseOf.assign(n, NONE);
+        std::vector<Index> members;        // Representatives in coarse id order
+        for (Index v = 0; v < n; v++) {
+            if (mate[v] == NONE || v < mate[v]) {
+                fine.coarseOf[v] = static_cast<Index>(members.size());
+                members.push_back(v);
+            }
+        }
+        parallelFor(0, n, threads, [&](size_t v) {
+            if (fine.coarseOf[v] == NONE) fine.coarseOf[v] = fine.coarseOf[mate[v]];
+        }, 4096);
+
+        Level<Index> coarse;
+        const Index nc = static_cast<Index>(members.size());
+        coarse.vertexWeights.resize(nc);
+        coarse.offsets.assign(static_cast<size_t>(nc) + 1, 0);
+        // Merged adjacency of coarse vertex c, parallel arcs summed
+        auto gather = [&](Index c, std::vector<Index>& slot, std::vector<Index>& list, std::vector<int64_t>& weights) {
+            list.clear();
+            weights.clear();
+            Index v = members[c];
+            for (Index x : {v, mate[v]}) {
+                if (x == NONE) continue;
+                for (uint64_t a = fine.offsets[x]; a < fine.offsets[x + 1]; a++) {
+                    Index d = fine.coarseOf[fine.targets[a]];
+                    if (d == c) continue;
+                    if (slot[d] == NONE) {
+                        slot[d] = static_cast<Index>(list.size());
+                        list.push_back(d);
+                        weights.push_back(0);
+                    }
+                    weights[slot[d]] += fine.edgeWeights[a];
+                }
+            }
+            for (Index d : list) slot[d] = NONE;
+        };
+        auto eachCoarseVertex = [&](auto&& fn) {
+            unsigned workers = static_cast<unsigned>(std::min<size_t>(threads, std::max<Index>(1, nc / 4096)));
+            std::atomic<size_t> next(0);
+            parallelRun(std::max(1u, workers), [&](unsigned) {
+                std::vector<Index> slot(nc, NONE), list;
+                std::vector<int64_t> weights;
+                while (true) {
+                    size_t start = next.fetch_add(1024);
+                    if (start >= nc) break;
+                    for (size_t c = start; c < std::min<size_t>(nc, start + 1024); c++) {
+                        gather(static_cast<Index>(c), slot, list, weights);
+                        fn(static_cast<Index>(c), list, weights);
+                    }
+                }
+            });
+        };
+        eachCoarseVertex([&](Index c, const std::vector<Index>& list, const std::vector<int64_t>&) {
+            Index v = members[c];
+            coarse.vertexWeights[c] = fine.vertexWeights[v] + (mate[v] != NONE ? fine.vertexWeights[mate[v]] : 0);
+            coarse.offsets[c + 1] = list.size();
+        });
+        for (Index c = 0; c < nc; c++) coarse.offsets[c + 1] += coarse.offsets[c];
+        coarse.targets.resize(coarse.offsets[nc]);
+        coarse.edgeWeights.resize(coarse.offsets[nc]);
+        eachCoarseVertex([&](Index c, const std::vector<Index>& list, const std::vector<int64_t>& weights) {
+            std::copy(list.begin(), list.end(), coarse.targets.begin() + coarse.offsets[c]);
+            std::copy(weights.begin(), weights.end(), coarse.edgeWeights.begin() + coarse.offsets[c]);
+        });
+        return coarse;
+    }
+
+    int64_t cut(const Level<Index>& level, const std::vector<Index>& part) const {
+        int64_t total = 0;
+        for (Index v = 0; v < level.size(); v++) {
+            for (uint64_t a = level.offsets[v]; a < level.offsets[v + 1]; a++) {
+                if (part[level.targets[a]] != part[v]) total += level.edgeWeights[a];
+            }
+        }
+        return total / 2;
+    }
+
+    std::vector<int64_t> partWeights(const Level<Index>& level, const std::vector<Index>& part) const {
+        std::vector<int64_t> weights(parts, 0);
+        for (Index v = 0; v < level.size(); v++) weights[part[v]] += level.vertexWeights[v];
+        return weights;
+    }
+
+    // Greedy graph growing from several random seeds in parallel; the most
+    // balanced split with the smallest cut wins
+    std::vector<Index> initialPartition(const Level<Index>& level, int64_t average) {
+        const Index n = level.size();
+        const int64_t maxWeight = maxWeightFor(level, average);
+        std::vector<std::vector<Index>> tries(INITIAL_TRIES);
+        std::vector<std::pair<int64_t, int64_t>> scores(INITIAL_TRIES);
+        parallelFor(0, INITIAL_TRIES, threads, [&](size_t t) {
+            Xoshiro256pp rng(seed, 1000 + t);
+            std::vector<Index> order(n);
+            std::iota(order.begin(), order.end(), Index(0));
+            for (Index i = n; i > 1; i--) std::swap(order[i - 1], order[rng.below(i)]);
+
+            std::vector<Index> part(n, NONE);
+            std::vector<int64_t> gain(n, 0);
+            std::vector<Index> gainPart(n, NONE);
+            std::vector<std::pair<int64_t, Index>> heap;
+            int64_t remaining = std::accumulate(level.vertexWeights.begin(), level.vertexWeights.end(), int64_t(0));
+            size_t cursor = 0;
+            for (Index p = 0; p + 1 < parts; p++) {
+                const int64_t target = remaining / (parts - p);
+                int64_t weight = 0;
+                heap.clear();
+                while (weight < target) {
+                    if (heap.empty()) {
+                        while (cursor < n && part[order[cursor]] != NONE) cursor++;
+                        if (cursor == n) break;
+                        heap.push_back({0, order[cursor]});
+                    }
+                    std::pop_heap(heap.begin(), heap.end());
+                    auto top = heap.back();
+                    heap.pop_back();
+                    Index v = top.second;
+                    if (part[v] != NONE || (gainPart[v] == p && top.first != gain[v])) continue;
+                    part[v] = p;
+                    weight += level.vertexWeights[v];
+                    for (uint64_t a = level.offsets[v]; a < level.offsets[v + 1]; a++) {
+                        Index u = level.targets[a];
+                        if (part[u] != NONE) continue;
+                        if (gainPart[u] != p) {
+                            gainPart[u] = p;
+                            gain[u] = 0;
+                        }
+                        gain[u] += level.edgeWeights[a];
+                        heap.push_back({gain[u], u});
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+                remaining -= weight;
+            }
+            for (Index v = 0; v < n; v++) {
+                if (part[v] == NONE) part[v] = parts - 1;
+            }
+            refine(level, part, maxWeight, false);
+            auto weights = partWeights(level, part);
+            int64_t over = 0;
+            for (int64_t w : weights) over += std::max<int64_t>(0, w - maxWeight);
+            scores[t] = {over, cut(level, part)};
+            tries[t] = std::move(part);
+        }, 1);
+        size_t best = std::min_element(scores.begin(), scores.end()) - scores.begin();
+        return std::move(tries[best]);
+    }
+
+    void refine(const Level<Index>& level, std::vector<Index>& part, int64_t maxWeight, bool parallel = true) {
+        std::vector<int64_t> weights = partWeights(level, part);
+        rebalance(level, part, weights, maxWeight);
+        for (int round = 0; round < LP_ROUNDS; round++) {
+            if (labelPropagation(level, part, weights, maxWeight, parallel ? threads : 1) == 0) break;
+        }
+        for (int pass = 0; pass < FM_PASSES; pass++) {
+            if (fmPass(level, part, weights, maxWeight) <= 0) break;
+        }
+    }
+
+    // Best move of v to a part with room: (gain, target), target NONE if none
+    std::pair<int64_t, Index> bestMove(const Level<Index>& level, const std::vector<Index>& part,
+                                       const std::vector<int64_t>& weights, int64_t maxWeight, Index v,
+                                       PartConnections<Index>& conn) const {
+        conn.gather(level, part, v);
+        const Index from = part[v];
+        std::pair<int64_t, Index> best = {std::numeric_limits<int64_t>::min(), NONE};
+        for (Index q : conn.touched) {
+            if (q == from || weights[q] + level.vertexWeights[v] > maxWeight) continue;
+            int64_t gain = conn.weight[q] - conn.weight[from];
+            if (best.second == NONE || gain > best.first || (gain == best.first && weights[q] < weights[best.second])) {
+                best = {gain, q};
+            }
+        }
+        return best;
+    }
+
+    // Moves are chosen in parallel against the current partition, then
+    // committed in vertex order after rechecking gain and balance
+    size_t labelPropagation(const Level<Index>& level, std::vector<Index>& part, std::vector<int64_t>& weights,
+                            int64_t maxWeight, unsigned workers) {
+        const Index n = level.size();
+        std::vector<Index> wanted(n, NONE);
+        unsigned pool = static_cast<unsigned>(std::min<size_t>(workers, std::max<Index>(1, n / 4096)));
+        std::atomic<size_t> next(0);
+        parallelRun(std::max(1u, pool), [&](unsigned) {
+            PartConnections<Index> conn(parts);
+            while (true) {
+                size_t start = next.fetch_add(1024);
+                if (start >= n) break;
+                for (size_t v = start; v < std::min<size_t>(n, start + 1024); v++) {
+                    auto move = bestMove(level, part, weights, maxWeight, static_cast<Index>(v), conn);
+                    if (move.second != NONE && (move.first > 0 || (move.first == 0 &&
+                        weights[move.second] + level.vertexWeights[v] < weights[part[v]]))) {
+                        wanted[v] = move.second;
+                    }
+                }
+            }
+        });
+
+        size_t moved = 0;
+        PartConnections<Index> conn(parts);
+        for (Index v = 0; v < n; v++) {
+            if (wanted[v] == NONE) continue;
+            auto move = bestMove(level, part, weights, maxWeight, v, conn);
+            if (move.second == NONE) continue;
+            if (move.first > 0 || (move.first == 0 && weights[move.second] + level.vertexWeights[v] < weights[part[v]])) {
+                weights[part[v]] -= level.vertexWeights[v];
+                weights[move.second] += level.vertexWeights[v];
+                part[v] = move.second;
+                moved++;
+            }
+        }
+        return moved;
+    }
+
+    // Boundary Fiduccia-Mattheyses pass: take the best move even when it
+    // loses, lock the vertex, and finally roll back to the best prefix
+    int64_t fmPass(const Level<Index>& level, std::vector<Index>& part, std::vector<int64_t>& weights, int64_t maxWeight) {
+        const Index n = level.size();
+        using Entry = std::tuple<int64_t, Index, Index, uint32_t>;   // gain, vertex, target, version
+        std::vector<Entry> heap;
+        std::vector<uint32_t> version(n, 0);
+        std::vector<uint8_t> locked(n, 0);
+        PartConnections<Index> conn(parts);
+        auto push = [&](Index v) {
+            auto move = bestMove(level, part, weights, maxWeight, v, conn);
+            if (move.second == NONE) return;   // Interior vertex, or no neighbouring part has room
+            heap.emplace_back(move.first, v, move.second, ++version[v]);
+            std::push_heap(heap.begin(), heap.end());
+        };
+        for (Index v = 0; v < n; v++) push(v);
+
+        std::vector<std::pair<Index, Index>> log;   // Vertex and the part it left
+        int64_t gained = 0, bestGain = 0;
+        size_t bestLength = 0;
+        while (!heap.empty() && log.size() - bestLength < FM_PATIENCE) {
+            std::pop_heap(heap.begin(), heap.end());
+            Entry top = heap.back();
+            heap.pop_back();
+            Index v = std::get<1>(top), to = std::get<2>(top);
+            if (locked[v] || std::get<3>(top) != version[v]) continue;
+            if (weights[to] + level.vertexWeights[v] > maxWeight) {
+                push(v);
+                continue;
+            }
+            Index from = part[v];
+            weights[from] -= level.vertexWeights[v];
+            weights[to] += level.vertexWeights[v];
+            part[v] = to;
+            locked[v] = 1;
+            log.push_back({v, from});
+            gained += std::get<0>(top);
+            if (gained > bestGain) {
+                bestGain = gained;
+                bestLength = log.size();
+            }
+            for (uint64_t a = level.offsets[v]; a < level.offsets[v + 1]; a++) {
+                Index u = level.targets[a];
+                if (!locked[u]) push(u);
+            }
+        }
+        while (log.size() > bestLength) {
+            Index v = log.back().first, from = log.back().second;
+            weights[part[v]] -= level.vertexWeights[v];
+            weights[from] += level.vertexWeights[v];
+            part[v] = from;
+            log.pop_back();
+        }
+        return bestGain;
+    }
+
+    // Empty overweight parts, cheapest moves first
+    void rebalance(const Level<Index>& level, std::vector<Index>& part, std::vector<int64_t>& weights, int64_t maxWeight) {
+        PartConnections<Index> conn(parts);
+        for (Index p = 0; p < parts; p++) {
+            if (weights[p] <= maxWeight) continue;
+            std::vector<std::pair<int64_t, Index>> candidates;
+            for (Index v = 0; v < level.size(); v++) {
+                if (part[v] != p) continue;
+                auto move = bestMove(level, part, weights, maxWeight, v, conn);
+                candidates.push_back({move.second == NONE ? -conn.weight[p] : move.first, v});
+            }
+            std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<int64_t, Index>>());
+            for (const auto& candidate : candidates) {
+                if (weights[p] <= maxWeight) break;
+                Index v = candidate.second;
+                auto move = bestMove(level, part, weights, maxWeight, v, conn);
+                Index to = move.second;
+                if (to == NONE) {
+                    // No neighbouring part has room: the lightest part takes it
+                    to = static_cast<Index>(std::min_element(weights.begin(), weights.end()) - weights.begin());
+                    if (to == p || weights[to] + level.vertexWeights[v] > maxWeight) continue;
+                }
+                weights[p] -= level.vertexWeights[v];
+                weights[to] += level.vertexWeights[v];
+                part[v] = to;
+            }
+        }
+    }
+};
+
+} // namespace
+
+template <typename G>
+GraphPartition<G> partitionGraph(const G& graph, typename G::Index parts, double epsilon, uint64_t seed, unsigned threads) {
+    using Index = typename G::Index;
+    if (parts == 0) throw std::invalid_argument("partitionGraph: parts must be positive");
+    if (!(epsilon >= 0.0)) throw std::invalid_argument("partitionGraph: epsilon must be non-negative");
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+
+    GraphPartition<G> result;
+    if (parts == 1 || n == 0) {
+        result.part.assign(n, 0);
+    } else {
+        // Finest level: unit vertex and arc weights, self loops dropped
+        Level<Index> finest;
+        finest.vertexWeights.assign(n, 1);
+        finest.offsets.assign(static_cast<size_t>(n) + 1, 0);
+        for (Index v = 0; v < n; v++) {
+            uint64_t loops = 0;
+            for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) loops += g.targets[a] == v;
+            finest.offsets[v + 1] = finest.offsets[v] + (g.offsets[v + 1] - g.offsets[v]) - loops;
+        }
+        finest.targets.resize(finest.offsets[n]);
+        finest.edgeWeights.assign(finest.offsets[n], 1);
+        parallelFor(0, n, threads, [&](size_t v) {
+            uint64_t out = finest.offsets[v];
+            for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+                if (g.targets[a] != v) finest.targets[out++] = g.targets[a];
+            }
+        }, 4096);
+        result.part = Partitioner<Index>(parts, epsilon, seed, threads).run(std::move(finest));
+    }
+
+    result.partSizes.assign(parts, 0);
+    result.partCut.assign(parts, 0);
+    for (Index v = 0; v < n; v++) result.partSizes[result.part[v]]++;
+    for (Index v = 0; v < n; v++) {
+        for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+            Index u = g.targets[a];
+            if (result.part[u] == result.part[v]) continue;
+            result.partCut[result.part[v]]++;
+            if (v < u) {
+                result.cutEdges++;
+                result.cutWeight += g.weights[a];
+            }
+        }
+    }
+    if (n > 0) {
+        const double average = std::ceil(static_cast<double>(n) / parts);
+        result.imbalance = *std::max_element(result.partSizes.begin(), result.partSizes.end()) / average - 1.0;
+    }
+    return result;
+}
+
+#define NETSIM_INSTANTIATE_PARTITION(I, W, NAME) \
+    template GraphPartition<BasicGraph<I, W>> partitionGraph(const BasicGraph<I, W>&, I, double, uint64_t, unsigned);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_PARTITION)
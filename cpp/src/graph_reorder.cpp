@@ -0,0 +1,249 @@
+#include "graph_reorder.h"
+#include "parallel.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Pseudo-peripheral vertex reached from start (George-Liu): move to a
+// minimum-degree vertex of the last BFS level while the eccentricity grows
+template <typename G>
+typename G::Index peripheralVertex(const typename G::CSR& g, typename G::Index start,
+                                   std::vector<uint32_t>& level, std::vector<typename G::Index>& queue) {
+    using Index = typename G::Index;
+    const uint32_t UNSEEN = UINT32_MAX;
+    auto degree = [&](Index v) { return g.offsets[v + 1] - g.offsets[v]; };
+
+    uint32_t eccentricity = 0;
+    for (int round = 0; round < 8; round++) {
+        queue.clear();
+        queue.push_back(start);
+        level[start] = 0;
+        for (size_t head = 0; head < queue.size(); head++) {
+            Index u = queue[head];
+            for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                Index v = g.targets[a];
+                if (level[v] == UNSEEN) {
+                    level[v] = level[u] + 1;
+                    queue.push_back(v);
+                }
+            }
+        }
+        uint32_t last = level[queue.back()];
+        Index candidate = queue.back();
+        for (size_t i = queue.size(); i-- > 0 && level[queue[i]] == last;) {
+            if (degree(queue[i]) < degree(candidate)) candidate = queue[i];
+        }
+        for (Index v : queue) level[v] = UNSEEN;
+        if (round > 0 && last <= eccentricity) break;
+        eccentricity = last;
+        start = candidate;
+    }
+    return start;
+}
+
+template <typename G>
+std::vector<typename G::Index> cuthillMcKee(const G& graph) {
+    using Index = typename G::Index;
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    auto degree = [&](Index v) { return g.offsets[v + 1] - g.offsets[v]; };
+
+    // Components are started from their lowest-degree vertex
+    std::vector<Index> byDegree(n);
+    for (Index v = 0; v < n; v++) byDegree[v] = v;
+    std::stable_sort(byDegree.begin(), byDegree.end(), [&](Index a, Index b) { return degree(a) < degree(b); });
+
+    std::vector<uint32_t> level(n, UINT32_MAX);
+    std::vector<Index> scratch;
+    std::vector<bool> placed(n, false);
+    std::vector<Index> order;
+    order.reserve(n);
+    std::vector<Index> neighbors;
+
+    for (Index seed : byDegree) {
+        if (placed[seed]) continue;
+        Index start = peripheralVertex<G>(g, seed, level, scratch);
+        size_t head = order.size();
+        order.push_back(start);
+        placed[start] = true;
+        // order doubles as the BFS queue
+        for (; head < order.size(); head++) {
+            Index u = order[head];
+            neighbors.clear();
+            for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                Index v = g.targets[a];
+                if (!placed[v]) {
+                    placed[v] = true;
+                    neighbors.push_back(v);
+                }
+            }
+            std::sort(neighbors.begin(), neighbors.end(), [&](Index a, Index b) {
+                return degree(a) != degree(b) ? degree(a) < degree(b) : a < b;
+            });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+template <typename G>
+std::vector<typename G::Index> breadthFirst(const G& graph) {
+    using Index = typename G::Index;
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+
+    std::vector<bool> placed(n, false);
+    std::vector<Index> order;
+    order.reserve(n);
+    for (Index seed = 0; seed < n; seed++) {
+        if (placed[seed]) continue;
+        size_t head = order.size();
+        order.push_back(seed);
+        placed[seed] = true;
+        for (; head < order.size(); head++) {
+            Index u = order[head];
+            for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                Index v = g.targets[a];
+                if (!placed[v]) {
+                    placed[v] = true;
+                    order.push_back(v);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+template <typename G>
+std::vector<typename G::Index> byDescendingDegree(const G& graph) {
+    using Index = typename G::Index;
+    const auto& g = graph.csr();
+    std::vector<Index> order(graph.numVertices());
+    for (Index v = 0; v < graph.numVertices(); v++) order[v] = v;
+    std::stable_sort(order.begin(), order.end(), [&](Index a, Index b) {
+        return g.offsets[a + 1] - g.offsets[a] > g.offsets[b + 1] - g.offsets[b];
+    });
+    return order;
+}
+
+} // namespace
+
+template <typename G>
+std::vector<typename G::Index> vertexOrdering(const G& graph, VertexOrder order) {
+    using Index = typename G::Index;
+    const Index n = graph.numVertices();
+
+    std::vector<Index> sequence; // Original ids in their new order
+    switch (order) {
+        case VertexOrder::IDENTITY:
+            sequence.resize(n);
+            for (Index v = 0; v < n; v++) sequence[v] = v;
+            break;
+        case VertexOrder::DEGREE: sequence = byDescendingDegree(graph); break;
+        case VertexOrder::BFS: sequence = breadthFirst(graph); break;
+        case VertexOrder::RCM: sequence = cuthillMcKee(graph); break;
+        default: throw std::invalid_argument("vertexOrdering: unknown order");
+    }
+
+    std::vector<Index> newId(n);
+    for (Index i = 0; i < n; i++) newId[sequence[i]] = i;
+    return newId;
+}
+
+template <typename G>
+G permuteGraph(const G& graph, const std::vector<typename G::Index>& newId, unsigned threads) {
+    using Index = typename G::Index;
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    if (newId.size() != static_cast<size_t>(n)) {
+        throw std::invalid_argument("permuteGraph: permutation size does not match the graph");
+    }
+
+    std::vector<Index> originalId(n, G::NO_VERTEX);
+    for (Index v = 0; v < n; v++) {
+        if (newId[v] >= n || originalId[newId[v]] != G::NO_VERTEX) {
+            throw std::invalid_argument("permuteGraph: not a permutation");
+        }
+        originalId[newId[v]] = v;
+    }
+
+    typename G::CSR out;
+    out.offsets.assign(static_cast<size_t>(n) + 1, 0);
+    for (Index v = 0; v < n; v++) {
+        Index u = originalId[v];
+        out.offsets[v + 1] = out.offsets[v] + (g.offsets[u + 1] - g.offsets[u]);
+    }
+    out.targets.resize(g.targets.size());
+    out.weights.resize(g.weights.size());
+    out.edgeIds.resize(g.edgeIds.size());
+
+    parallelFor(0, n, threads, [&](size_t v) {
+        Index u = originalId[v];
+        uint64_t to = out.offsets[v];
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++, to++) {
+            out.targets[to] = newId[g.targets[a]];
+            out.weights[to] = g.weights[a];
+            out.edgeIds[to] = g.edgeIds[a];
+        }
+    }, 1024);
+    return G(n, std::move(out));
+}
+
+template <typename G>
+uint64_t graphBandwidth(const G& graph) {
+    const auto& g = graph.csr();
+    uint64_t width = 0;
+    for (typename G::Index u = 0; u < graph.numVertices(); u++) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            uint64_t v = g.targets[a];
+            width = std::max<uint64_t>(width, v > u ? v - u : u - v);
+        }
+    }
+    return width;
+}
+
+template <typename G>
+ReorderedGraph<G>::ReorderedGraph(const G& graph, VertexOrder order, unsigned threads)
+    : newId(vertexOrdering(graph, order)), originalId(newId.size()), permuted(permuteGraph(graph, newId, threads)) {
+    for (Index v = 0; v < graph.numVertices(); v++) originalId[newId[v]] = v;
+}
+
+template <typename G>
+std::vector<std::pair<typename G::Index, typename G::Index>> ReorderedGraph<G>::primMST(Index root) {
+    const Index n = permuted.numVertices();
+    if (n == 0) return {};
+    if (root >= n) throw std::out_of_range("ReorderedGraph::primMST: root out of range");
+
+    // Record parents by original child, then list children in original order
+    std::vector<Index> parent(n, G::NO_VERTEX);
+    for (const auto& edge : permuted.primMST(newId[root])) {
+        parent[originalId[edge.second]] = toOriginal(edge.first);
+    }
+    std::vector<std::pair<Index, Index>> mst;
+    mst.reserve(n - 1);
+    for (Index v = 0; v < n; v++) {
+        if (v != root) mst.push_back({parent[v], v});
+    }
+    return mst;
+}
+
+template <typename G>
+MaxFlowResult<G> ReorderedGraph<G>::maxFlow(Index s, Index t) const {
+    if (s >= permuted.numVertices() || t >= permuted.numVertices()) {
+        throw std::out_of_range("ReorderedGraph::maxFlow: vertex out of range");
+    }
+    MaxFlowResult<G> result = ::maxFlow(permuted, newId[s], newId[t]);
+    std::vector<bool> sourceSide(result.sourceSide.size());
+    for (size_t v = 0; v < sourceSide.size(); v++) sourceSide[v] = result.sourceSide[newId[v]];
+    result.sourceSide = std::move(sourceSide);
+    return result;
+}
+
+#define NETSIM_INSTANTIATE_REORDER(I, W, NAME)                                                                   \
+    template std::vector<I> vertexOrdering<BasicGraph<I, W>>(const BasicGraph<I, W>&, VertexOrder);              \
+    template BasicGraph<I, W> permuteGraph<BasicGraph<I, W>>(const BasicGraph<I, W>&, const std::vector<I>&, unsigned); \
+    template uint64_t graphBandwidth<BasicGraph<I, W>>(const BasicGraph<I, W>&);                                 \
+    template class ReorderedGraph<BasicGraph<I, W>>;
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_REORDER)
@@ -0,0 +1,237 @@
+#include "graph_snapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'N', 'S', 'I', 'M', 'C', 'S', 'R', '\0'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+uint64_t alignUp(uint64_t pos) {
+    return (pos + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// End of a section of count elements of `bytes` each starting at pos; false
+// when it would not fit in 64 bits
+bool sectionEnd(uint64_t pos, uint64_t count, uint64_t bytes, uint64_t& end) {
+    if (bytes != 0 && count > (UINT64_MAX - pos) / bytes) return false;
+    end = pos + count * bytes;
+    return true;
+}
+
+void validateHeader(const SnapshotHeader& header, uint64_t fileSize, const std::string& path) {
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw std::runtime_error("snapshot: not a graph snapshot: " + path);
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw std::runtime_error("snapshot: unsupported version " + std::to_string(header.version) + ": " + path);
+    }
+    if (header.byteOrder != BYTE_ORDER_MARK) {
+        throw std::runtime_error("snapshot: written on a machine with a different byte order: " + path);
+    }
+    if (header.fileSize != fileSize) {
+        throw std::runtime_error("snapshot: truncated or padded file: " + path);
+    }
+    uint64_t offsetsEnd, targetsEnd, weightsEnd, edgeIdsEnd;
+    if (header.vertices == UINT64_MAX ||
+        !sectionEnd(header.offsetsPos, header.vertices + 1, sizeof(uint64_t), offsetsEnd) ||
+        !sectionEnd(header.targetsPos, header.arcs, header.indexBytes, targetsEnd) ||
+        !sectionEnd(header.weightsPos, header.arcs, header.weightBytes, weightsEnd) ||
+        !sectionEnd(header.edgeIdsPos, header.arcs, header.indexBytes, edgeIdsEnd) ||
+        header.offsetsPos % SNAPSHOT_ALIGNMENT || header.targetsPos % SNAPSHOT_ALIGNMENT ||
+        header.weightsPos % SNAPSHOT_ALIGNMENT || header.edgeIdsPos % SNAPSHOT_ALIGNMENT ||
+        header.offsetsPos < sizeof(SnapshotHeader) || offsetsEnd > header.targetsPos ||
+        targetsEnd > header.weightsPos || weightsEnd > header.edgeIdsPos || edgeIdsEnd > fileSize) {
+        throw std::runtime_error("snapshot: corrupt section table: " + path);
+    }
+}
+
+// Offsets must climb from 0 and every arc must name an existing vertex and
+// edge, or algorithms would read out of bounds. One pass over the arrays.
+template <typename CSR>
+void verifyArrays(const CSR& csr, uint64_t vertices, const std::string& path) {
+    const uint64_t arcs = csr.targets.size();
+    if (csr.offsets[0] != 0) throw std::runtime_error("snapshot: corrupt offsets: " + path);
+    for (uint64_t u = 0; u < vertices; u++) {
+        if (csr.offsets[u + 1] < csr.offsets[u]) throw std::runtime_error("snapshot: corrupt offsets: " + path);
+    }
+    for (uint64_t a = 0; a < arcs; a++) {
+        if (csr.targets[a] >= vertices || csr.edgeIds[a] >= arcs / 2) {
+            throw std::runtime_error("snapshot: corrupt arcs: " + path);
+        }
+    }
+}
+
+// Read-only view of a whole file; unmapped when the last array using it goes away
+struct FileMapping {
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+#ifdef _WIN32
+    std::vector<uint64_t> buffer;
+#endif
+
+    FileMapping(const std::string& path, bool prefault) {
+#ifdef _WIN32
+        (void)prefault;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("snapshot: cannot open " + path);
+        size = static_cast<uint64_t>(in.tellg());
+        buffer.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer.data()), size);
+        data = reinterpret_cast<const uint8_t*>(buffer.data());
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("snapshot: cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("snapshot: cannot stat " + path);
+        }
+        size = static_cast<uint64_t>(st.st_size);
+        if (size < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            throw std::runtime_error("snapshot: file too small: " + path);
+        }
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if (prefault) flags |= MAP_POPULATE;
+#endif
+        void* mapped = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) throw std::runtime_error("snapshot: cannot map " + path);
+        data = static_cast<const uint8_t*>(mapped);
+        if (prefault) ::madvise(mapped, size, MADV_WILLNEED);
+#endif
+    }
+
+    ~FileMapping() {
+#ifndef _WIN32
+        if (data) ::munmap(const_cast<uint8_t*>(data), size);
+#endif
+    }
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+};
+
+void writeAll(std::FILE* file, const void* data, uint64_t bytes, const std::string& path) {
+    if (bytes && std::fwrite(data, 1, bytes, file) != bytes) {
+        std::fclose(file);
+        throw std::runtime_error("snapshot: write failed: " + path);
+    }
+}
+
+void padTo(std::FILE* file, uint64_t& pos, uint64_t target, const std::string& path) {
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+    writeAll(file, zeros, target - pos, path);
+    pos = target;
+}
+
+} // namespace
+
+SnapshotHeader readSnapshotHeader(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) throw std::runtime_error("snapshot: cannot open " + path);
+    SnapshotHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    if (!ok) throw std::runtime_error("snapshot: file too small: " + path);
+    validateHeader(header, static_cast<uint64_t>(size), path);
+    return header;
+}
+
+template <typename G>
+void saveSnapshot(const G& graph, const std::string& path) {
+    using Index = typename G::Index;
+    using Weight = typename G::Weight;
+    const auto& g = graph.csr();
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.indexBytes = sizeof(Index);
+    header.weightBytes = sizeof(Weight);
+    header.weightKind = weightKindOf<Weight>();
+    header.vertices = graph.numVertices();
+    header.arcs = g.targets.size();
+    header.offsetsPos = alignUp(sizeof(SnapshotHeader));
+    header.targetsPos = alignUp(header.offsetsPos + g.offsets.size() * sizeof(uint64_t));
+    header.weightsPos = alignUp(header.targetsPos + header.arcs * sizeof(Index));
+    header.edgeIdsPos = alignUp(header.weightsPos + header.arcs * sizeof(Weight));
+    header.fileSize = header.edgeIdsPos + header.arcs * sizeof(Index);
+
+    // Write next to the target and rename, so readers never map a partial file
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) throw std::runtime_error("snapshot: cannot create " + temporary);
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 22);
+
+    uint64_t pos = 0;
+    writeAll(file, &header, sizeof(header), temporary);
+    pos += sizeof(header);
+    padTo(file, pos, header.offsetsPos, temporary);
+    writeAll(file, g.offsets.data(), g.offsets.size() * sizeof(uint64_t), temporary);
+    pos += g.offsets.size() * sizeof(uint64_t);
+    padTo(file, pos, header.targetsPos, temporary);
+    writeAll(file, g.targets.data(), header.arcs * sizeof(Index), temporary);
+    pos += header.arcs * sizeof(Index);
+    padTo(file, pos, header.weightsPos, temporary);
+    writeAll(file, g.weights.data(), header.arcs * sizeof(Weight), temporary);
+    pos += header.arcs * sizeof(Weight);
+    padTo(file, pos, header.edgeIdsPos, temporary);
+    writeAll(file, g.edgeIds.data(), header.arcs * sizeof(Index), temporary);
+
+    if (std::fclose(file) != 0) throw std::runtime_error("snapshot: write failed: " + temporary);
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("snapshot: cannot rename to " + path);
+    }
+}
+
+template <typename G>
+G loadSnapshot(const std::string& path, bool prefault, bool verify) {
+    using Index = typename G::Index;
+    using Weight = typename G::Weight;
+
+    auto mapping = std::make_shared<FileMapping>(path, prefault);
+    SnapshotHeader header;
+    std::memcpy(&header, mapping->data, sizeof(header));
+    validateHeader(header, mapping->size, path);
+    if (!snapshotMatches<G>(header)) {
+        throw std::runtime_error("snapshot: index/weight types do not match the requested graph: " + path);
+    }
+    if (header.vertices >= static_cast<uint64_t>(G::NO_VERTEX)) {
+        throw std::runtime_error("snapshot: corrupt vertex count: " + path);
+    }
+
+    typename G::CSR csr;
+    const uint8_t* base = mapping->data;
+    csr.offsets = ArrayBuffer<uint64_t>(reinterpret_cast<const uint64_t*>(base + header.offsetsPos), header.vertices + 1, mapping);
+    csr.targets = ArrayBuffer<Index>(reinterpret_cast<const Index*>(base + header.targetsPos), header.arcs, mapping);
+    csr.weights = ArrayBuffer<Weight>(reinterpret_cast<const Weight*>(base + header.weightsPos), header.arcs, mapping);
+    csr.edgeIds = ArrayBuffer<Index>(reinterpret_cast<const Index*>(base + header.edgeIdsPos), header.arcs, mapping);
+    if (verify) verifyArrays(csr, header.vertices, path);
+    return G(static_cast<Index>(header.vertices), std::move(csr));
+}
+
+#define NETSIM_INSTANTIATE_SNAPSHOT(I, W, NAME)                                                       \
+    template void saveSnapshot<BasicGraph<I, W>>(const BasicGraph<I, W>&, const std::string&);       \
+    template BasicGraph<I, W> loadSnapshot<BasicGraph<I, W>>(const std::string&, bool, bool);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_SNAPSHOT)
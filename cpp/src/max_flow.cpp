@@ -0,0 +1,323 @@
+#include "max_flow.h"
+#include "parallel.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+// Global relabel once the work since the last one exceeds ALPHA * n + m
+constexpr uint64_t GLOBAL_RELABEL_ALPHA = 6;
+constexpr uint64_t RELABEL_WORK = 12;
+
+template <typename G>
+MaxFlow<G>::MaxFlow(const G& graph) : g(graph.csr()), n(graph.numVertices()) {
+    const uint64_t arcs = g.targets.size();
+    reverse.resize(arcs);
+    residual.resize(arcs);
+
+    // The two arcs of an edge are mutual reverses
+    std::vector<uint64_t> firstArc(arcs / 2, std::numeric_limits<uint64_t>::max());
+    for (uint64_t a = 0; a < arcs; a++) {
+        if (g.weights[a] < 0) throw std::invalid_argument("MaxFlow: capacities must be non-negative");
+        uint64_t& other = firstArc[g.edgeIds[a]];
+        if (other == std::numeric_limits<uint64_t>::max()) {
+            other = a;
+        } else {
+            reverse[a] = other;
+            reverse[other] = a;
+        }
+    }
+
+    excess.resize(n);
+    height.resize(n);
+    current.resize(n);
+    firstActive.resize(static_cast<size_t>(n) + 1);
+    firstInactive.resize(static_cast<size_t>(n) + 1);
+    nextActive.resize(n);
+    nextInactive.resize(n);
+    prevInactive.resize(n);
+}
+
+template <typename G>
+void MaxFlow<G>::addActive(Index h, Index v) {
+    nextActive[v] = firstActive[h];
+    firstActive[h] = v;
+    maxActive = std::max<int64_t>(maxActive, h);
+}
+
+template <typename G>
+void MaxFlow<G>::addInactive(Index h, Index v) {
+    nextInactive[v] = firstInactive[h];
+    prevInactive[v] = NONE;
+    if (firstInactive[h] != NONE) prevInactive[firstInactive[h]] = v;
+    firstInactive[h] = v;
+}
+
+template <typename G>
+void MaxFlow<G>::removeInactive(Index h, Index v) {
+    if (prevInactive[v] != NONE) {
+        nextInactive[prevInactive[v]] = nextInactive[v];
+    } else {
+        firstInactive[h] = nextInactive[v];
+    }
+    if (nextInactive[v] != NONE) prevInactive[nextInactive[v]] = prevInactive[v];
+}
+
+// Exact distances to t in the residual graph (reverse BFS); vertices that
+// cannot reach t are lifted to n and drop out of phase one.
+template <typename G>
+void MaxFlow<G>::globalRelabel(Index s, Index t) {
+    for (int64_t h = 0; h <= maxHeight; h++) {
+        firstActive[h] = NONE;
+        firstInactive[h] = NONE;
+    }
+    std::fill(height.begin(), height.end(), n);
+    maxActive = -1;
+    maxHeight = 0;
+    work = 0;
+
+    std::vector<Index> queue;
+    queue.reserve(n);
+    height[t] = 0;
+    queue.push_back(t);
+    addInactive(0, t);
+    for (size_t head = 0; head < queue.size(); head++) {
+        Index w = queue[head];
+        for (uint64_t a = g.offsets[w]; a < g.offsets[w + 1]; a++) {
+            Index v = g.targets[a];
+            if (v == s || height[v] < n || residual[reverse[a]] <= 0) continue;
+            height[v] = height[w] + 1;
+            maxHeight = std::max<int64_t>(maxHeight, height[v]);
+            current[v] = g.offsets[v];
+            if (excess[v] > 0) {
+                addActive(height[v], v);
+            } else {
+                addInactive(height[v], v);
+            }
+            queue.push_back(v);
+        }
+    }
+}
+
+// No vertex is left at height h, so nothing above it can reach t
+template <typename G>
+void MaxFlow<G>::gap(Index h) {
+    for (int64_t level = static_cast<int64_t>(h) + 1; level <= maxHeight; level++) {
+        for (Index v = firstActive[level]; v != NONE; v = nextActive[v]) height[v] = n;
+        for (Index v = firstInactive[level]; v != NONE; v = nextInactive[v]) height[v] = n;
+        firstActive[level] = NONE;
+        firstInactive[level] = NONE;
+    }
+    maxHeight = static_cast<int64_t>(h) - 1;
+    maxActive = std::min(maxActive, maxHeight);
+}
+
+template <typename G>
+void MaxFlow<G>::discharge(Index v, Index t) {
+    while (true) {
+        const Index h = height[v];
+        const uint64_t end = g.offsets[v + 1];
+        for (uint64_t a = current[v]; a < end; a++) {
+            if (residual[a] <= 0) continue;
+            Index w = g.targets[a];
+            if (height[w] + 1 != h) continue;
+            Flow delta = std::min(excess[v], residual[a]);
+            residual[a] -= delta;
+            residual[reverse[a]] += delta;
+            if (w != t && excess[w] <= 0) {
+                removeInactive(height[w], w);
+                addActive(height[w], w);
+            }
+            excess[w] += delta;
+            excess[v] -= delta;
+            if (excess[v] <= 0) {
+                current[v] = a;
+                addInactive(h, v);
+                return;
+            }
+        }
+
+        // Relabel; v has already been unlinked from its bucket
+        if (firstActive[h] == NONE && firstInactive[h] == NONE) {
+            gap(h);
+            height[v] = n;
+            return;
+        }
+        Index newHeight = n;
+        uint64_t newCurrent = g.offsets[v];
+        for (uint64_t a = g.offsets[v]; a < end; a++) {
+            if (residual[a] > 0 && height[g.targets[a]] + 1 < newHeight) {
+                newHeight = height[g.targets[a]] + 1;
+                newCurrent = a;
+            }
+        }
+        work += RELABEL_WORK + (end - g.offsets[v]);
+        height[v] = newHeight;
+        current[v] = newCurrent;
+        if (newHeight >= n) return;
+        maxHeight = std::max<int64_t>(maxHeight, newHeight);
+    }
+}
+
+template <typename G>
+typename MaxFlow<G>::Flow MaxFlow<G>::solve(Index s, Index t, std::vector<bool>* sourceSide) {
+    if (s >= n || t >= n) throw std::out_of_range("MaxFlow::solve: vertex out of range");
+    if (s == t) throw std::invalid_argument("MaxFlow::solve: source and sink must differ");
+
+    for (uint64_t a = 0; a < residual.size(); a++) residual[a] = g.weights[a];
+    std::fill(excess.begin(), excess.end(), 0);
+    maxHeight = static_cast<int64_t>(n) - 1;
+
+    // Saturate every arc leaving the source
+    for (uint64_t a = g.offsets[s]; a < g.offsets[s + 1]; a++) {
+        Index w = g.targets[a];
+        if (w == s) continue;
+        Flow delta = residual[a];
+        residual[a] = 0;
+        residual[reverse[a]] += delta;
+        excess[w] += delta;
+    }
+
+    globalRelabel(s, t);
+    const uint64_t relabelThreshold = GLOBAL_RELABEL_ALPHA * n + g.targets.size() / 2;
+    while (true) {
+        while (maxActive >= 0 && firstActive[maxActive] == NONE) maxActive--;
+        if (maxActive < 0) break;
+        Index v = firstActive[maxActive];
+        firstActive[maxActive] = nextActive[v];
+        discharge(v, t);
+        if (work > relabelThreshold) globalRelabel(s, t);
+    }
+
+    if (sourceSide) {
+        // Final reverse BFS: whatever still reaches t is on the sink side
+        globalRelabel(s, t);
+        sourceSide->assign(n, false);
+        for (Index v = 0; v < n; v++) (*sourceSide)[v] = height[v] >= n;
+    }
+    return excess[t];
+}
+
+template <typename G>
+MaxFlowResult<G> maxFlow(const G& graph, typename G::Index s, typename G::Index t) {
+    MaxFlow<G> engine(graph);
+    MaxFlowResult<G> result;
+    result.flow = engine.solve(s, t, &result.sourceSide);
+
+    const auto& g = graph.csr();
+    for (typename G::Index u = 0; u < graph.numVertices(); u++) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            if (result.sourceSide[u] && !result.sourceSide[g.targets[a]]) result.cutEdges.push_back(g.edgeIds[a]);
+        }
+    }
+    std::sort(result.cutEdges.begin(), result.cutEdges.end());
+    return result;
+}
+
+template <typename G>
+std::vector<FlowType<typename G::Weight>> maxFlowBatch(
+    const G& graph, const std::vector<std::pair<typename G::Index, typename G::Index>>& pairs, unsigned threads) {
+    for (const auto& pair : pairs) {
+        if (pair.first >= graph.numVertices() || pair.second >= graph.numVertices()) {
+            throw std::out_of_range("maxFlowBatch: vertex out of range");
+        }
+        if (pair.first == pair.second) throw std::invalid_argument("maxFlowBatch: source and sink must differ");
+    }
+    graph.csr();
+    std::vector<FlowType<typename G::Weight>> flows(pairs.size());
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, pairs.size())));
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned) {
+        MaxFlow<G> engine(graph);
+        for (size_t i = next++; i < pairs.size(); i = next++) {
+            flows[i] = engine.solve(pairs[i].first, pairs[i].second);
+        }
+    });
+    return flows;
+}
+
+template <typename G>
+GomoryHuTree<G>::GomoryHuTree(const G& graph) {
+    const Index n = graph.numVertices();
+    parent.assign(n, 0);
+    cut.assign(n, 0);
+    depth.assign(n, 0);
+    if (n == 0) return;
+    parent[0] = G::NO_VERTEX;
+
+    MaxFlow<G> engine(graph);
+    std::vector<bool> side;
+    for (Index s = 1; s < n; s++) {
+        Index t = parent[s];
+        cut[s] = engine.solve(s, t, &side);
+        for (Index i = s + 1; i < n; i++) {
+            if (side[i] && parent[i] == t) parent[i] = s;
+        }
+    }
+    // parent[i] < i always holds, so depths fill in index order
+    for (Index v = 1; v < n; v++) depth[v] = depth[parent[v]] + 1;
+}
+
+template <typename G>
+typename GomoryHuTree<G>::Flow GomoryHuTree<G>::minCut(Index u, Index v) const {
+    if (u >= parent.size() || v >= parent.size()) throw std::out_of_range("GomoryHuTree::minCut: vertex out of range");
+    if (u == v) return 0;
+    Flow best = std::numeric_limits<Flow>::max();
+    while (u != v) {
+        if (depth[u] < depth[v]) std::swap(u, v);
+        best = std::min(best, cut[u]);
+        u = parent[u];
+    }
+    return best;
+}
+
+template <typename G>
+std::vector<typename GomoryHuTree<G>::Flow> GomoryHuTree<G>::minCutBatch(
+    const std::vector<std::pair<Index, Index>>& pairs, unsigned threads) const {
+    for (const auto& pair : pairs) {
+        if (pair.first >= parent.size() || pair.second >= parent.size()) {
+            throw std::out_of_range("GomoryHuTree::minCutBatch: vertex out of range");
+        }
+    }
+    std::vector<Flow> cuts(pairs.size());
+    parallelFor(0, pairs.size(), threads, [&](size_t i) {
+        cuts[i] = minCut(pairs[i].first, pairs[i].second);
+    }, 1024);
+    return cuts;
+}
+
+template <typename G>
+std::vector<typename GomoryHuTree<G>::Flow> GomoryHuTree<G>::minCutMatrix(unsigned threads) const {
+    const size_t n = parent.size();
+    std::vector<std::vector<Index>> children(n);
+    for (size_t v = 1; v < n; v++) children[parent[v]].push_back(static_cast<Index>(v));
+
+    // One tree traversal per row, carrying the lightest edge seen so far
+    std::vector<Flow> matrix(n * n, 0);
+    parallelFor(0, n, threads, [&](size_t src) {
+        Flow* row = &matrix[src * n];
+        std::vector<std::pair<Index, Index>> stack = {{static_cast<Index>(src), G::NO_VERTEX}};
+        std::vector<Flow> bottleneck(n, std::numeric_limits<Flow>::max());
+        while (!stack.empty()) {
+            Index v = stack.back().first;
+            Index from = stack.back().second;
+            stack.pop_back();
+            row[v] = v == src ? 0 : bottleneck[v];
+            auto visit = [&](Index w, Flow weight) {
+                if (w == from) return;
+                bottleneck[w] = std::min(bottleneck[v], weight);
+                stack.push_back({w, v});
+            };
+            if (parent[v] != G::NO_VERTEX) visit(parent[v], cut[v]);
+            for (Index c : children[v]) visit(c, cut[c]);
+        }
+    });
+    return matrix;
+}
+
+#define NETSIM_INSTANTIATE_MAX_FLOW(I, W, NAME)                                                                   \
+    template class MaxFlow<BasicGraph<I, W>>;                                                                    \
+    template class GomoryHuTree<BasicGraph<I, W>>;                                                               \
+    template MaxFlowResult<BasicGraph<I, W>> maxFlow<BasicGraph<I, W>>(const BasicGraph<I, W>&, I, I);            \
+    template std::vector<FlowType<W>> maxFlowBatch<BasicGraph<I, W>>(                                            \
+        const BasicGraph<I, W>&, const std::vector<std::pair<I, I>>&, unsigned);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_MAX_FLOW)
@@ -0,0 +1,317 @@
+#include "multipath.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Shortest path tree towards t: dist[v] is v's distance to t and
+// towardsEdge[v] the edge of its first hop (NO_VERTEX at t and when unreachable)
+template <typename G>
+void treeTowards(const G& graph, typename G::Index t, std::vector<WeightSum<typename G::Weight>>& dist,
+                 std::vector<typename G::Index>& towardsEdge,
+                 std::vector<std::pair<WeightSum<typename G::Weight>, typename G::Index>>& heap) {
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+    using Entry = std::pair<Distance, Index>;
+    const auto& g = graph.csr();
+    auto later = std::greater<Entry>();
+    std::fill(dist.begin(), dist.end(), std::numeric_limits<Distance>::max());
+    std::fill(towardsEdge.begin(), towardsEdge.end(), G::NO_VERTEX);
+    dist[t] = 0;
+    heap.assign(1, {0, t});
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Entry top = heap.back();
+        heap.pop_back();
+        Index u = top.second;
+        if (top.first > dist[u]) continue;
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index v = g.targets[a];
+            Distance nd = top.first + g.weights[a];
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                towardsEdge[v] = g.edgeIds[a];
+                heap.push_back({nd, v});
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+}
+
+template <typename G>
+void checkWeights(const G& graph, const char* what) {
+    const auto& g = graph.csr();
+    for (size_t a = 0; a < g.weights.size(); a++) {
+        if (g.weights[a] < typename G::Weight(0)) throw std::invalid_argument(std::string(what) + ": negative edge weight");
+    }
+}
+
+template <typename G>
+void checkVertices(const G& graph, const std::vector<typename G::Index>& ids, const char* what) {
+    for (auto v : ids) {
+        if (v >= graph.numVertices()) throw std::out_of_range(std::string(what) + ": vertex out of range");
+    }
+}
+
+// A loopless path; ordered by length, then edge ids
+template <typename G>
+struct Path {
+    WeightSum<typename G::Weight> length = 0;
+    std::vector<typename G::Index> edges;
+    std::vector<typename G::Index> vertices;
+
+    bool operator<(const Path& other) const {
+        return length != other.length ? length < other.length : edges < other.edges;
+    }
+};
+
+// Per-thread state for Yen's algorithm towards one target at a time
+template <typename G>
+class YenSearch {
+public:
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+    using Entry = std::pair<Distance, Index>;
+    static constexpr Index NONE = G::NO_VERTEX;
+
+    YenSearch(const G& graph, const std::vector<typename G::Edge>& edges)
+        : graph(graph), edges(edges), toTarget(graph.numVertices()), towardsEdge(graph.numVertices()),
+          dist(graph.numVertices(), INF), viaEdge(graph.numVertices()), bannedVertex(graph.numVertices(), 0),
+          bannedEdge(edges.size(), 0) {}
+
+    void setTarget(Index t) {
+        target = t;
+        treeTowards(graph, t, toTarget, towardsEdge, heap);
+    }
+
+    std::vector<Path<G>> paths(Index s, Index k) {
+        std::vector<Path<G>> found;
+        if (k == 0 || toTarget[s] == INF) return found;
+        found.push_back(treePath(s));
+
+        // Candidates, trimmed to the number of paths still wanted
+        std::set<Path<G>> candidates;
+        while (found.size() < k) {
+            const size_t last = found.size() - 1;
+            const size_t wanted = k - found.size();
+            Distance rootLength = 0;
+            for (size_t i = 0; i + 1 < found[last].vertices.size(); i++) {
+                const Path<G>& previous = found[last];
+                Index spur = previous.vertices[i];
+                Distance bound = candidates.size() >= wanted ? candidates.rbegin()->length : INF;
+                if (rootLength + toTarget[spur] <= bound) {
+                    // Ban the next edge of every found path with this root
+                    // and the root's vertices before the spur
+                    stamp++;
+                    for (const auto& path : found) {
+                        if (path.edges.size() > i && std::equal(previous.edges.begin(), previous.edges.begin() + i, path.edges.begin())) {
+                            bannedEdge[path.edges[i]] = stamp;
+                        }
+                    }
+                    for (size_t j = 0; j < i; j++) bannedVertex[previous.vertices[j]] = stamp;
+
+                    Path<G> candidate;
+                    if (spurPath(spur, bound == INF ? INF : bound - rootLength, candidate)) {
+                        candidate.length += rootLength;
+                        candidate.edges.insert(candidate.edges.begin(), previous.edges.begin(), previous.edges.begin() + i);
+                        candidate.vertices.insert(candidate.vertices.begin(), previous.vertices.begin(), previous.vertices.begin() + i);
+                        candidates.insert(std::move(candidate));
+                        if (candidates.size() > wanted) candidates.erase(std::prev(candidates.end()));
+                    }
+                }
+                rootLength += edges[found[last].edges[i]].weight;
+            }
+            if (candidates.empty()) break;
+            found.push_back(std::move(candidates.extract(candidates.begin()).value()));
+        }
+        return found;
+    }
+
+private:
+    static constexpr Distance INF = std::numeric_limits<Distance>::max();
+
+    const G& graph;
+    const std::vector<typename G::Edge>& edges;
+    Index target = 0;
+    std::vector<Distance> toTarget;        // Exact distances in the full graph: the A* potential
+    std::vector<Index> towardsEdge;
+    std::vector<Distance> dist;
+    std::vector<Index> viaEdge;
+    std::vector<Index> touched;
+    std::vector<Entry> heap;
+    // Bans hold the stamp of the spur search they apply to
+    std::vector<uint32_t> bannedVertex, bannedEdge;
+    uint32_t stamp = 0;
+
+    Index across(Index e, Index v) const { return edges[e].u == v ? edges[e].v : edges[e].u; }
+
+    Path<G> treePath(Index s) const {
+        Path<G> path;
+        path.length = toTarget[s];
+        path.vertices.push_back(s);
+        for (Index v = s; v != target;) {
+            path.edges.push_back(towardsEdge[v]);
+            v = across(towardsEdge[v], v);
+            path.vertices.push_back(v);
+        }
+        return path;
+    }
+
+    // A* from spur to the target around the banned vertices and edges;
+    // gives up once no path of length <= limit can remain
+    bool spurPath(Index spur, Distance limit, Path<G>& path) {
+        const auto& g = graph.csr();
+        auto later = std::greater<Entry>();
+        bool reached = false;
+        dist[spur] = 0;
+        viaEdge[spur] = NONE;
+        touched.push_back(spur);
+        heap.assign(1, {toTarget[spur], spur});
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            Entry top = heap.back();
+            heap.pop_back();
+            Index u = top.second;
+            if (top.first > dist[u] + toTarget[u]) continue;
+            if (top.first > limit) break;
+            if (u == target) {
+                reached = true;
+                break;
+            }
+            for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                Index v = g.targets[a];
+                Index e = g.edgeIds[a];
+                if (bannedEdge[e] == stamp || bannedVertex[v] == stamp || v == spur || toTarget[v] == INF) continue;
+                Distance nd = dist[u] + g.weights[a];
+                if (nd < dist[v]) {
+                    if (dist[v] == INF) touched.push_back(v);
+                    dist[v] = nd;
+                    viaEdge[v] = e;
+                    heap.push_back({nd + toTarget[v], v});
+                    std::push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+        if (reached) {
+            path.length = dist[target];
+            for (Index v = target; v != spur; v = across(viaEdge[v], v)) {
+                path.vertices.push_back(v);
+                path.edges.push_back(viaEdge[v]);
+            }
+            path.vertices.push_back(spur);
+            std::reverse(path.vertices.begin(), path.vertices.end());
+            std::reverse(path.edges.begin(), path.edges.end());
+        }
+        for (Index v : touched) dist[v] = INF;
+        touched.clear();
+        return reached;
+    }
+};
+
+} // namespace
+
+template <typename G>
+EcmpTable<G> ecmpNextHops(const G& graph, const std::vector<typename G::Index>& destinations, unsigned threads) {
+    using Index = typename G::Index;
+    using Distance = WeightSum<typename G::Weight>;
+    checkWeights(graph, "ecmpNextHops");
+    checkVertices(graph, destinations, "ecmpNextHops");
+    const auto& g = graph.csr();
+    const Index n = graph.numVertices();
+    const size_t rows = destinations.size() * static_cast<size_t>(n);
+
+    EcmpTable<G> table;
+    table.distances.resize(rows);
+    std::vector<uint64_t> counts(rows + 1, 0);
+    std::vector<std::vector<Index>> hops(destinations.size());
+
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, destinations.size())));
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned) {
+        std::vector<Distance> dist(n);
+        std::vector<Index> towardsEdge(n);
+        std::vector<std::pair<Distance, Index>> heap;
+        for (size_t j = next++; j < destinations.size(); j = next++) {
+            treeTowards(graph, destinations[j], dist, towardsEdge, heap);
+            std::copy(dist.begin(), dist.end(), table.distances.begin() + j * n);
+            // Every arc that keeps the remaining distance exact is a next hop
+            for (Index v = 0; v < n; v++) {
+                if (v == destinations[j] || dist[v] == std::numeric_limits<Distance>::max()) continue;
+                for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+                    Index u = g.targets[a];
+                    if (u != v && dist[u] != std::numeric_limits<Distance>::max() && dist[u] + g.weights[a] == dist[v]) {
+                        hops[j].push_back(u);
+                        counts[j * n + v + 1]++;
+                    }
+                }
+            }
+        }
+    });
+
+    for (size_t r = 0; r < rows; r++) counts[r + 1] += counts[r];
+    table.offsets = std::move(counts);
+    table.nextHops.reserve(table.offsets.back());
+    for (auto& list : hops) table.nextHops.insert(table.nextHops.end(), list.begin(), list.end());
+    return table;
+}
+
+template <typename G>
+PathPool<G> kShortestPaths(const G& graph, const std::vector<typename G::Index>& sources,
+                           const std::vector<typename G::Index>& targets, typename G::Index k, unsigned threads) {
+    if (sources.size() != targets.size()) throw std::invalid_argument("kShortestPaths: sources and targets differ in length");
+    checkWeights(graph, "kShortestPaths");
+    checkVertices(graph, sources, "kShortestPaths");
+    checkVertices(graph, targets, "kShortestPaths");
+    const auto edges = graph.edgeList();
+    const size_t pairs = sources.size();
+
+    // Pairs grouped by target so each group builds one shortest path tree
+    std::vector<size_t> byTarget(pairs);
+    for (size_t j = 0; j < pairs; j++) byTarget[j] = j;
+    std::stable_sort(byTarget.begin(), byTarget.end(), [&](size_t a, size_t b) { return targets[a] < targets[b]; });
+    std::vector<size_t> groups;
+    for (size_t i = 0; i < pairs; i++) {
+        if (i == 0 || targets[byTarget[i]] != targets[byTarget[i - 1]]) groups.push_back(i);
+    }
+    groups.push_back(pairs);
+
+    std::vector<std::vector<Path<G>>> found(pairs);
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, groups.size() - 1)));
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned) {
+        YenSearch<G> search(graph, edges);
+        for (size_t group = next++; group + 1 < groups.size(); group = next++) {
+            search.setTarget(targets[byTarget[groups[group]]]);
+            for (size_t i = groups[group]; i < groups[group + 1]; i++) {
+                found[byTarget[i]] = search.paths(sources[byTarget[i]], k);
+            }
+        }
+    });
+
+    // Flatten in pair order, releasing the per-pair lists as we go
+    PathPool<G> pool;
+    pool.pairOffsets.push_back(0);
+    pool.pathOffsets.push_back(0);
+    for (auto& list : found) {
+        for (const auto& path : list) {
+            pool.vertices.insert(pool.vertices.end(), path.vertices.begin(), path.vertices.end());
+            pool.pathOffsets.push_back(pool.vertices.size());
+            pool.lengths.push_back(path.length);
+        }
+        pool.pairOffsets.push_back(pool.lengths.size());
+        std::vector<Path<G>>().swap(list);
+    }
+    return pool;
+}
+
+#define NETSIM_INSTANTIATE_MULTIPATH(I, W, NAME)                                                                   \
+    template EcmpTable<BasicGraph<I, W>> ecmpNextHops(const BasicGraph<I, W>&, const std::vector<I>&, unsigned);   \
+    template PathPool<BasicGraph<I, W>> kShortestPaths(const BasicGraph<I, W>&, const std::vector<I>&,             \
+                                                       const std::vector<I>&, I, unsigned);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_MULTIPATH)
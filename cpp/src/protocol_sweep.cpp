@@ -0,0 +1,97 @@
+#include "protocol_sweep.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint64_t CHUNK_TRIALS = 4096;   // Trials per task; small enough to balance, large enough to amortize
+
+struct Chunk {
+    std::vector<uint64_t> attemptCounts;
+    uint64_t delivered = 0;
+    double elapsedMs = 0.0;
+};
+
+// Smallest attempt count covering `quantile` of the trials
+uint32_t attemptPercentile(const uint64_t* counts, uint32_t maxRetries, uint64_t trials, double quantile) {
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * trials)));
+    uint64_t seen = 0;
+    for (uint32_t k = 0; k < maxRetries; k++) {
+        seen += counts[k];
+        if (seen >= target) return k + 1;
+    }
+    return maxRetries;
+}
+
+} // namespace
+
+SweepResult sweepProtocolConfigs(const std::vector<uint8_t>& data, const ProtocolConfig& config,
+                                 const SweepGrid& grid, uint64_t trials, uint64_t seed, unsigned threads) {
+    if (grid.errorProbability.empty() || grid.lossProbability.empty() || grid.ackLossProbability.empty() ||
+        grid.timeoutMs.empty()) {
+        throw std::invalid_argument("every sweep axis needs at least one value");
+    }
+    if (trials == 0) throw std::invalid_argument("trials must be at least 1");
+    if (config.maxRetries < 1) throw std::invalid_argument("maxRetries must be at least 1");
+
+    const size_t nLoss = grid.lossProbability.size();
+    const size_t nAck = grid.ackLossProbability.size();
+    const size_t nTimeout = grid.timeoutMs.size();
+    const size_t cells = grid.errorProbability.size() * nLoss * nAck * nTimeout;
+    const uint64_t chunksPerCell = (trials + CHUNK_TRIALS - 1) / CHUNK_TRIALS;
+    const uint32_t maxRetries = static_cast<uint32_t>(config.maxRetries);
+
+    std::vector<Chunk> chunks(cells * chunksPerCell);
+    parallelFor(0, chunks.size(), threads, [&](size_t task) {
+        size_t cell = task / chunksPerCell;
+        uint64_t first = (task % chunksPerCell) * CHUNK_TRIALS;
+        uint64_t count = std::min(CHUNK_TRIALS, trials - first);
+
+        ProtocolConfig cellConfig = config;
+        cellConfig.virtualTime = true;
+        cellConfig.timeoutMs = grid.timeoutMs[cell % nTimeout];
+        cellConfig.ackLossProbability = grid.ackLossProbability[cell / nTimeout % nAck];
+        cellConfig.lossProbability = grid.lossProbability[cell / (nTimeout * nAck) % nLoss];
+        cellConfig.errorProbability = grid.errorProbability[cell / (nTimeout * nAck * nLoss)];
+
+        Chunk& chunk = chunks[task];
+        chunk.attemptCounts.assign(maxRetries, 0);
+        SimClock clock(seed, task);
+        std::vector<uint8_t> ack;
+        int seqNum = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t frames = clock.frames;
+            if (sendPacket(data, ack, seqNum, cellConfig, clock)) chunk.delivered++;
+            chunk.attemptCounts[clock.frames - frames - 1]++;
+        }
+        chunk.elapsedMs = clock.nowMs;
+    });
+
+    // Merge in chunk order so sums are identical for any thread count
+    SweepResult result;
+    result.attemptCounts.assign(cells * maxRetries, 0);
+    for (size_t cell = 0; cell < cells; cell++) {
+        uint64_t* counts = &result.attemptCounts[cell * maxRetries];
+        uint64_t delivered = 0;
+        double elapsedMs = 0.0;
+        for (uint64_t c = 0; c < chunksPerCell; c++) {
+            const Chunk& chunk = chunks[cell * chunksPerCell + c];
+            for (uint32_t k = 0; k < maxRetries; k++) counts[k] += chunk.attemptCounts[k];
+            delivered += chunk.delivered;
+            elapsedMs += chunk.elapsedMs;
+        }
+        uint64_t frames = 0;
+        for (uint32_t k = 0; k < maxRetries; k++) frames += counts[k] * (k + 1);
+
+        result.successRate.push_back(static_cast<double>(delivered) / trials);
+        result.meanAttempts.push_back(static_cast<double>(frames) / trials);
+        result.p50Attempts.push_back(attemptPercentile(counts, maxRetries, trials, 0.50));
+        result.p90Attempts.push_back(attemptPercentile(counts, maxRetries, trials, 0.90));
+        result.p99Attempts.push_back(attemptPercentile(counts, maxRetries, trials, 0.99));
+        result.meanLatencyMs.push_back(elapsedMs / trials);
+        result.goodputBps.push_back(elapsedMs > 0.0 ? delivered * data.size() * 8 * 1000.0 / elapsedMs : 0.0);
+    }
+    return result;
+}
@@ -0,0 +1,282 @@
+#include "sliding_window.h"
+#include "trace.h"
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+enum class EventKind : uint8_t { FRAME, ACK, TIMEOUT };
+
+struct Event {
+    double time;
+    uint64_t order;                        // Ties resolve in scheduling order
+    EventKind kind;
+    uint8_t ack;                           // ACK: sequence number carried
+    uint64_t seq;                          // TIMEOUT: frame the timer guards
+    uint32_t generation;                   // TIMEOUT: stale unless it matches the timer's
+    std::vector<uint8_t> frame;            // FRAME: bytes as received
+    bool corrupted;                        // FRAME: bits were flipped on the way
+};
+
+struct Later {
+    bool operator()(const Event& a, const Event& b) const {
+        return a.time != b.time ? a.time > b.time : a.order > b.order;
+    }
+};
+
+double transmissionMs(size_t bytes, const ProtocolConfig& config) {
+    return config.bandwidthBps > 0.0 ? bytes * 8 * 1000.0 / config.bandwidthBps : 0.0;
+}
+
+uint32_t smallestSequenceBits(ArqProtocol protocol, uint32_t windowSize) {
+    uint64_t needed = protocol == ArqProtocol::GO_BACK_N ? uint64_t(windowSize) + 1 : uint64_t(windowSize) * 2;
+    uint32_t bits = 1;
+    while ((uint64_t(1) << bits) < needed) bits++;
+    return bits;
+}
+
+// Sequence numbers are absolute (0 .. count-1) inside the simulation and
+// reduced modulo the sequence space only in frames and ACKs
+class WindowSimulation {
+public:
+    WindowSimulation(const std::vector<uint8_t>& data, uint64_t count, const ProtocolConfig& config,
+                     const WindowConfig& window, uint64_t seed, uint64_t stream)
+        : data(data), count(count), config(config), protocol(window.protocol), windowSize(window.windowSize),
+          frameMs(transmissionMs(data.size() + 5, config)), ackMs(transmissionMs(1, config)),
+          acked(window.windowSize), received(window.windowSize), timers(window.windowSize),
+          attempts(window.windowSize), rng(seed, stream) {
+        stats.sequenceBits = window.sequenceBits ? window.sequenceBits
+                                                 : smallestSequenceBits(window.protocol, window.windowSize);
+        seqSpace = uint32_t(1) << stats.sequenceBits;
+        for (uint32_t seq = 0; seq < seqSpace; seq++) frames.push_back(buildFrame(data, int(seq)));
+    }
+
+    WindowStats run() {
+        fill();
+        while (base < count && !events.empty()) {
+            Event event = events.top();
+            events.pop();
+            now = event.time;
+            switch (event.kind) {
+                case EventKind::FRAME: onFrame(event.frame, event.corrupted); break;
+                case EventKind::ACK: onAck(event.ack); break;
+                case EventKind::TIMEOUT: onTimeout(event.seq, event.generation); break;
+            }
+        }
+        stats.elapsedMs = now;
+        if (now > 0.0) {
+            stats.goodputBps = stats.delivered * data.size() * 8 * 1000.0 / now;
+            stats.utilization = stats.delivered * frameMs / now;
+        }
+        return stats;
+    }
+
+private:
+    const std::vector<uint8_t>& data;
+    const uint64_t count;
+    const ProtocolConfig& config;
+    const ArqProtocol protocol;
+    const uint32_t windowSize;
+    const double frameMs;
+    const double ackMs;
+    uint32_t seqSpace = 0;
+    std::vector<std::vector<uint8_t>> frames;  // Every payload frame is one of these
+    WindowStats stats;
+
+    std::priority_queue<Event, std::vector<Event>, Later> events;
+    uint64_t order = 0;
+    double now = 0.0;
+    double dataLinkFree = 0.0;             // When each direction finishes its current frame
+    double ackLinkFree = 0.0;
+
+    // Sender: frames [base, next) are outstanding; per-frame state is kept in
+    // rings indexed by seq % windowSize
+    uint64_t base = 0;
+    uint64_t next = 0;
+    std::vector<uint8_t> acked;            // Selective-Repeat
+    uint32_t baseTimer = 0;                // Go-Back-N timer generation
+    // Receiver: next frame to hand up; Selective-Repeat buffers the window after it
+    uint64_t expected = 0;
+    std::vector<uint8_t> received;
+    std::vector<uint32_t> timers;          // Selective-Repeat timer generations
+    std::vector<uint32_t> attempts;
+
+    Xoshiro256pp rng;
+
+    void schedule(Event event) {
+        event.order = order++;
+        events.push(std::move(event));
+    }
+
+    void startTimer(uint64_t seq, uint32_t generation, double expiry) {
+        schedule({expiry, 0, EventKind::TIMEOUT, 0, seq, generation, {}, false});
+    }
+
+    void transmit(uint64_t seq) {
+        std::vector<uint8_t> frame = frames[seq % seqSpace];
+        double end = std::max(now, dataLinkFree) + frameMs;
+        dataLinkFree = end;
+        uint32_t& tries = attempts[seq % windowSize];
+        tries = seq == next ? 1 : tries + 1;
+        stats.transmissions++;
+        if (tries > 1) stats.retransmissions++;
+        NETSIM_TRACE(DEBUG, ARQ_SEND, seq, tries, next - base);
+
+        if (rng.uniform() >= config.lossProbability) {
+            bool corrupted;
+            if (config.corruption == CorruptionModel::FRAME) {
+                // One flipped bit, which the CRC always catches
+                corrupted = rng.uniform() < config.errorProbability;
+                if (corrupted) {
+                    uint64_t bit = rng.below(frame.size() * 8);
+                    frame[bit / 8] ^= uint8_t(1u << (bit % 8));
+                }
+            } else {
+                corrupted = applyBitErrors(frame.data(), frame.size(), config, rng) > 0;
+            }
+            schedule({end + config.propagationDelayMs, 0, EventKind::FRAME, 0, 0, 0, std::move(frame), corrupted});
+        }
+        if (protocol == ArqProtocol::SELECTIVE_REPEAT) {
+            startTimer(seq, ++timers[seq % windowSize], end + config.timeoutMs);
+        } else if (seq == base) {
+            startTimer(seq, ++baseTimer, end + config.timeoutMs);
+        }
+    }
+
+    // Send new frames while the window has room
+    void fill() {
+        while (next < count && next - base < windowSize) {
+            transmit(next);
+            next++;
+        }
+    }
+
+    void sendAck(uint64_t seq) {
+        double end = std::max(now, ackLinkFree) + ackMs;
+        ackLinkFree = end;
+        if (rng.uniform() >= config.ackLossProbability) {
+            schedule({end + config.propagationDelayMs, 0, EventKind::ACK, uint8_t(seq % seqSpace), 0, 0, {}, false});
+        }
+    }
+
+    void deliver() {
+        stats.delivered++;
+        expected++;
+    }
+
+    void onFrame(const std::vector<uint8_t>& frame, bool corrupted) {
+        uint32_t computedCRC = 0, receivedCRC = 0;
+        if (!verifyFrame(frame, computedCRC, receivedCRC)) {
+            NETSIM_TRACE(INFO, SW_CRC_ERROR, frame[0], computedCRC, receivedCRC);
+            stats.crcErrors++;
+            // Go-Back-N repeats its last cumulative ACK
+            if (protocol == ArqProtocol::GO_BACK_N && expected > 0) sendAck(expected - 1);
+            return;
+        }
+        if (corrupted) {
+            NETSIM_TRACE(WARN, SW_UNDETECTED_ERROR, frame[0], 0, 0);
+            stats.undetectedErrors++;
+        }
+        uint32_t offset = (frame[0] + seqSpace - expected % seqSpace) % seqSpace;
+        if (protocol == ArqProtocol::GO_BACK_N) {
+            if (offset == 0) {
+                deliver();
+                sendAck(expected - 1);
+            } else {
+                NETSIM_TRACE(INFO, SW_BAD_SEQUENCE, frame[0], expected % seqSpace, 0);
+                if (expected > 0) sendAck(expected - 1);
+            }
+            return;
+        }
+        // Selective-Repeat: offsets below the window are new frames, the
+        // rest are duplicates from the previous window whose ACK was lost
+        if (offset < windowSize) {
+            uint64_t seq = expected + offset;
+            received[seq % windowSize] = 1;
+            sendAck(seq);
+            while (received[expected % windowSize]) {
+                received[expected % windowSize] = 0;
+                deliver();
+            }
+        } else {
+            sendAck(expected + offset - seqSpace);
+        }
+    }
+
+    void onAck(uint8_t ack) {
+        uint64_t offset = (ack + seqSpace - base % seqSpace) % seqSpace;
+        if (offset >= next - base) return;     // Duplicate or stale
+        NETSIM_TRACE(DEBUG, ARQ_ACK, base, ack, 0);
+        if (protocol == ArqProtocol::GO_BACK_N) {
+            // Cumulative: everything up to this frame arrived
+            base += offset + 1;
+            if (base < next) {
+                startTimer(base, ++baseTimer, now + config.timeoutMs);
+            } else {
+                baseTimer++;
+            }
+        } else {
+            uint64_t seq = base + offset;
+            acked[seq % windowSize] = 1;
+            timers[seq % windowSize]++;
+            while (base < next && acked[base % windowSize]) {
+                acked[base % windowSize] = 0;
+                base++;
+            }
+        }
+        fill();
+    }
+
+    void onTimeout(uint64_t seq, uint32_t generation) {
+        if (protocol == ArqProtocol::GO_BACK_N) {
+            if (generation != baseTimer || base == next) return;
+            NETSIM_TRACE(INFO, ARQ_TIMEOUT, base, next - base, 0);
+            stats.timeouts++;
+            // Resend the whole window; the base frame restarts the timer
+            for (uint64_t s = base; s < next; s++) transmit(s);
+        } else {
+            if (generation != timers[seq % windowSize] || seq < base) return;
+            NETSIM_TRACE(INFO, ARQ_TIMEOUT, seq, next - base, 0);
+            stats.timeouts++;
+            transmit(seq);
+        }
+    }
+};
+
+} // namespace
+
+WindowStats simulateWindow(const std::vector<uint8_t>& data, uint64_t count, const ProtocolConfig& config,
+                           const WindowConfig& window, uint64_t seed, uint64_t stream) {
+    if (window.windowSize == 0) throw std::invalid_argument("windowSize must be at least 1");
+    uint32_t bits = window.sequenceBits ? window.sequenceBits
+                                        : smallestSequenceBits(window.protocol, window.windowSize);
+    if (bits > 8) {
+        throw std::invalid_argument("sequence numbers are one byte: sequenceBits must be at most 8");
+    }
+    uint64_t space = uint64_t(1) << bits;
+    uint64_t limit = window.protocol == ArqProtocol::GO_BACK_N ? space - 1 : space / 2;
+    if (window.windowSize > limit) {
+        throw std::invalid_argument("windowSize " + std::to_string(window.windowSize) + " does not fit " +
+                                    std::to_string(bits) + " sequence bits (at most " + std::to_string(limit) + ")");
+    }
+    if (config.lossProbability >= 1.0 || config.errorProbability >= 1.0 || config.ackLossProbability >= 1.0) {
+        throw std::invalid_argument("frames can never be delivered with a probability of 1");
+    }
+    WindowConfig resolved = window;
+    resolved.sequenceBits = bits;
+    return WindowSimulation(data, count, config, resolved, seed, stream).run();
+}
+
+std::vector<WindowStats> sweepWindowSizes(const std::vector<uint8_t>& data, uint64_t count,
+                                          const ProtocolConfig& config, ArqProtocol protocol,
+                                          const std::vector<uint32_t>& windowSizes, uint32_t sequenceBits,
+                                          uint64_t seed) {
+    std::vector<WindowStats> results;
+    results.reserve(windowSizes.size());
+    for (size_t i = 0; i < windowSizes.size(); i++) {
+        results.push_back(simulateWindow(data, count, config, {protocol, windowSizes[i], sequenceBits}, seed, i));
+    }
+    return results;
+}
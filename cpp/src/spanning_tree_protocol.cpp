@@ -0,0 +1,529 @@
+#include "spanning_tree_protocol.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using Time = uint64_t;
+
+// BPDU flags (RSTP only)
+constexpr uint8_t PROPOSAL = 1;
+constexpr uint8_t AGREEMENT = 2;
+
+constexpr uint64_t DEFAULT_PRIORITY = 32768;
+constexpr unsigned ADDRESS_BITS = 48;
+constexpr uint64_t NO_PORT = std::numeric_limits<uint64_t>::max();
+
+// Below this many bridges a batch is processed on the calling thread
+constexpr size_t PARALLEL_BRIDGES = 1024;
+
+// (root id, root path cost, designated bridge id, designated port id); lower is better
+template <typename Cost>
+struct PriorityVector {
+    uint64_t root;
+    Cost cost;
+    uint64_t bridge;
+    uint64_t port;
+
+    bool operator<(const PriorityVector& other) const {
+        return std::tie(root, cost, bridge, port) < std::tie(other.root, other.cost, other.bridge, other.port);
+    }
+    bool operator==(const PriorityVector& other) const {
+        return root == other.root && cost == other.cost && bridge == other.bridge && port == other.port;
+    }
+};
+
+template <typename Cost>
+struct Bpdu {
+    PriorityVector<Cost> vector;
+    uint32_t messageAge;
+    PortRole role;                         // Role of the sending port
+    uint8_t flags;
+};
+
+template <typename Cost>
+struct Arrival {
+    uint64_t arc;                          // Receiving port
+    Bpdu<Cost> bpdu;
+};
+
+struct TimerEvent {
+    uint64_t arc;
+    uint32_t generation;
+};
+
+// Events due at one instant
+template <typename Cost>
+struct Tick {
+    std::vector<uint64_t> failures;        // Edge ids
+    std::vector<TimerEvent> timers;
+    std::vector<uint64_t> hellos;          // Bridges
+    std::vector<Arrival<Cost>> bpdus;
+};
+
+// Whose information a port holds: none, its neighbour's, or our own as designated port
+enum class Info : uint8_t { AGED, RECEIVED, MINE };
+
+template <typename Cost>
+struct Port {
+    PriorityVector<Cost> priority{};
+    Time expires = 0;                      // When received information ages out
+    uint32_t messageAge = 0;
+    uint32_t generation = 0;               // Bumped to cancel the pending forward delay timer
+    Info info = Info::AGED;
+    PortRole role = PortRole::DISABLED;
+    PortState state = PortState::DISCARDING;
+    bool disabled = false;                 // Link down
+    bool timing = false;
+    bool proposing = false;
+    bool proposed = false;
+    bool agreed = false;
+    bool agree = false;                    // Answer a proposal on the next transmission
+    bool send = false;
+};
+
+template <typename Cost>
+struct Bridge {
+    PriorityVector<Cost> root{};
+    uint64_t rootPort = NO_PORT;
+    uint32_t rootAge = 0;                  // Message age of the root port's information
+    bool reselect = true;
+    bool sync = false;
+    bool hello = false;
+    Time lastChange = 0;
+    uint64_t changes = 0;
+    std::vector<std::pair<uint64_t, Bpdu<Cost>>> outbox;
+    std::vector<TimerEvent> timers;
+};
+
+template <typename G>
+class Simulation {
+public:
+    using Index = typename G::Index;
+    using Cost = WeightSum<typename G::Weight>;
+
+    Simulation(const G& graph, const StpConfig& config, const std::vector<uint16_t>& priorities)
+        : config(config), g(graph.csr()), n(graph.numVertices()), arcs(g.targets.size()) {
+        if (static_cast<uint64_t>(n) >> ADDRESS_BITS) {
+            throw std::length_error("spanningTreeProtocol: too many bridges for 48-bit addresses");
+        }
+        if (!priorities.empty() && priorities.size() != static_cast<size_t>(n)) {
+            throw std::invalid_argument("spanningTreeProtocol: one priority per bridge expected");
+        }
+        if (config.helloTime == 0 || config.forwardDelay == 0 || config.bpduDelay == 0) {
+            throw std::invalid_argument("spanningTreeProtocol: timers must be positive");
+        }
+        ids.resize(n);
+        owner.resize(arcs);
+        for (Index v = 0; v < n; v++) {
+            uint64_t priority = priorities.empty() ? DEFAULT_PRIORITY : priorities[v];
+            ids[v] = (priority << ADDRESS_BITS) | v;
+            for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+                if (g.weights[a] < 0) throw std::invalid_argument("spanningTreeProtocol: negative path cost");
+                owner[a] = v;
+            }
+        }
+        // Both ends of every edge; for u < v the end at u comes first
+        ends.assign(arcs, NO_PORT);
+        for (uint64_t a = 0; a < arcs; a++) {
+            uint64_t slot = 2 * static_cast<uint64_t>(g.edgeIds[a]);
+            ends[ends[slot] == NO_PORT ? slot : slot + 1] = a;
+        }
+        twin.resize(arcs);
+        for (uint64_t e = 0; e < arcs / 2; e++) {
+            twin[ends[2 * e]] = ends[2 * e + 1];
+            twin[ends[2 * e + 1]] = ends[2 * e];
+        }
+        ports.resize(arcs);
+        bridges.resize(n);
+        for (Index v = 0; v < n; v++) bridges[v].root = {ids[v], 0, ids[v], 0};
+    }
+
+    StpResult<G> run(const std::vector<std::pair<uint64_t, Index>>& failures) {
+        std::map<Time, Tick<Cost>> calendar;
+        Tick<Cost>& boot = calendar[0];
+        for (Index v = 0; v < n; v++) boot.hellos.push_back(v);
+        Time lastFailure = 0;
+        for (const auto& failure : failures) {
+            if (static_cast<uint64_t>(failure.second) >= arcs / 2) {
+                throw std::out_of_range("spanningTreeProtocol: failed edge out of range");
+            }
+            calendar[failure.first].failures.push_back(failure.second);
+            lastFailure = std::max(lastFailure, failure.first);
+        }
+        size_t pendingFailures = failures.size();
+
+        // Timers started by the last change have all fired by then, and any
+        // information it left stale has aged out
+        const Time settle = std::max<Time>(config.maxAge, 2 * Time(config.forwardDelay)) + 2 * Time(config.helloTime);
+        const Time limit = config.duration ? config.duration : lastFailure + 64 * settle;
+
+        StpResult<G> result;
+        std::vector<uint8_t> marked(n, 0);
+        std::vector<Index> dirty;
+        std::vector<size_t> batch;
+        Time lastChange = 0, now = 0;
+        bool settled = false;
+
+        while (!calendar.empty()) {
+            auto first = calendar.begin();
+            if (first->first > limit) break;
+            if (!config.duration && pendingFailures == 0 && first->first >= lastChange + settle) {
+                settled = true;
+                break;
+            }
+            now = first->first;
+            Tick<Cost> tick = std::move(first->second);
+            calendar.erase(first);
+            result.ticks++;
+            result.bpdus += tick.bpdus.size();
+            dirty.clear();
+            auto mark = [&](Index v) {
+                if (!marked[v]) {
+                    marked[v] = 1;
+                    dirty.push_back(v);
+                }
+            };
+
+            for (uint64_t e : tick.failures) {
+                for (uint64_t a : {ends[2 * e], ends[2 * e + 1]}) {
+                    ports[a].disabled = true;
+                    ports[a].info = Info::AGED;
+                    bridges[owner[a]].reselect = true;
+                    mark(owner[a]);
+                }
+                pendingFailures--;
+            }
+            for (const TimerEvent& timer : tick.timers) {
+                Port<Cost>& p = ports[timer.arc];
+                if (!p.timing || p.generation != timer.generation) continue;
+                forwardDelayExpired(timer.arc, now);
+                mark(owner[timer.arc]);
+            }
+            if (!tick.hellos.empty()) {
+                Tick<Cost>& next = calendar[now + config.helloTime];
+                for (uint64_t v : tick.hellos) {
+                    bridges[v].hello = true;
+                    mark(static_cast<Index>(v));
+                    next.hellos.push_back(v);
+                }
+            }
+            std::sort(tick.bpdus.begin(), tick.bpdus.end(),
+                      [](const Arrival<Cost>& a, const Arrival<Cost>& b) { return a.arc < b.arc; });
+            for (const Arrival<Cost>& arrival : tick.bpdus) mark(owner[arrival.arc]);
+
+            // Arrivals are sorted by port, so each bridge's batch is a contiguous range
+            std::sort(dirty.begin(), dirty.end());
+            batch.assign(dirty.size() + 1, 0);
+            size_t cursor = 0;
+            for (size_t i = 0; i < dirty.size(); i++) {
+                while (cursor < tick.bpdus.size() && owner[tick.bpdus[cursor].arc] < dirty[i]) cursor++;
+                batch[i] = cursor;
+            }
+            batch[dirty.size()] = tick.bpdus.size();
+
+            parallelFor(0, dirty.size(), dirty.size() >= PARALLEL_BRIDGES ? config.threads : 1, [&](size_t i) {
+                processBridge(dirty[i], tick.bpdus.data() + batch[i], tick.bpdus.data() + batch[i + 1], now);
+            }, 64);
+
+            Tick<Cost>* delivery = nullptr;
+            Tick<Cost>* expiry = nullptr;
+            for (Index v : dirty) {
+                Bridge<Cost>& b = bridges[v];
+                marked[v] = 0;
+                if (!b.outbox.empty()) {
+                    if (!delivery) delivery = &calendar[now + config.bpduDelay];
+                    for (const auto& out : b.outbox) delivery->bpdus.push_back({twin[out.first], out.second});
+                    b.outbox.clear();
+                }
+                if (!b.timers.empty()) {
+                    if (!expiry) expiry = &calendar[now + config.forwardDelay];
+                    expiry->timers.insert(expiry->timers.end(), b.timers.begin(), b.timers.end());
+                    b.timers.clear();
+                }
+                lastChange = std::max(lastChange, b.lastChange);
+            }
+        }
+
+        if (calendar.empty()) settled = true;
+        result.endTime = settled ? std::max(now, lastChange + settle) : limit;
+        result.convergenceTime = lastChange;
+        collect(result, settled);
+        return result;
+    }
+
+private:
+    const StpConfig& config;
+    const typename G::CSR& g;
+    const Index n;
+    const uint64_t arcs;
+    std::vector<uint64_t> ids;             // Bridge id: priority in the top 16 bits, vertex below
+    std::vector<Index> owner;              // Bridge of each port
+    std::vector<uint64_t> ends;            // Ports of edge e at 2e and 2e + 1
+    std::vector<uint64_t> twin;            // Port at the other end of the link
+    std::vector<Port<Cost>> ports;
+    std::vector<Bridge<Cost>> bridges;
+
+    uint64_t portId(uint64_t a) const { return a - g.offsets[owner[a]] + 1; }
+
+    void changed(Bridge<Cost>& b, Time now) {
+        b.lastChange = now;
+        b.changes++;
+    }
+
+    void setState(Bridge<Cost>& b, Port<Cost>& p, PortState state, Time now) {
+        if (p.state == state) return;
+        p.state = state;
+        changed(b, now);
+    }
+
+    void startTimer(Bridge<Cost>& b, Port<Cost>& p, uint64_t a) {
+        p.timing = true;
+        b.timers.push_back({a, ++p.generation});
+    }
+
+    void cancelTimer(Port<Cost>& p) {
+        p.timing = false;
+        ++p.generation;
+    }
+
+    // Listening (802.1D) or discarding (RSTP fallback) -> learning -> forwarding
+    void forwardDelayExpired(uint64_t a, Time now) {
+        Port<Cost>& p = ports[a];
+        Bridge<Cost>& b = bridges[owner[a]];
+        p.timing = false;
+        if (p.state == PortState::LEARNING) {
+            setState(b, p, PortState::FORWARDING, now);
+            p.proposing = false;
+        } else {
+            setState(b, p, PortState::LEARNING, now);
+            startTimer(b, p, a);
+        }
+    }
+
+    void setRole(Bridge<Cost>& b, Port<Cost>& p, uint64_t a, PortRole role, Time now) {
+        if (p.role == role) return;
+        p.role = role;
+        changed(b, now);
+        if (role == PortRole::ROOT || role == PortRole::DESIGNATED) {
+            if (config.rapid) {
+                if (role == PortRole::ROOT) {
+                    // Rapid root port transition: the old root port is an alternate now
+                    if (p.timing) cancelTimer(p);
+                    setState(b, p, PortState::FORWARDING, now);
+                } else if (p.state != PortState::FORWARDING) {
+                    p.proposing = true;
+                    if (!p.timing) startTimer(b, p, a);
+                }
+            } else if (p.state == PortState::DISCARDING) {
+                setState(b, p, PortState::LISTENING, now);
+                startTimer(b, p, a);
+            }
+        } else {
+            if (p.timing) cancelTimer(p);
+            setState(b, p, PortState::DISCARDING, now);
+            p.proposing = false;
+            p.agreed = false;
+        }
+    }
+
+    // Root port and port roles from the information held on each port
+    void selectRoles(Index v, Time now) {
+        Bridge<Cost>& b = bridges[v];
+        const uint64_t self = ids[v];
+        b.reselect = false;
+
+        PriorityVector<Cost> best{self, 0, self, 0};
+        uint64_t rootPort = NO_PORT;
+        for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+            const Port<Cost>& p = ports[a];
+            if (p.disabled || p.info != Info::RECEIVED || p.priority.bridge == self) continue;
+            PriorityVector<Cost> path{p.priority.root, p.priority.cost + g.weights[a], p.priority.bridge, p.priority.port};
+            if (path < best) {
+                best = path;
+                rootPort = a;
+            }
+        }
+        if (!(best.root == b.root.root && best.cost == b.root.cost) || rootPort != b.rootPort) b.sync = true;
+        b.root = best;
+        b.rootPort = rootPort;
+        b.rootAge = rootPort == NO_PORT ? 0 : ports[rootPort].messageAge;
+
+        for (uint64_t a = g.offsets[v]; a < g.offsets[v + 1]; a++) {
+            Port<Cost>& p = ports[a];
+            PriorityVector<Cost> designated{best.root, best.cost, self, portId(a)};
+            PortRole role;
+            if (p.disabled) {
+                role = PortRole::DISABLED;
+            } else if (a == rootPort) {
+                role = PortRole::ROOT;
+            } else if (p.info != Info::RECEIVED || designated < p.priority) {
+                role = PortRole::DESIGNATED;
+                if (p.info != Info::MINE || !(p.priority == designated)) {
+                    p.priority = designated;
+                    p.info = Info::MINE;
+                    p.agreed = false;
+                    p.send = true;
+                }
+            } else {
+                role = p.priority.bridge == self ? PortRole::BACKUP : PortRole::ALTERNATE;
+            }
+            setRole(b, p, a, role, now);
+        }
+    }
+
+    // One bridge's batch for this instant: aging, received BPDUs, role
+    // selection, RSTP sync, then at most one BPDU per port
+    void processBridge(Index v, const Arrival<Cost>* begin, const Arrival<Cost>* end, Time now) {
+        Bridge<Cost>& b = bridges[v];
+        const uint64_t first = g.offsets[v], last = g.offsets[v + 1];
+        bool relay = false;
+
+        for (uint64_t a = first; a < last; a++) {
+            if (ports[a].info == Info::RECEIVED && ports[a].expires <= now) {
+                ports[a].info = Info::AGED;
+                b.reselect = true;
+            }
+        }
+
+        for (const Arrival<Cost>* arrival = begin; arrival != end; arrival++) {
+            Port<Cost>& p = ports[arrival->arc];
+            const Bpdu<Cost>& m = arrival->bpdu;
+            if (p.disabled || m.messageAge >= config.maxAge) continue;
+            if (m.role == PortRole::DESIGNATED) {
+                // Superior information, or anything from the port we already listen to
+                bool sameSender = p.info == Info::RECEIVED && p.priority.bridge == m.vector.bridge &&
+                                  p.priority.port == m.vector.port;
+                if (p.info == Info::AGED || m.vector < p.priority || sameSender) {
+                    if (!sameSender || !(p.priority == m.vector)) b.reselect = true;
+                    p.priority = m.vector;
+                    p.info = Info::RECEIVED;
+                    p.messageAge = m.messageAge;
+                    uint32_t lifetime = config.maxAge - m.messageAge;
+                    if (config.rapid) lifetime = std::min(lifetime, 3 * config.helloTime);
+                    p.expires = now + lifetime;
+                    if (arrival->arc == b.rootPort) relay = true;
+                    if (m.flags & PROPOSAL) p.proposed = true;
+                } else if (p.info == Info::MINE) {
+                    // The neighbour has not heard our better information yet
+                    p.send = true;
+                }
+            } else if ((m.flags & AGREEMENT) && p.role == PortRole::DESIGNATED && p.info == Info::MINE &&
+                       m.vector == p.priority) {
+                p.agreed = true;
+            }
+        }
+
+        if (b.reselect) selectRoles(v, now);
+
+        if (config.rapid) {
+            // A new root, or a proposal on the root port, blocks every
+            // designated port that has not agreed; the root port can then agree
+            bool sync = b.sync || (b.rootPort != NO_PORT && ports[b.rootPort].proposed);
+            for (uint64_t a = first; a < last; a++) {
+                Port<Cost>& p = ports[a];
+                if (p.role == PortRole::DESIGNATED) {
+                    if (p.agreed) {
+                        if (p.timing) cancelTimer(p);
+                        setState(b, p, PortState::FORWARDING, now);
+                        p.proposing = false;
+                    } else if (sync && !p.proposing) {
+                        setState(b, p, PortState::DISCARDING, now);
+                        if (p.timing) cancelTimer(p);
+                        startTimer(b, p, a);
+                        p.proposing = true;
+                        p.send = true;
+                    }
+                } else if (p.proposed) {
+                    // Root port after the sync above; alternate and backup ports are discarding already
+                    p.proposed = false;
+                    p.agree = true;
+                    p.send = true;
+                }
+            }
+        }
+        b.sync = false;
+
+        if (b.hello) {
+            b.hello = false;
+            if (config.rapid || b.rootPort == NO_PORT) relay = true;
+        }
+
+        const uint32_t age = b.rootPort == NO_PORT ? 0 : b.rootAge + config.messageAgeIncrement;
+        for (uint64_t a = first; a < last; a++) {
+            Port<Cost>& p = ports[a];
+            if (p.role == PortRole::DESIGNATED && (p.send || relay)) {
+                uint8_t flags = config.rapid && p.proposing && p.state != PortState::FORWARDING ? PROPOSAL : 0;
+                b.outbox.push_back({a, {p.priority, age, PortRole::DESIGNATED, flags}});
+            } else if (p.agree && p.role != PortRole::DISABLED) {
+                b.outbox.push_back({a, {p.priority, 0, p.role, AGREEMENT}});
+            }
+            p.send = false;
+            p.agree = false;
+        }
+    }
+
+    void collect(StpResult<G>& result, bool settled) const {
+        const uint64_t edges = arcs / 2;
+        result.roles.resize(arcs);
+        result.states.resize(arcs);
+        result.active.assign(edges, 0);
+        result.converged = true;
+        for (uint64_t i = 0; i < arcs; i++) {
+            const Port<Cost>& p = ports[ends[i]];
+            result.roles[i] = static_cast<uint8_t>(p.role);
+            result.states[i] = static_cast<uint8_t>(p.state);
+            bool forwarding = p.role == PortRole::ROOT || p.role == PortRole::DESIGNATED;
+            if (p.timing || p.state != (forwarding ? PortState::FORWARDING : PortState::DISCARDING)) {
+                result.converged = false;
+            }
+        }
+        if (!config.duration && !settled) result.converged = false;
+
+        UnionFind<Index> forest(n);
+        result.loopFree = true;
+        for (uint64_t e = 0; e < edges; e++) {
+            if (ports[ends[2 * e]].state != PortState::FORWARDING || ports[ends[2 * e + 1]].state != PortState::FORWARDING) {
+                continue;
+            }
+            result.active[e] = 1;
+            if (!forest.unite(owner[ends[2 * e]], owner[ends[2 * e + 1]])) result.loopFree = false;
+        }
+
+        const uint64_t address = (uint64_t(1) << ADDRESS_BITS) - 1;
+        result.rootBridge.resize(n);
+        result.rootCost.resize(n);
+        result.parentOf.assign(n, G::NO_VERTEX);
+        result.rootPortEdge.assign(n, G::NO_VERTEX);
+        for (Index v = 0; v < n; v++) {
+            const Bridge<Cost>& b = bridges[v];
+            result.rootBridge[v] = static_cast<Index>(b.root.root & address);
+            result.rootCost[v] = b.root.cost;
+            result.changes += b.changes;
+            if (b.rootPort != NO_PORT) {
+                result.parentOf[v] = owner[twin[b.rootPort]];
+                result.rootPortEdge[v] = g.edgeIds[b.rootPort];
+            }
+        }
+    }
+};
+
+} // namespace
+
+template <typename G>
+StpResult<G> simulateSpanningTree(const G& graph, const StpConfig& config, const std::vector<uint16_t>& priorities,
+                                  const std::vector<std::pair<uint64_t, typename G::Index>>& failures) {
+    Simulation<G> simulation(graph, config, priorities);
+    return simulation.run(failures);
+}
+
+#define NETSIM_INSTANTIATE_STP(I, W, NAME)                                                                    \
+    template StpResult<BasicGraph<I, W>> simulateSpanningTree(const BasicGraph<I, W>&, const StpConfig&,     \
+        const std::vector<uint16_t>&, const std::vector<std::pair<uint64_t, I>>&);
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_STP)
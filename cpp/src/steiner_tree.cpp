@@ -0,0 +1,151 @@
+#include "steiner_tree.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+// Per-thread scratch sized to the graph; only the entries a query touched
+// are reset afterwards
+template <typename G>
+struct SteinerTreeBuilder<G>::Workspace {
+    std::vector<Distance> dist;
+    std::vector<Index> region;             // Index of the nearest terminal
+    std::vector<Index> viaEdge;            // Edge towards that terminal
+    std::vector<Index> touched;
+    std::vector<std::pair<Distance, Index>> heap;
+    std::vector<std::tuple<Distance, Index, Index>> crossing;  // length, edge id, arc owner
+    std::vector<uint8_t> used;             // Edge already in the tree
+    UnionFind<Index> regions;
+
+    Workspace(Index n, size_t m)
+        : dist(n, std::numeric_limits<Distance>::max()), region(n), viaEdge(n), used(m, 0) {}
+};
+
+template <typename G>
+SteinerTreeBuilder<G>::SteinerTreeBuilder(const G& graph) : graph(graph), edges(graph.edgeList()) {
+    for (const auto& e : edges) {
+        if (e.weight < typename G::Weight(0)) throw std::invalid_argument("SteinerTreeBuilder: negative edge weight");
+    }
+    graph.csr();
+}
+
+template <typename G>
+SteinerTree<G> SteinerTreeBuilder<G>::build(const std::vector<Index>& terminals) const {
+    Workspace work(graph.numVertices(), edges.size());
+    return build(terminals, work);
+}
+
+template <typename G>
+std::vector<SteinerTree<G>> SteinerTreeBuilder<G>::buildBatch(const std::vector<std::vector<Index>>& groups,
+                                                               unsigned threads) const {
+    for (const auto& group : groups) {
+        for (Index t : group) {
+            if (t >= graph.numVertices()) throw std::out_of_range("SteinerTreeBuilder: terminal out of range");
+        }
+    }
+    std::vector<SteinerTree<G>> trees(groups.size());
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(1, groups.size())));
+    std::atomic<size_t> next(0);
+    parallelRun(workers, [&](unsigned) {
+        Workspace work(graph.numVertices(), edges.size());
+        for (size_t i = next++; i < groups.size(); i = next++) trees[i] = build(groups[i], work);
+    });
+    return trees;
+}
+
+template <typename G>
+SteinerTree<G> SteinerTreeBuilder<G>::build(const std::vector<Index>& terminals, Workspace& work) const {
+    const auto& g = graph.csr();
+    const Index NONE = G::NO_VERTEX;
+    const Distance INF = std::numeric_limits<Distance>::max();
+    using Entry = std::pair<Distance, Index>;
+    auto later = std::greater<Entry>();
+
+    // Voronoi regions: multi-source Dijkstra, duplicate terminals ignored
+    Index k = 0;
+    work.heap.clear();
+    for (Index t : terminals) {
+        if (t >= graph.numVertices()) throw std::out_of_range("SteinerTreeBuilder: terminal out of range");
+        if (work.dist[t] == 0) continue;
+        work.dist[t] = 0;
+        work.region[t] = k++;
+        work.viaEdge[t] = NONE;
+        work.touched.push_back(t);
+        work.heap.push_back({0, t});
+    }
+    std::make_heap(work.heap.begin(), work.heap.end(), later);
+    while (!work.heap.empty()) {
+        std::pop_heap(work.heap.begin(), work.heap.end(), later);
+        Entry top = work.heap.back();
+        work.heap.pop_back();
+        Index u = top.second;
+        if (top.first > work.dist[u]) continue;
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index v = g.targets[a];
+            Distance nd = top.first + g.weights[a];
+            if (nd < work.dist[v]) {
+                if (work.dist[v] == INF) work.touched.push_back(v);
+                work.dist[v] = nd;
+                work.region[v] = work.region[u];
+                work.viaEdge[v] = g.edgeIds[a];
+                work.heap.push_back({nd, v});
+                std::push_heap(work.heap.begin(), work.heap.end(), later);
+            }
+        }
+    }
+
+    // Edges between regions, each seen from its lower-region endpoint, give
+    // the terminal distance network; Kruskal picks its MST
+    work.crossing.clear();
+    for (Index u : work.touched) {
+        for (uint64_t a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            Index v = g.targets[a];
+            if (work.region[u] >= work.region[v]) continue;
+            work.crossing.emplace_back(work.dist[u] + g.weights[a] + work.dist[v], g.edgeIds[a], u);
+        }
+    }
+    std::sort(work.crossing.begin(), work.crossing.end());
+    work.regions.reset(k);
+
+    SteinerTree<G> tree;
+    Index joined = 0;
+    auto take = [&](Index e) {
+        if (work.used[e]) return false;
+        work.used[e] = 1;
+        tree.edges.push_back(e);
+        tree.weight += edges[e].weight;
+        return true;
+    };
+    // Walk from v back to its terminal, stopping at the part already taken
+    auto expand = [&](Index v) {
+        while (work.viaEdge[v] != NONE && take(work.viaEdge[v])) {
+            const auto& e = edges[work.viaEdge[v]];
+            v = e.u == v ? e.v : e.u;
+        }
+    };
+    for (const auto& candidate : work.crossing) {
+        if (joined + 1 >= k) break;
+        Index e = std::get<1>(candidate);
+        Index u = std::get<2>(candidate);
+        Index v = edges[e].u == u ? edges[e].v : edges[e].u;
+        if (!work.regions.unite(work.region[u], work.region[v])) continue;
+        joined++;
+        take(e);
+        expand(u);
+        expand(v);
+    }
+    tree.connected = k == 0 || joined + 1 == k;
+
+    for (Index e : tree.edges) work.used[e] = 0;
+    for (Index v : work.touched) work.dist[v] = INF;
+    work.touched.clear();
+    std::sort(tree.edges.begin(), tree.edges.end());
+    return tree;
+}
+
+#define NETSIM_INSTANTIATE_STEINER(I, W, NAME) template class SteinerTreeBuilder<BasicGraph<I, W>>;
+NETSIM_FOR_EACH_GRAPH_TYPE(NETSIM_INSTANTIATE_STEINER)
@@ -1,70 +1,257 @@
 #include "stop_and_wait.h"
-#include <iostream>
-#include <random>
+#include "realtime_loop.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <thread>
 #include <chrono>
 
-// CRC computation
-uint32_t computeCRC(const std::vector<uint8_t>& data) {
-    uint32_t crc = 0xFFFFFFFF;
-    for (uint8_t byte : data) {
-        crc ^= byte;
-        for (int i = 0; i < 8; i++) {
-            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+// CRC-32 lookup tables for slicing-by-8: table[k][b] is the CRC of byte b
+// followed by k zero bytes
+struct CrcTables {
+    uint32_t table[8][256];
+
+    CrcTables() {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b;
+            for (int i = 0; i < 8; i++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; b++) {
+            for (int k = 1; k < 8; k++) {
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+            }
         }
     }
+};
+
+static const CrcTables CRC_TABLES;
+
+// CRC computation, eight bytes per step
+static uint32_t computeCRC(const uint8_t* data, size_t size) {
+    const auto& t = CRC_TABLES.table;
+    uint32_t crc = 0xFFFFFFFF;
+    size_t j = 0;
+    for (; j + 8 <= size; j += 8) {
+        uint32_t low = crc ^ (data[j] | data[j + 1] << 8 | data[j + 2] << 16 | uint32_t(data[j + 3]) << 24);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][data[j + 4]] ^ t[2][data[j + 5]] ^ t[1][data[j + 6]] ^ t[0][data[j + 7]];
+    }
+    for (; j < size; j++) {
+        crc = (crc >> 8) ^ t[0][(crc ^ data[j]) & 0xFF];
+    }
     return ~crc;
 }
 
-// Simulate network conditions (errors, losses, and ACK loss)
-bool simulateNetworkConditions(const std::vector<uint8_t>& packet, const ProtocolConfig& config, bool isAck) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> dis(0.0, 1.0);
+static void writeCRC(uint8_t* out, uint32_t crc) {
+    out[0] = (crc >> 24) & 0xFF;
+    out[1] = (crc >> 16) & 0xFF;
+    out[2] = (crc >> 8) & 0xFF;
+    out[3] = crc & 0xFF;
+}
+
+std::vector<uint8_t> buildFrame(const std::vector<uint8_t>& data, int seqNum) {
+    // Add sequence number as the first byte
+    std::vector<uint8_t> frame(data.size() + 5);
+    frame[0] = static_cast<uint8_t>(seqNum & 0xFF);
+    std::copy(data.begin(), data.end(), frame.begin() + 1);
+    // Compute CRC for the data (including seqNum)
+    writeCRC(&frame[data.size() + 1], computeCRC(frame.data(), data.size() + 1));
+    return frame;
+}
+
+void framePacket(PacketBuffer& packet, int seqNum) {
+    *packet.push(1) = static_cast<uint8_t>(seqNum & 0xFF);
+    uint32_t crc = computeCRC(packet.data(), packet.size());
+    writeCRC(packet.put(4), crc);
+}
+
+bool verifyFrame(const uint8_t* frame, size_t size, uint32_t& computedCRC, uint32_t& receivedCRC) {
+    if (size < 5) return false; // At least seqNum + CRC
+    computedCRC = computeCRC(frame, size - 4);
+    receivedCRC = (frame[size - 4] << 24) |
+                  (frame[size - 3] << 16) |
+                  (frame[size - 2] << 8) |
+                  frame[size - 1];
+    return computedCRC == receivedCRC;
+}
 
+bool verifyFrame(const std::vector<uint8_t>& frame, uint32_t& computedCRC, uint32_t& receivedCRC) {
+    return verifyFrame(frame.data(), frame.size(), computedCRC, receivedCRC);
+}
+
+// Simulate network conditions (errors, losses, and ACK loss) for a frame of
+// `bytes` bytes
+static bool linkConditions(size_t bytes, const ProtocolConfig& config, Xoshiro256pp& rng, bool isAck) {
     if (isAck) {
-        if (dis(gen) < config.ackLossProbability) {
-            std::cout << "ACK lost!" << std::endl;
+        if (rng.uniform() < config.ackLossProbability) {
+            NETSIM_TRACE(INFO, SW_ACK_LOST, 0, 0, 0);
             return false;
         }
     } else {
         // Simulate packet loss
-        if (dis(gen) < config.lossProbability) {
-            std::cout << "Packet lost!" << std::endl;
+        if (rng.uniform() < config.lossProbability) {
+            NETSIM_TRACE(INFO, SW_LOST, bytes, 0, 0);
             return false;
         }
-        // Simulate packet corruption
-        if (dis(gen) < config.errorProbability) {
-            std::cout << "Packet corrupted!" << std::endl;
+        // Simulate packet corruption (the bit-level models corrupt the bytes instead)
+        if (config.corruption == CorruptionModel::FRAME && rng.uniform() < config.errorProbability) {
+            NETSIM_TRACE(INFO, SW_CORRUPTED, bytes, 0, 0);
             return false;
         }
     }
     return true;
 }
 
+bool simulateNetworkConditions(const std::vector<uint8_t>& packet, const ProtocolConfig& config, Xoshiro256pp& rng,
+                               bool isAck) {
+    return linkConditions(packet.size(), config, rng, isAck);
+}
+
+// Bits flipped by the BIT_ERRORS or BURST channel in a frame of `bits` bits,
+// passed to flip() in increasing order. Bursts are cut off at the frame end.
+template <typename Flip>
+static uint32_t drawBitErrors(uint64_t bits, const ProtocolConfig& config, Xoshiro256pp& rng, Flip&& flip) {
+    if (config.corruption == CorruptionModel::FRAME || config.bitErrorRate <= 0.0) return 0;
+    const double logq = config.bitErrorRate < 1.0 ? std::log1p(-config.bitErrorRate) : 0.0;
+    // Clean bits before the next error or burst
+    auto gap = [&]() -> uint64_t {
+        if (logq == 0.0) return 0;
+        return static_cast<uint64_t>(std::min(std::floor(std::log1p(-rng.uniform()) / logq), 9.0e18));
+    };
+    const uint64_t burst = std::max<uint32_t>(config.burstLength, 1);
+    uint32_t flipped = 0;
+    for (uint64_t bit = gap(); bit < bits;) {
+        if (config.corruption == CorruptionModel::BIT_ERRORS) {
+            flip(bit);
+            flipped++;
+            bit += 1 + gap();
+            continue;
+        }
+        uint64_t end = std::min(bit + burst, bits);
+        for (uint64_t b = bit; b < end; b++) {
+            if (b == bit || b == bit + burst - 1 || (rng() >> 63)) {
+                flip(b);
+                flipped++;
+            }
+        }
+        bit += burst + gap();
+    }
+    return flipped;
+}
+
+static void flipBit(uint8_t* frame, uint64_t bit) {
+    frame[bit / 8] ^= static_cast<uint8_t>(0x80 >> (bit % 8));
+}
+
+uint32_t applyBitErrors(uint8_t* frame, size_t size, const ProtocolConfig& config, Xoshiro256pp& rng) {
+    return drawBitErrors(size * 8, config, rng, [&](uint64_t bit) { flipBit(frame, bit); });
+}
+
+// Carry a data frame across the link: false if it is lost, or corrupted and
+// rejected by the receiver's CRC. Bit errors go into a pooled copy made at
+// the first flip, so clean frames are never copied and the original stays
+// intact for retransmission.
+static bool deliverFrame(const PacketBuffer& packet, int seqNum, const ProtocolConfig& config, SimClock& clock) {
+    if (!linkConditions(packet.size(), config, clock.rng, false)) return false;
+    PacketBuffer received;
+    uint32_t flipped = drawBitErrors(packet.size() * 8, config, clock.rng, [&](uint64_t bit) {
+        if (received.empty()) {
+            received = clock.pool.acquire(packet.size());
+            received.append(packet.data(), packet.size());
+        }
+        flipBit(received.data(), bit);
+    });
+    if (flipped == 0) return true;
+    NETSIM_TRACE(INFO, SW_BIT_ERRORS, packet.size(), flipped, 0);
+    uint32_t computedCRC, receivedCRC;
+    if (!verifyFrame(received.data(), received.size(), computedCRC, receivedCRC)) {
+        NETSIM_TRACE(INFO, SW_CRC_ERROR, received.data()[0], computedCRC, receivedCRC);
+        clock.crcErrors++;
+        return false;
+    }
+    NETSIM_TRACE(WARN, SW_UNDETECTED_ERROR, seqNum, flipped, 0);
+    clock.undetectedErrors++;
+    return true;
+}
+
+// Randomly seeded generator private to the calling thread
+static Xoshiro256pp& threadRng() {
+    thread_local Xoshiro256pp rng(randomSeed());
+    return rng;
+}
+
+bool simulateNetworkConditions(const std::vector<uint8_t>& packet, const ProtocolConfig& config, bool isAck) {
+    return linkConditions(packet.size(), config, threadRng(), isAck);
+}
+
+// Time to clock `bytes` onto the link
+static double transmissionMs(size_t bytes, const ProtocolConfig& config) {
+    return config.bandwidthBps > 0.0 ? bytes * 8 * 1000.0 / config.bandwidthBps : 0.0;
+}
+
+// How often a real-time sender checks for its ACK
+constexpr auto ACK_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+// Stop-and-Wait on the virtual clock: each attempt either completes after one
+// round trip or costs the timeout, without waiting
+static bool sendVirtual(const PacketBuffer& packet, std::vector<uint8_t>& ack, int& seqNum,
+                        const ProtocolConfig& config, SimClock& clock) {
+    const double frameMs = transmissionMs(packet.size(), config);
+    const double roundTripMs = frameMs + 2 * config.propagationDelayMs + transmissionMs(1, config);
+    for (int retries = 0; retries < config.maxRetries; retries++) {
+        NETSIM_TRACE(DEBUG, SW_SEND, seqNum, retries + 1, packet.size());
+        clock.frames++;
+        if (!deliverFrame(packet, seqNum, config, clock) || roundTripMs >= config.timeoutMs ||
+            !linkConditions(1, config, clock.rng, true)) {
+            NETSIM_TRACE(INFO, SW_TIMEOUT, seqNum, retries + 1, 0);
+            clock.nowMs += frameMs + config.timeoutMs;
+            continue;
+        }
+        clock.nowMs += roundTripMs;
+        ack.assign(1, static_cast<uint8_t>(seqNum & 0xFF));
+        NETSIM_TRACE(DEBUG, SW_ACKED, seqNum, retries + 1, 0);
+        seqNum = (seqNum + 1) % 2;
+        return true;
+    }
+    NETSIM_TRACE(WARN, SW_GAVE_UP, seqNum, config.maxRetries, 0);
+    return false;
+}
+
+// Clock private to the calling thread: sends without a clock of their own
+// reuse its generator and buffer pool instead of building them per frame
+static SimClock& threadClock() {
+    thread_local SimClock clock;
+    return clock;
+}
+
 bool sendPacket(const std::vector<uint8_t>& data, std::vector<uint8_t>& ack, int& seqNum, const ProtocolConfig& config) {
-    // Add sequence number as the first byte
-    std::vector<uint8_t> packet = {static_cast<uint8_t>(seqNum & 0xFF)};
-    packet.insert(packet.end(), data.begin(), data.end());
-    // Compute CRC for the data (including seqNum)
-    uint32_t crc = computeCRC(packet);
-    packet.push_back((crc >> 24) & 0xFF);
-    packet.push_back((crc >> 16) & 0xFF);
-    packet.push_back((crc >> 8) & 0xFF);
-    packet.push_back(crc & 0xFF);
+    return sendPacket(data, ack, seqNum, config, threadClock());
+}
+
+bool sendPacket(const std::vector<uint8_t>& data, std::vector<uint8_t>& ack, int& seqNum, const ProtocolConfig& config,
+                SimClock& clock) {
+    // Payload copied once into a pooled buffer, header and CRC added around it
+    PacketBuffer packet = clock.pool.acquire(data.size() + 4);
+    packet.append(data.data(), data.size());
+    framePacket(packet, seqNum);
+    if (config.virtualTime) return sendVirtual(packet, ack, seqNum, config, clock);
 
+    // Real time: the clock follows the wall clock
+    auto begin = std::chrono::steady_clock::now();
+    auto advance = [&]() {
+        clock.nowMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    };
     int retries = 0;
     while (retries < config.maxRetries) {
-        std::cout << "Attempt " << (retries + 1) << " of " << config.maxRetries << std::endl;
-        std::cout << "Sending packet (seqNum=" << seqNum << ") with CRC: ";
-        for (uint8_t byte : packet) {
-            std::cout << std::hex << static_cast<int>(byte) << " ";
-        }
-        std::cout << std::dec << std::endl;
+        clock.frames++;
+        NETSIM_TRACE(DEBUG, SW_SEND, seqNum, retries + 1, packet.size());
 
         // Simulate network conditions for data packet
-        if (!simulateNetworkConditions(packet, config, false)) {
-            std::cout << "Network error occurred, retrying..." << std::endl;
+        if (!deliverFrame(packet, seqNum, config, clock)) {
             retries++;
             continue;
         }
@@ -75,54 +262,174 @@ bool sendPacket(const std::vector<uint8_t>& data, std::vector<uint8_t>& ack, int
             auto now = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
             if (elapsed >= config.timeoutMs) {
-                std::cout << "Timeout occurred!" << std::endl;
+                NETSIM_TRACE(INFO, SW_TIMEOUT, seqNum, retries + 1, 0);
                 retries++;
                 break;
             }
             // Simulate receiving ACK (with sequence number)
-            std::vector<uint8_t> ackPacket = {static_cast<uint8_t>(seqNum & 0xFF)};
-            if (simulateNetworkConditions(ackPacket, config, true)) {
-                ack = ackPacket;
-                std::cout << "ACK received successfully! (seqNum=" << seqNum << ")" << std::endl;
+            if (linkConditions(1, config, clock.rng, true)) {
+                ack.assign(1, static_cast<uint8_t>(seqNum & 0xFF));
+                NETSIM_TRACE(DEBUG, SW_ACKED, seqNum, retries + 1, 0);
                 seqNum = (seqNum + 1) % 2; // Toggle sequence number for Stop-and-Wait
+                advance();
                 return true;
             }
             // Small delay to prevent busy waiting
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::this_thread::sleep_for(ACK_POLL_INTERVAL);
         }
     }
-    std::cout << "Max retries exceeded!" << std::endl;
+    NETSIM_TRACE(WARN, SW_GAVE_UP, seqNum, config.maxRetries, 0);
+    advance();
     return false;
 }
 
-bool receivePacket(std::vector<uint8_t>& data, int& expectedSeqNum, const ProtocolConfig& config) {
-    std::cout << "Receiving packet..." << std::endl;
-    if (data.size() < 5) return false; // At least seqNum + CRC
+namespace {
+
+// One sendPacketAsync transfer: the real-time loop of sendPacket unrolled
+// into callbacks, which keep it alive between steps
+struct AsyncTransfer : std::enable_shared_from_this<AsyncTransfer> {
+    RealTimeLoop& loop;
+    const ProtocolConfig config;
+    SimClock clock;
+    PacketBuffer packet;
+    SendResult result;
+    std::function<void(SendResult)> done;
+    int retries = 0;
+    RealTimeLoop::Clock::time_point attemptStart;
+
+    AsyncTransfer(RealTimeLoop& loop, const std::vector<uint8_t>& data, int seqNum, const ProtocolConfig& config,
+                  std::function<void(SendResult)> done)
+        : loop(loop), config(config), done(std::move(done)) {
+        packet = clock.pool.acquire(data.size() + 4);
+        packet.append(data.data(), data.size());
+        framePacket(packet, seqNum);
+        result.seqNum = seqNum;
+    }
+
+    void start() {
+        if (config.virtualTime) {
+            finish(sendVirtual(packet, result.ack, result.seqNum, config, clock));
+        } else {
+            attempt();
+        }
+    }
+
+    void attempt() {
+        while (retries < config.maxRetries) {
+            clock.frames++;
+            NETSIM_TRACE(DEBUG, SW_SEND, result.seqNum, retries + 1, packet.size());
+            if (deliverFrame(packet, result.seqNum, config, clock)) {
+                attemptStart = RealTimeLoop::Clock::now();
+                poll();
+                return;
+            }
+            retries++;
+        }
+        NETSIM_TRACE(WARN, SW_GAVE_UP, result.seqNum, config.maxRetries, 0);
+        finish(false);
+    }
+
+    void poll() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(RealTimeLoop::Clock::now() - attemptStart);
+        if (elapsed.count() >= config.timeoutMs) {
+            NETSIM_TRACE(INFO, SW_TIMEOUT, result.seqNum, retries + 1, 0);
+            retries++;
+            attempt();
+            return;
+        }
+        if (linkConditions(1, config, clock.rng, true)) {
+            result.ack.assign(1, static_cast<uint8_t>(result.seqNum & 0xFF));
+            NETSIM_TRACE(DEBUG, SW_ACKED, result.seqNum, retries + 1, 0);
+            result.seqNum = (result.seqNum + 1) % 2;
+            finish(true);
+            return;
+        }
+        loop.at(RealTimeLoop::Clock::now() + ACK_POLL_INTERVAL, [self = shared_from_this()]() { self->poll(); });
+    }
+
+    void finish(bool delivered) {
+        result.delivered = delivered;
+        done(std::move(result));
+    }
+};
+
+} // namespace
+
+void sendPacketAsync(RealTimeLoop& loop, const std::vector<uint8_t>& data, int seqNum, const ProtocolConfig& config,
+                     std::function<void(SendResult)> done) {
+    auto transfer = std::make_shared<AsyncTransfer>(loop, data, seqNum, config, std::move(done));
+    loop.post([transfer]() { transfer->start(); });
+}
+
+TransferStats simulateTransfers(const std::vector<uint8_t>& data, uint64_t count, const ProtocolConfig& config,
+                                uint64_t seed, uint64_t stream) {
+    ProtocolConfig simulated = config;
+    simulated.virtualTime = true;
+    TransferStats stats;
+    stats.latencyMs.reserve(count);
+    SimClock clock(seed, stream);
+    std::vector<uint8_t> ack;
+    int seqNum = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        double start = clock.nowMs;
+        if (sendPacket(data, ack, seqNum, simulated, clock)) {
+            stats.delivered++;
+        } else {
+            stats.failed++;
+        }
+        stats.latencyMs.push_back(clock.nowMs - start);
+    }
+    stats.attempts = clock.frames;
+    stats.crcErrors = clock.crcErrors;
+    stats.undetectedErrors = clock.undetectedErrors;
+    stats.elapsedMs = clock.nowMs;
+    if (clock.nowMs > 0.0) {
+        stats.goodputBps = stats.delivered * data.size() * 8 * 1000.0 / clock.nowMs;
+        stats.utilization = stats.delivered * transmissionMs(data.size() + 5, config) / clock.nowMs;
+    }
+    return stats;
+}
+
+// Network conditions (bit errors land in `frame`), CRC and sequence checks for
+// a received frame
+static bool acceptFrame(uint8_t* frame, size_t size, int expectedSeqNum, const ProtocolConfig& config,
+                        Xoshiro256pp& rng) {
+    if (size < 5) return false; // At least seqNum + CRC
     // Simulate network conditions for data packet
-    if (!simulateNetworkConditions(data, config, false)) {
-        std::cout << "Packet lost or corrupted during reception!" << std::endl;
+    if (!linkConditions(size, config, rng, false)) {
         return false;
     }
+    applyBitErrors(frame, size, config, rng);
     // Extract sequence number
-    int receivedSeqNum = data[0];
+    int receivedSeqNum = frame[0];
     // Verify CRC
-    std::vector<uint8_t> packetData(data.begin(), data.end() - 4);
-    uint32_t computedCRC = computeCRC(packetData);
-    uint32_t receivedCRC = (data[data.size() - 4] << 24) |
-                           (data[data.size() - 3] << 16) |
-                           (data[data.size() - 2] << 8) |
-                           data[data.size() - 1];
-    bool isValid = computedCRC == receivedCRC;
-    std::cout << "CRC Verification: " << (isValid ? "Valid" : "Invalid") << std::endl;
-    if (!isValid) return false;
+    uint32_t computedCRC, receivedCRC;
+    if (!verifyFrame(frame, size, computedCRC, receivedCRC)) {
+        NETSIM_TRACE(INFO, SW_CRC_ERROR, receivedSeqNum, computedCRC, receivedCRC);
+        return false;
+    }
     // Check sequence number
     if (receivedSeqNum != expectedSeqNum) {
-        std::cout << "Unexpected sequence number! Expected: " << expectedSeqNum << ", Got: " << receivedSeqNum << std::endl;
+        NETSIM_TRACE(INFO, SW_BAD_SEQUENCE, receivedSeqNum, expectedSeqNum, 0);
         return false;
     }
-    // Remove sequence number from data
-    data = std::vector<uint8_t>(data.begin() + 1, data.end() - 4);
-    std::cout << "Packet received successfully! (seqNum=" << receivedSeqNum << ")" << std::endl;
+    NETSIM_TRACE(DEBUG, SW_RECEIVED, receivedSeqNum, size - 5, 0);
+    return true;
+}
+
+bool receivePacket(std::vector<uint8_t>& data, int& expectedSeqNum, const ProtocolConfig& config) {
+    if (!acceptFrame(data.data(), data.size(), expectedSeqNum, config, threadRng())) return false;
+    // Remove sequence number and CRC in place
+    data.resize(data.size() - 4);
+    data.erase(data.begin());
+    expectedSeqNum = (expectedSeqNum + 1) % 2;
+    return true;
+}
+
+bool receivePacket(PacketBuffer& packet, int& expectedSeqNum, const ProtocolConfig& config, SimClock& clock) {
+    if (!acceptFrame(packet.data(), packet.size(), expectedSeqNum, config, clock.rng)) return false;
+    packet.pull(1);
+    packet.trim(4);
     expectedSeqNum = (expectedSeqNum + 1) % 2;
     return true;
-} 
\ No newline at end of file
+}
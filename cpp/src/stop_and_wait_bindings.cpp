@@ -1,30 +1,345 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <optional>
 #include "stop_and_wait.h"
+#include "sliding_window.h"
+#include "protocol_sweep.h"
+#include "stop_and_wait_coroutines.h"
+#include "realtime_loop.h"
+#include "trace_bindings.h"
 
 namespace py = pybind11;
 
+// Simulators called without a seed stay nondeterministic, as before seeds existed
+static uint64_t seedOrRandom(const std::optional<uint64_t>& seed) {
+    return seed ? *seed : randomSeed();
+}
+
+// Native loop behind the asyncio variants, started on first use. It is
+// never destroyed: an atexit hook stops it while the interpreter is still
+// up, then drops the futures of unfinished transfers with the GIL held.
+static RealTimeLoop& nativeLoop() {
+    static RealTimeLoop* loop = [] {
+        auto* created = new RealTimeLoop();
+        py::module_::import("atexit").attr("register")(py::cpp_function([created]() {
+            {
+                py::gil_scoped_release release;
+                created->shutdown();
+            }
+            created->clear();
+        }));
+        return created;
+    }();
+    return *loop;
+}
+
+// An asyncio future completed from a native thread. complete() must be
+// called with the GIL held and releases the Python objects there, so the
+// last reference may then be dropped anywhere; a future cancelled in the
+// meantime is left alone.
+class PendingFuture {
+public:
+    explicit PendingFuture(py::object eventLoop)
+        : eventLoop(std::move(eventLoop)), future(this->eventLoop.attr("create_future")()) {}
+
+    py::object get() const { return future; }
+
+    void complete(py::object result) {
+        try {
+            py::cpp_function setResult([](py::object future, py::object result) {
+                if (!future.attr("done")().cast<bool>()) future.attr("set_result")(result);
+            });
+            eventLoop.attr("call_soon_threadsafe")(setResult, future, result);
+        } catch (py::error_already_set& e) {
+            e.discard_as_unraisable("completing an asyncio future");  // The asyncio loop has closed
+        }
+        future = py::object();
+        eventLoop = py::object();
+    }
+
+private:
+    py::object eventLoop;
+    py::object future;
+};
+
 PYBIND11_MODULE(stop_and_wait_module, m) {
+    bindTrace(m);
+
+    py::enum_<CorruptionModel>(m, "CorruptionModel")
+        .value("FRAME", CorruptionModel::FRAME)
+        .value("BIT_ERRORS", CorruptionModel::BIT_ERRORS)
+        .value("BURST", CorruptionModel::BURST);
+
     py::class_<ProtocolConfig>(m, "ProtocolConfig")
         .def(py::init<>())
         .def_readwrite("maxRetries", &ProtocolConfig::maxRetries)
         .def_readwrite("timeoutMs", &ProtocolConfig::timeoutMs)
         .def_readwrite("errorProbability", &ProtocolConfig::errorProbability)
         .def_readwrite("lossProbability", &ProtocolConfig::lossProbability)
-        .def_readwrite("ackLossProbability", &ProtocolConfig::ackLossProbability);
+        .def_readwrite("ackLossProbability", &ProtocolConfig::ackLossProbability)
+        .def_readwrite("virtualTime", &ProtocolConfig::virtualTime)
+        .def_readwrite("propagationDelayMs", &ProtocolConfig::propagationDelayMs)
+        .def_readwrite("bandwidthBps", &ProtocolConfig::bandwidthBps)
+        .def_readwrite("corruption", &ProtocolConfig::corruption)
+        .def_readwrite("bitErrorRate", &ProtocolConfig::bitErrorRate)
+        .def_readwrite("burstLength", &ProtocolConfig::burstLength);
+
+    // Inspection only: frames are built in the pool inside sendPacket
+    py::class_<PacketPool>(m, "PacketPool")
+        .def_property_readonly("slabSize", &PacketPool::slabSize)
+        .def_property_readonly("headroom", &PacketPool::headroom)
+        .def_property_readonly("slabs", &PacketPool::slabs)
+        .def_property_readonly("available", &PacketPool::available);
+
+    py::class_<SimClock>(m, "SimClock")
+        .def(py::init<>())
+        .def(py::init<uint64_t, uint64_t>(), py::arg("seed"), py::arg("stream") = 0)
+        .def_readwrite("nowMs", &SimClock::nowMs)
+        .def_readwrite("frames", &SimClock::frames)
+        .def_readwrite("crcErrors", &SimClock::crcErrors)
+        .def_readwrite("undetectedErrors", &SimClock::undetectedErrors)
+        .def_property_readonly("pool", [](SimClock& clock) -> PacketPool& { return clock.pool; },
+                               py::return_value_policy::reference_internal);
 
     m.def("sendPacket", [](const std::vector<int>& data, int seqNum, ProtocolConfig& config) {
         std::vector<uint8_t> data_bytes(data.begin(), data.end());
         std::vector<uint8_t> ack;
         int seq = seqNum;
-        bool success = sendPacket(data_bytes, ack, seq, config);
+        bool success;
+        {
+            py::gil_scoped_release release;
+            success = sendPacket(data_bytes, ack, seq, config);
+        }
+        return py::make_tuple(success, std::vector<int>(ack.begin(), ack.end()), seq);
+    }, py::arg("data"), py::arg("seqNum"), py::arg("config"));
+
+    // Same, advancing `clock` (simulated when config.virtualTime is set)
+    m.def("sendPacket", [](const std::vector<int>& data, int seqNum, ProtocolConfig& config, SimClock& clock) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        std::vector<uint8_t> ack;
+        int seq = seqNum;
+        bool success;
+        {
+            py::gil_scoped_release release;
+            success = sendPacket(data_bytes, ack, seq, config, clock);
+        }
         return py::make_tuple(success, std::vector<int>(ack.begin(), ack.end()), seq);
+    }, py::arg("data"), py::arg("seqNum"), py::arg("config"), py::arg("clock"));
+
+    // asyncio variant of sendPacket: call from a coroutine and await the
+    // (success, ack, nextSeqNum) future; transfers wait on the native loop
+    // rather than in threads
+    m.def("sendPacketAsync", [](const std::vector<int>& data, int seqNum, ProtocolConfig& config) {
+        auto pending = std::make_shared<PendingFuture>(py::module_::import("asyncio").attr("get_running_loop")());
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        sendPacketAsync(nativeLoop(), data_bytes, seqNum, config, [pending](SendResult result) {
+            std::vector<int> ack(result.ack.begin(), result.ack.end());
+            py::gil_scoped_acquire gil;
+            pending->complete(py::make_tuple(result.delivered, ack, result.seqNum));
+        });
+        return pending->get();
     }, py::arg("data"), py::arg("seqNum"), py::arg("config"));
 
+    // `count` virtual-time transfers; dict with counts, simulated time and
+    // the latency of each transfer as a numpy array. Without a seed every
+    // call draws a fresh one.
+    m.def("simulateTransfers", [](const std::vector<int>& data, uint64_t count, ProtocolConfig& config,
+                                  std::optional<uint64_t> seed, uint64_t stream) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        TransferStats stats;
+        {
+            py::gil_scoped_release release;
+            stats = simulateTransfers(data_bytes, count, config, seedOrRandom(seed), stream);
+        }
+        auto* latency = new std::vector<double>(std::move(stats.latencyMs));
+        py::capsule release(latency, [](void* p) { delete static_cast<std::vector<double>*>(p); });
+        py::dict out;
+        out["delivered"] = stats.delivered;
+        out["failed"] = stats.failed;
+        out["attempts"] = stats.attempts;
+        out["elapsedMs"] = stats.elapsedMs;
+        out["goodputBps"] = stats.goodputBps;
+        out["utilization"] = stats.utilization;
+        out["crcErrors"] = stats.crcErrors;
+        out["undetectedErrors"] = stats.undetectedErrors;
+        out["latencyMs"] = py::array_t<double>(latency->size(), latency->data(), release);
+        return out;
+    }, py::arg("data"), py::arg("count"), py::arg("config"), py::arg("seed") = py::none(), py::arg("stream") = 0);
+
+    py::enum_<ArqProtocol>(m, "ArqProtocol")
+        .value("GO_BACK_N", ArqProtocol::GO_BACK_N)
+        .value("SELECTIVE_REPEAT", ArqProtocol::SELECTIVE_REPEAT);
+
+    py::class_<WindowConfig>(m, "WindowConfig")
+        .def(py::init<>())
+        .def(py::init([](ArqProtocol protocol, uint32_t windowSize, uint32_t sequenceBits) {
+            return WindowConfig{protocol, windowSize, sequenceBits};
+        }), py::arg("protocol"), py::arg("windowSize"), py::arg("sequenceBits") = 0)
+        .def_readwrite("protocol", &WindowConfig::protocol)
+        .def_readwrite("windowSize", &WindowConfig::windowSize)
+        .def_readwrite("sequenceBits", &WindowConfig::sequenceBits);
+
+    // Virtual-time Go-Back-N / Selective-Repeat run as a dict
+    m.def("simulateWindow", [](const std::vector<int>& data, uint64_t count, ProtocolConfig& config,
+                               const WindowConfig& window, std::optional<uint64_t> seed, uint64_t stream) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        WindowStats stats;
+        {
+            py::gil_scoped_release release;
+            stats = simulateWindow(data_bytes, count, config, window, seedOrRandom(seed), stream);
+        }
+        py::dict out;
+        out["delivered"] = stats.delivered;
+        out["transmissions"] = stats.transmissions;
+        out["retransmissions"] = stats.retransmissions;
+        out["timeouts"] = stats.timeouts;
+        out["crcErrors"] = stats.crcErrors;
+        out["undetectedErrors"] = stats.undetectedErrors;
+        out["sequenceBits"] = stats.sequenceBits;
+        out["elapsedMs"] = stats.elapsedMs;
+        out["goodputBps"] = stats.goodputBps;
+        out["utilization"] = stats.utilization;
+        return out;
+    }, py::arg("data"), py::arg("count"), py::arg("config"), py::arg("window"), py::arg("seed") = py::none(),
+       py::arg("stream") = 0);
+
+    // One run per window size; dict of numpy arrays aligned with windowSizes
+    m.def("sweepWindowSizes", [](const std::vector<int>& data, uint64_t count, ProtocolConfig& config,
+                                 ArqProtocol protocol, const std::vector<uint32_t>& windowSizes,
+                                 uint32_t sequenceBits, std::optional<uint64_t> seed) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        std::vector<WindowStats> runs;
+        {
+            py::gil_scoped_release release;
+            runs = sweepWindowSizes(data_bytes, count, config, protocol, windowSizes, sequenceBits,
+                                    seedOrRandom(seed));
+        }
+        size_t n = runs.size();
+        py::array_t<uint32_t> sizes(n), bits(n);
+        py::array_t<uint64_t> transmissions(n);
+        py::array_t<double> elapsed(n), goodput(n), utilization(n);
+        for (size_t i = 0; i < n; i++) {
+            sizes.mutable_at(i) = windowSizes[i];
+            bits.mutable_at(i) = runs[i].sequenceBits;
+            transmissions.mutable_at(i) = runs[i].transmissions;
+            elapsed.mutable_at(i) = runs[i].elapsedMs;
+            goodput.mutable_at(i) = runs[i].goodputBps;
+            utilization.mutable_at(i) = runs[i].utilization;
+        }
+        py::dict out;
+        out["windowSize"] = sizes;
+        out["sequenceBits"] = bits;
+        out["transmissions"] = transmissions;
+        out["elapsedMs"] = elapsed;
+        out["goodputBps"] = goodput;
+        out["utilization"] = utilization;
+        return out;
+    }, py::arg("data"), py::arg("count"), py::arg("config"), py::arg("protocol"), py::arg("windowSizes"),
+       py::arg("sequenceBits") = 0, py::arg("seed") = py::none());
+
+    // Grid sweep in virtual time; dict of numpy arrays shaped
+    // (errorProbability, lossProbability, ackLossProbability, timeoutMs),
+    // attemptCounts with a trailing maxRetries axis. Without a seed every call
+    // draws a fresh one.
+    m.def("sweepProtocolConfigs", [](const std::vector<int>& data, ProtocolConfig& config,
+                                     const std::vector<double>& errorProbability,
+                                     const std::vector<double>& lossProbability,
+                                     const std::vector<double>& ackLossProbability,
+                                     const std::vector<int>& timeoutMs, uint64_t trials, std::optional<uint64_t> seed,
+                                     unsigned threads) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        SweepGrid grid{errorProbability, lossProbability, ackLossProbability, timeoutMs};
+        SweepResult result;
+        {
+            py::gil_scoped_release release;
+            result = sweepProtocolConfigs(data_bytes, config, grid, trials, seedOrRandom(seed), threads);
+        }
+        std::vector<py::ssize_t> shape = {py::ssize_t(errorProbability.size()), py::ssize_t(lossProbability.size()),
+                                          py::ssize_t(ackLossProbability.size()), py::ssize_t(timeoutMs.size())};
+        auto cells = [&](const auto& values) {
+            using T = typename std::decay_t<decltype(values)>::value_type;
+            return py::array_t<T>(shape, values.data());
+        };
+        py::dict out;
+        out["successRate"] = cells(result.successRate);
+        out["meanAttempts"] = cells(result.meanAttempts);
+        out["p50Attempts"] = cells(result.p50Attempts);
+        out["p90Attempts"] = cells(result.p90Attempts);
+        out["p99Attempts"] = cells(result.p99Attempts);
+        out["meanLatencyMs"] = cells(result.meanLatencyMs);
+        out["goodputBps"] = cells(result.goodputBps);
+        shape.push_back(config.maxRetries);
+        out["attemptCounts"] = cells(result.attemptCounts);
+        return out;
+    }, py::arg("data"), py::arg("config"), py::arg("errorProbability"), py::arg("lossProbability"),
+       py::arg("ackLossProbability"), py::arg("timeoutMs"), py::arg("trials"), py::arg("seed") = py::none(),
+       py::arg("threads") = 0);
+
+    // Event-driven sender and receiver over a modelled link; bulk transfer of
+    // `count` copies of data, as a dict. Without a seed every call draws a
+    // fresh one.
+    m.def("simulateLink", [](const std::vector<int>& data, uint64_t count, ProtocolConfig& config,
+                             std::optional<uint64_t> seed) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        LinkStats stats;
+        {
+            py::gil_scoped_release release;
+            stats = simulateLink(data_bytes, count, config, seedOrRandom(seed));
+        }
+        py::dict out;
+        out["delivered"] = stats.delivered;
+        out["failed"] = stats.failed;
+        out["frames"] = stats.frames;
+        out["retransmissions"] = stats.retransmissions;
+        out["timeouts"] = stats.timeouts;
+        out["duplicates"] = stats.duplicates;
+        out["crcErrors"] = stats.crcErrors;
+        out["undetectedErrors"] = stats.undetectedErrors;
+        out["events"] = stats.events;
+        out["elapsedMs"] = stats.elapsedMs;
+        out["throughputBps"] = stats.throughputBps;
+        out["utilization"] = stats.utilization;
+        out["busy"] = stats.busy;
+        out["propagationRatio"] = stats.propagationRatio;
+        return out;
+    }, py::arg("data"), py::arg("count"), py::arg("config"), py::arg("seed") = py::none());
+
+    // `flows` concurrent transfers, each a coroutine sender and receiver on
+    // one shared event loop, as a dict. Without a seed every call draws a
+    // fresh one.
+    m.def("simulateFlows", [](const std::vector<int>& data, size_t flows, uint64_t messages,
+                              ProtocolConfig& config, std::optional<uint64_t> seed) {
+        std::vector<uint8_t> data_bytes(data.begin(), data.end());
+        FlowStats stats;
+        {
+            py::gil_scoped_release release;
+            stats = simulateFlows(data_bytes, flows, messages, config, seedOrRandom(seed));
+        }
+        py::dict out;
+        out["flows"] = stats.flows;
+        out["delivered"] = stats.delivered;
+        out["failed"] = stats.failed;
+        out["frames"] = stats.frames;
+        out["retransmissions"] = stats.retransmissions;
+        out["timeouts"] = stats.timeouts;
+        out["duplicates"] = stats.duplicates;
+        out["crcErrors"] = stats.crcErrors;
+        out["events"] = stats.events;
+        out["elapsedMs"] = stats.elapsedMs;
+        out["meanCompletionMs"] = stats.meanCompletionMs;
+        out["throughputBps"] = stats.throughputBps;
+        return out;
+    }, py::arg("data"), py::arg("flows"), py::arg("messages"), py::arg("config"), py::arg("seed") = py::none());
+
     m.def("receivePacket", [](std::vector<int>& data, int expectedSeqNum, ProtocolConfig& config) {
         std::vector<uint8_t> data_bytes(data.begin(), data.end());
         int seq = expectedSeqNum;
-        bool valid = receivePacket(data_bytes, seq, config);
+        bool valid;
+        {
+            py::gil_scoped_release release;
+            valid = receivePacket(data_bytes, seq, config);
+        }
         data = std::vector<int>(data_bytes.begin(), data_bytes.end());
         return py::make_tuple(valid, data, seq);
     }, py::arg("data"), py::arg("expectedSeqNum"), py::arg("config"));
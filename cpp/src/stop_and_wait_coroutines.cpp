@@ -0,0 +1,173 @@
+#include "stop_and_wait_coroutines.h"
+#include "trace.h"
+#include <algorithm>
+#include <stdexcept>
+
+constexpr size_t FRAME_HEADROOM = 8;      // Room for the sequence number pushed in front
+
+// Time to clock `bytes` onto the link
+static double transmissionMs(size_t bytes, const ProtocolConfig& config) {
+    return config.bandwidthBps > 0.0 ? bytes * 8 * 1000.0 / config.bandwidthBps : 0.0;
+}
+
+FlowNetwork::FlowNetwork(EventLoop& loop, const ProtocolConfig& config, size_t flows, size_t frameBytes,
+                         uint64_t seed)
+    : loop(loop), config(config), rng(seed), pool(frameBytes + FRAME_HEADROOM, FRAME_HEADROOM),
+      endpoints(flows * 2) {}
+
+double FlowNetwork::send(uint32_t flow, Direction direction, PacketBuffer frame) {
+    const uint32_t target = index(flow, direction);
+    Endpoint& endpoint = endpoints[target];
+    const double end = std::max(loop.now(), endpoint.linkFree) + transmissionMs(frame.size(), config);
+    endpoint.linkFree = end;
+    if (impairFrame(frame, config, direction, rng) == FrameFate::LOST) return end;
+
+    uint32_t slot;
+    if (freeSlots.empty()) {
+        slot = static_cast<uint32_t>(inFlight.size());
+        inFlight.push_back({std::move(frame), target});
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        inFlight[slot] = {std::move(frame), target};
+    }
+    loop.at(end + config.propagationDelayMs, [this, slot]() { arrive(slot); });
+    return end;
+}
+
+// One timer event per endpoint is kept queued at most: a wait with a later
+// deadline than the queued event is re-armed when that event fires
+void FlowNetwork::suspend(uint32_t index, std::coroutine_handle<> waiter, double deadline) {
+    Endpoint& endpoint = endpoints[index];
+    endpoint.waiter = waiter;
+    endpoint.deadline = deadline;
+    if (deadline < endpoint.timerAt) {
+        endpoint.timerAt = deadline;
+        loop.at(deadline, [this, index]() { onTimer(index); });
+    }
+}
+
+void FlowNetwork::onTimer(uint32_t index) {
+    Endpoint& endpoint = endpoints[index];
+    if (loop.now() >= endpoint.timerAt) endpoint.timerAt = NEVER;
+    if (!endpoint.waiter) return;
+    if (loop.now() >= endpoint.deadline) {
+        wake(endpoint);
+    } else if (endpoint.deadline < endpoint.timerAt) {
+        endpoint.timerAt = endpoint.deadline;
+        loop.at(endpoint.deadline, [this, index]() { onTimer(index); });
+    }
+}
+
+void FlowNetwork::arrive(uint32_t slot) {
+    // Take the frame out first: the woken coroutine may send and reuse slots
+    PacketBuffer frame = std::move(inFlight[slot].frame);
+    Endpoint& endpoint = endpoints[inFlight[slot].endpoint];
+    freeSlots.push_back(slot);
+    if (!endpoint.waiter) return;
+    endpoint.inbox.emplace(std::move(frame));
+    wake(endpoint);
+}
+
+void FlowNetwork::wake(Endpoint& endpoint) {
+    std::coroutine_handle<> waiter = std::exchange(endpoint.waiter, nullptr);
+    endpoint.deadline = NEVER;
+    waiter.resume();
+}
+
+FlowTask stopAndWaitSender(FlowNetwork& net, uint32_t flow, const std::vector<uint8_t>& payload, uint64_t count,
+                           double& completedAt) {
+    const ProtocolConfig& config = net.protocol();
+    FlowStats& stats = net.stats();
+    int seqNum = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        bool acked = false;
+        int attempts = 0;
+        while (!acked && attempts < config.maxRetries) {
+            attempts++;
+            PacketBuffer frame = net.acquire(payload.size() + 4);
+            frame.append(payload.data(), payload.size());
+            framePacket(frame, seqNum);
+            stats.frames++;
+            if (attempts > 1) stats.retransmissions++;
+            NETSIM_TRACE(DEBUG, SW_SEND, seqNum, attempts, frame.size());
+            double deadline = net.send(flow, FlowNetwork::Direction::DATA, std::move(frame)) + config.timeoutMs;
+            // A late ACK of the previous message carries the other sequence number
+            while (!acked) {
+                std::optional<PacketBuffer> ack = co_await net.receive(flow, FlowNetwork::Direction::ACK, deadline);
+                if (!ack) {
+                    NETSIM_TRACE(INFO, SW_TIMEOUT, seqNum, attempts, 0);
+                    stats.timeouts++;
+                    break;
+                }
+                acked = !ack->empty() && ack->data()[0] == seqNum;
+            }
+        }
+        if (acked) {
+            NETSIM_TRACE(DEBUG, SW_ACKED, seqNum, attempts, 0);
+            seqNum = (seqNum + 1) % 2;
+        } else {
+            NETSIM_TRACE(WARN, SW_GAVE_UP, seqNum, attempts, 0);
+            stats.failed++;
+        }
+    }
+    completedAt = net.eventLoop().now();
+}
+
+FlowTask stopAndWaitReceiver(FlowNetwork& net, uint32_t flow) {
+    FlowStats& stats = net.stats();
+    int expectedSeqNum = 0;
+    for (;;) {
+        std::optional<PacketBuffer> frame = co_await net.receive(flow, FlowNetwork::Direction::DATA);
+        uint32_t computedCRC = 0, receivedCRC = 0;
+        if (!verifyFrame(frame->data(), frame->size(), computedCRC, receivedCRC)) {
+            NETSIM_TRACE(INFO, SW_CRC_ERROR, frame->empty() ? 0 : frame->data()[0], computedCRC, receivedCRC);
+            stats.crcErrors++;
+            continue;
+        }
+        int seq = frame->data()[0];
+        if (seq == expectedSeqNum) {
+            NETSIM_TRACE(DEBUG, SW_RECEIVED, seq, frame->size() - 5, 0);
+            stats.delivered++;
+            expectedSeqNum = (expectedSeqNum + 1) % 2;
+        } else {
+            NETSIM_TRACE(INFO, SW_BAD_SEQUENCE, seq, expectedSeqNum, 0);
+            stats.duplicates++;
+        }
+        PacketBuffer ack = net.acquire(1);
+        *ack.put(1) = static_cast<uint8_t>(seq);
+        net.send(flow, FlowNetwork::Direction::ACK, std::move(ack));
+    }
+}
+
+FlowStats simulateFlows(const std::vector<uint8_t>& payload, size_t flows, uint64_t messages,
+                        const ProtocolConfig& config, uint64_t seed) {
+    if (config.maxRetries < 1) throw std::invalid_argument("maxRetries must be at least 1");
+    if (flows > std::numeric_limits<uint32_t>::max() / 2) throw std::invalid_argument("too many flows");
+
+    EventLoop loop;
+    FlowNetwork net(loop, config, flows, payload.size() + 5, seed);
+    std::vector<double> completedAt(flows, 0.0);
+    // Declared after the network so suspended receivers are destroyed while its pool is alive
+    std::vector<FlowTask> tasks;
+    tasks.reserve(flows * 2);
+    for (uint32_t flow = 0; flow < flows; flow++) {
+        tasks.push_back(stopAndWaitReceiver(net, flow));
+        tasks.push_back(stopAndWaitSender(net, flow, payload, messages, completedAt[flow]));
+    }
+    loop.run();
+
+    FlowStats stats = net.stats();
+    stats.flows = flows;
+    stats.events = loop.processed();
+    if (flows > 0) {
+        double total = 0.0;
+        for (double t : completedAt) {
+            stats.elapsedMs = std::max(stats.elapsedMs, t);
+            total += t;
+        }
+        stats.meanCompletionMs = total / flows;
+    }
+    if (stats.elapsedMs > 0.0) stats.throughputBps = stats.delivered * payload.size() * 8 * 1000.0 / stats.elapsedMs;
+    return stats;
+}
@@ -0,0 +1,214 @@
+#include "stop_and_wait_endpoints.h"
+#include "trace.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Time to clock `bytes` onto the link
+static double transmissionMs(size_t bytes, const ProtocolConfig& config) {
+    return config.bandwidthBps > 0.0 ? bytes * 8 * 1000.0 / config.bandwidthBps : 0.0;
+}
+
+FrameFate impairFrame(PacketBuffer& frame, const ProtocolConfig& config, Channel::Direction direction,
+                      Xoshiro256pp& rng) {
+    if (direction == Channel::Direction::ACK) {
+        if (rng.uniform() < config.ackLossProbability) {
+            NETSIM_TRACE(INFO, SW_ACK_LOST, 0, 0, 0);
+            return FrameFate::LOST;
+        }
+        return FrameFate::INTACT;
+    }
+    if (rng.uniform() < config.lossProbability) {
+        NETSIM_TRACE(INFO, SW_LOST, frame.size(), 0, 0);
+        return FrameFate::LOST;
+    }
+    bool corrupted;
+    if (config.corruption == CorruptionModel::FRAME) {
+        corrupted = rng.uniform() < config.errorProbability;
+        if (corrupted) {
+            uint64_t bit = rng.below(frame.size() * 8);
+            frame.data()[bit / 8] ^= static_cast<uint8_t>(0x80 >> (bit % 8));
+        }
+    } else {
+        corrupted = applyBitErrors(frame.data(), frame.size(), config, rng) > 0;
+    }
+    if (!corrupted) return FrameFate::INTACT;
+    NETSIM_TRACE(INFO, SW_CORRUPTED, frame.size(), 0, 0);
+    return FrameFate::CORRUPTED;
+}
+
+Channel::Channel(EventLoop& loop, const ProtocolConfig& config, Direction direction, uint64_t seed,
+                 uint64_t stream)
+    : loop(loop), config(config), direction(direction), rng(seed, stream) {}
+
+double Channel::send(PacketBuffer frame) {
+    const double frameMs = transmissionMs(frame.size(), config);
+    const double end = std::max(loop.now(), freeAt) + frameMs;
+    freeAt = end;
+    busy += frameMs;
+    framesSent++;
+
+    FrameFate fate = impairFrame(frame, config, direction, rng);
+    if (fate == FrameFate::LOST) {
+        framesLost++;
+        return end;
+    }
+    if (fate == FrameFate::CORRUPTED) framesCorrupted++;
+    const double arrival = end + config.propagationDelayMs;
+    inFlight.push_back({arrival, std::move(frame)});
+    loop.at(arrival, [this]() { arrive(); });
+    return end;
+}
+
+void Channel::arrive() {
+    PacketBuffer frame = std::move(inFlight.front().frame);
+    inFlight.pop_front();
+    if (deliver) deliver(frame);
+}
+
+StopAndWaitSender::StopAndWaitSender(EventLoop& loop, Channel& channel, const ProtocolConfig& config)
+    : loop(loop), channel(channel), config(config) {}
+
+void StopAndWaitSender::send(const std::vector<uint8_t>& payload, uint64_t copies) {
+    if (copies == 0) return;
+    queue.emplace_back(payload, copies);
+    if (!waiting) next();
+}
+
+// Frame the next queued message and start sending it
+void StopAndWaitSender::next() {
+    if (queue.empty()) return;
+    auto& [payload, copies] = queue.front();
+    current = pool.acquire(payload.size() + 4);
+    current.append(payload.data(), payload.size());
+    framePacket(current, seqNum);
+    if (--copies == 0) queue.pop_front();
+    waiting = true;
+    attempts = 0;
+    startedAt = loop.now();
+    transmit();
+}
+
+void StopAndWaitSender::transmit() {
+    attempts++;
+    counters.frames++;
+    if (attempts > 1) counters.retransmissions++;
+    NETSIM_TRACE(DEBUG, SW_SEND, seqNum, attempts, current.size());
+    // The channel consumes its copy; `current` stays for retransmissions
+    PacketBuffer copy = pool.acquire(current.size());
+    copy.append(current.data(), current.size());
+    deadline = channel.send(std::move(copy)) + config.timeoutMs;
+    armTimer();
+}
+
+// One timer event is kept queued rather than one per frame: an ACK only
+// clears `waiting`, and an event that finds the deadline moved on re-arms
+// for it. Stale timers would otherwise pile up in the heap whenever the
+// timeout spans many round trips.
+void StopAndWaitSender::armTimer() {
+    if (timerArmed) return;
+    timerArmed = true;
+    loop.at(deadline, [this]() { onTimer(); });
+}
+
+void StopAndWaitSender::onTimer() {
+    timerArmed = false;
+    if (!waiting) return;
+    if (loop.now() < deadline) {
+        armTimer();
+        return;
+    }
+    NETSIM_TRACE(INFO, SW_TIMEOUT, seqNum, attempts, 0);
+    counters.timeouts++;
+    if (attempts >= config.maxRetries) {
+        NETSIM_TRACE(WARN, SW_GAVE_UP, seqNum, attempts, 0);
+        finish(false);
+        return;
+    }
+    transmit();
+}
+
+void StopAndWaitSender::onAck(PacketBuffer& ack) {
+    if (!waiting || ack.empty() || ack.data()[0] != (seqNum & 0xFF)) return;  // Late duplicate
+    NETSIM_TRACE(DEBUG, SW_ACKED, seqNum, attempts, 0);
+    seqNum = (seqNum + 1) % 2;
+    finish(true);
+}
+
+void StopAndWaitSender::finish(bool delivered) {
+    waiting = false;
+    if (delivered) {
+        counters.delivered++;
+    } else {
+        counters.failed++;
+    }
+    if (completed) completed(delivered, loop.now() - startedAt);
+    next();
+}
+
+StopAndWaitReceiver::StopAndWaitReceiver(Channel& ackChannel) : ackChannel(ackChannel) {}
+
+void StopAndWaitReceiver::onFrame(PacketBuffer& frame) {
+    uint32_t computedCRC = 0, receivedCRC = 0;
+    if (!verifyFrame(frame.data(), frame.size(), computedCRC, receivedCRC)) {
+        NETSIM_TRACE(INFO, SW_CRC_ERROR, frame.empty() ? 0 : frame.data()[0], computedCRC, receivedCRC);
+        counters.crcErrors++;
+        return;
+    }
+    int seq = frame.data()[0];
+    if (seq == expectedSeqNum) {
+        frame.pull(1);
+        frame.trim(4);
+        NETSIM_TRACE(DEBUG, SW_RECEIVED, seq, frame.size(), 0);
+        counters.delivered++;
+        counters.bytes += frame.size();
+        if (delivered) delivered(frame.data(), frame.size());
+        expectedSeqNum = (expectedSeqNum + 1) % 2;
+    } else {
+        NETSIM_TRACE(INFO, SW_BAD_SEQUENCE, seq, expectedSeqNum, 0);
+        counters.duplicates++;
+    }
+    PacketBuffer ack = pool.acquire(1);
+    *ack.put(1) = static_cast<uint8_t>(seq);
+    ackChannel.send(std::move(ack));
+}
+
+LinkStats simulateLink(const std::vector<uint8_t>& payload, uint64_t count, const ProtocolConfig& config,
+                       uint64_t seed) {
+    if (config.maxRetries < 1) throw std::invalid_argument("maxRetries must be at least 1");
+
+    EventLoop loop;
+    Channel data(loop, config, Channel::Direction::DATA, seed, 0);
+    Channel acks(loop, config, Channel::Direction::ACK, seed, 1);
+    StopAndWaitSender sender(loop, data, config);
+    StopAndWaitReceiver receiver(acks);
+    data.connect([&receiver](PacketBuffer& frame) { receiver.onFrame(frame); });
+    acks.connect([&sender](PacketBuffer& ack) { sender.onAck(ack); });
+    // The run ends with the last message, not with timers left queued behind it
+    double finishedAt = 0.0;
+    sender.onComplete([&loop, &finishedAt](bool, double) { finishedAt = loop.now(); });
+
+    sender.send(payload, count);
+    loop.run();
+
+    LinkStats stats;
+    const SenderStats& sent = sender.stats();
+    const ReceiverStats& received = receiver.stats();
+    stats.delivered = received.delivered;
+    stats.failed = sent.failed;
+    stats.frames = sent.frames;
+    stats.retransmissions = sent.retransmissions;
+    stats.timeouts = sent.timeouts;
+    stats.duplicates = received.duplicates;
+    stats.crcErrors = received.crcErrors;
+    stats.undetectedErrors = data.corrupted() - received.crcErrors;
+    stats.events = loop.processed();
+    stats.elapsedMs = finishedAt;
+    const double frameMs = transmissionMs(payload.size() + 5, config);
+    if (stats.elapsedMs > 0.0) {
+        stats.throughputBps = received.bytes * 8 * 1000.0 / stats.elapsedMs;
+        stats.utilization = received.delivered * frameMs / stats.elapsedMs;
+        stats.busy = data.busyMs() / stats.elapsedMs;
+    }
+    if (frameMs > 0.0) stats.propagationRatio = config.propagationDelayMs / frameMs;
+    return stats;
+}
@@ -1,6 +1,5 @@
 #include "tcp_tahoe.h"
-#include <iostream>
-#include <random>
+#include "trace.h"
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -10,28 +9,26 @@ constexpr uint32_t ALPHA = 0.125;  // Weight for SRTT
 constexpr uint32_t BETA = 0.25;    // Weight for RTTVAR
 constexpr uint32_t K = 4;          // RTO multiplier
 
-TCPTahoe::TCPTahoe(const TCPConfig& config) 
+TCPTahoe::TCPTahoe(const TCPConfig& config) : TCPTahoe(config, randomSeed()) {}
+
+TCPTahoe::TCPTahoe(const TCPConfig& config, uint64_t seed, uint64_t stream)
     : config(config), state(TCPState::SLOW_START), cwnd(config.initialWindowSize),
       ssthresh(config.ssthresh), dupAckCount(0), nextSeqNum(0), lastAckedSeq(0),
       srtt(config.initialRTT), rttvar(config.initialRTT / 2), rto(config.initialRTT + K * rttvar),
-      delayedAckCount(0) {
+      delayedAckCount(0), rng(seed, stream) {
     resetStats();
 }
 
 bool TCPTahoe::sendData(const std::vector<uint8_t>& data) {
     // Check if we can send more data based on congestion window
     if (sendBuffer.size() >= cwnd * config.windowScale) {
-        std::cout << "Congestion window full, waiting..." << std::endl;
+        NETSIM_TRACE(DEBUG, TCP_WINDOW_FULL, sendBuffer.size(), cwnd * config.windowScale, 0);
         return false;
     }
 
     // Simulate packet loss
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> dis(0.0, 1.0);
-    
-    if (dis(gen) < config.lossProbability) {
-        std::cout << "Packet lost during transmission!" << std::endl;
+    if (rng.uniform() < config.lossProbability) {
+        NETSIM_TRACE(INFO, TCP_SEND_LOST, nextSeqNum, 0, 0);
         stats.totalPacketsLost++;
         handlePacketLoss();
         return false;
@@ -58,11 +55,7 @@ bool TCPTahoe::sendData(const std::vector<uint8_t>& data) {
     // Record window size for visualization
     recordWindowSize();
 
-    std::cout << "Sent packet with seq=" << (nextSeqNum - data.size()) 
-              << ", cwnd=" << cwnd * config.windowScale << ", state=" 
-              << (state == TCPState::SLOW_START ? "SLOW_START" : 
-                  state == TCPState::CONGESTION_AVOIDANCE ? "CONGESTION_AVOIDANCE" : "FAST_RECOVERY")
-              << std::endl;
+    NETSIM_TRACE(DEBUG, TCP_SENT, nextSeqNum - data.size(), cwnd * config.windowScale, state);
 
     return true;
 }
@@ -71,12 +64,12 @@ bool TCPTahoe::receiveAck(uint32_t ackNumber) {
     if (ackNumber <= lastAckedSeq) {
         // Duplicate ACK
         dupAckCount++;
-        std::cout << "Received duplicate ACK " << ackNumber << " (count: " << dupAckCount << ")" << std::endl;
+        NETSIM_TRACE(DEBUG, TCP_DUP_ACK, ackNumber, dupAckCount, 0);
         
         if (dupAckCount == 3) {
             // Fast Retransmit
-            std::cout << "Fast Retransmit triggered!" << std::endl;
             ssthresh = cwnd / 2;
+            NETSIM_TRACE(INFO, TCP_FAST_RETRANSMIT, ackNumber, ssthresh, 0);
             cwnd = 1;
             enterFastRecovery();
             retransmit();
@@ -134,14 +127,13 @@ bool TCPTahoe::receiveAck(uint32_t ackNumber) {
     // Record window size for visualization
     recordWindowSize();
 
-    std::cout << "Received ACK " << ackNumber << ", new cwnd=" << cwnd * config.windowScale 
-              << ", RTT=" << stats.currentRTT << "ms" << std::endl;
+    NETSIM_TRACE(DEBUG, TCP_ACK, ackNumber, cwnd * config.windowScale, stats.currentRTT);
     return true;
 }
 
 void TCPTahoe::handleTimeout() {
-    std::cout << "Timeout occurred!" << std::endl;
     ssthresh = cwnd / 2;
+    NETSIM_TRACE(INFO, TCP_TIMEOUT, rto, ssthresh, 0);
     cwnd = 1;
     enterSlowStart();
     retransmit();
@@ -160,17 +152,17 @@ void TCPTahoe::handlePacketLoss() {
 
 void TCPTahoe::enterSlowStart() {
     state = TCPState::SLOW_START;
-    std::cout << "Entering Slow Start" << std::endl;
+    NETSIM_TRACE(INFO, TCP_STATE, static_cast<int64_t>(state), 0, 0);
 }
 
 void TCPTahoe::enterCongestionAvoidance() {
     state = TCPState::CONGESTION_AVOIDANCE;
-    std::cout << "Entering Congestion Avoidance" << std::endl;
+    NETSIM_TRACE(INFO, TCP_STATE, static_cast<int64_t>(state), 0, 0);
 }
 
 void TCPTahoe::enterFastRecovery() {
     state = TCPState::FAST_RECOVERY;
-    std::cout << "Entering Fast Recovery" << std::endl;
+    NETSIM_TRACE(INFO, TCP_STATE, static_cast<int64_t>(state), 0, 0);
 }
 
 TCPStats TCPTahoe::getStats() const {
@@ -197,10 +189,8 @@ bool TCPTahoe::isTimeout() {
 
 void TCPTahoe::retransmit() {
     if (!sendBuffer.empty()) {
-        std::cout << "Retransmitting packet with seq=" 
-                  << (sendBuffer.front()[0] << 24 | sendBuffer.front()[1] << 16 | 
-                      sendBuffer.front()[2] << 8 | sendBuffer.front()[3])
-                  << std::endl;
+        NETSIM_TRACE(INFO, TCP_RETRANSMIT, sendBuffer.front()[0] << 24 | sendBuffer.front()[1] << 16 |
+                     sendBuffer.front()[2] << 8 | sendBuffer.front()[3], 0, 0);
         lastSendTime = std::chrono::steady_clock::now();
     }
 }
@@ -227,7 +217,7 @@ void TCPTahoe::updateRTT(uint32_t rtt) {
 
 void TCPTahoe::handleDelayedAck() {
     if (delayedAckCount >= config.maxDelayedAcks) {
-        std::cout << "Sending delayed ACK" << std::endl;
+        NETSIM_TRACE(DEBUG, TCP_DELAYED_ACK, 0, 0, 0);
         stats.totalDelayedAcks++;
         delayedAckCount = 0;
     }
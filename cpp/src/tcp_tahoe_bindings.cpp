@@ -1,10 +1,13 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include "tcp_tahoe.h"
+#include "trace_bindings.h"
 
 namespace py = pybind11;
 
 PYBIND11_MODULE(tcp_tahoe_module, m) {
+    bindTrace(m);
+
     py::enum_<TCPState>(m, "TCPState")
         .value("SLOW_START", TCPState::SLOW_START)
         .value("CONGESTION_AVOIDANCE", TCPState::CONGESTION_AVOIDANCE)
@@ -41,6 +44,8 @@ PYBIND11_MODULE(tcp_tahoe_module, m) {
 
     py::class_<TCPTahoe>(m, "TCPTahoe")
         .def(py::init<const TCPConfig&>(), py::arg("config") = TCPConfig())
+        .def(py::init<const TCPConfig&, uint64_t, uint64_t>(), py::arg("config"), py::arg("seed"),
+             py::arg("stream") = 0)
         .def("sendData", [](TCPTahoe& self, const std::vector<int>& data) {
             std::vector<uint8_t> data_bytes(data.begin(), data.end());
             return self.sendData(data_bytes);
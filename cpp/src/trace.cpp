@@ -0,0 +1,346 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+std::atomic<uint8_t> traceLevel(0);
+
+namespace {
+
+// File layout: magic, record size, event count, start time (Unix ns), then
+// per event its id, name and comma-separated argument names (each string
+// prefixed by a length byte), then the records up to the end of the file
+constexpr char MAGIC[8] = {'N', 'S', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(1);
+constexpr uint32_t SESSION_THREAD = 0xFFFFFFFF;   // Thread id of records written by the trace itself
+
+struct EventInfo {
+    TraceEvent event;
+    const char* name;
+    const char* args;
+};
+
+const EventInfo EVENTS[] = {
+    {TraceEvent::TRACE_DROPPED, "TRACE_DROPPED", "dropped"},
+    {TraceEvent::SW_SEND, "SW_SEND", "seq,attempt,bytes"},
+    {TraceEvent::SW_LOST, "SW_LOST", "bytes"},
+    {TraceEvent::SW_CORRUPTED, "SW_CORRUPTED", "bytes"},
+    {TraceEvent::SW_ACK_LOST, "SW_ACK_LOST", ""},
+    {TraceEvent::SW_TIMEOUT, "SW_TIMEOUT", "seq,attempt"},
+    {TraceEvent::SW_ACKED, "SW_ACKED", "seq,attempts"},
+    {TraceEvent::SW_GAVE_UP, "SW_GAVE_UP", "seq,attempts"},
+    {TraceEvent::SW_RECEIVED, "SW_RECEIVED", "seq,bytes"},
+    {TraceEvent::SW_CRC_ERROR, "SW_CRC_ERROR", "seq,computed,received"},
+    {TraceEvent::SW_BAD_SEQUENCE, "SW_BAD_SEQUENCE", "seq,expected"},
+    {TraceEvent::TCP_WINDOW_FULL, "TCP_WINDOW_FULL", "buffered,window"},
+    {TraceEvent::TCP_SEND_LOST, "TCP_SEND_LOST", "seq"},
+    {TraceEvent::TCP_SENT, "TCP_SENT", "seq,cwnd,state"},
+    {TraceEvent::TCP_DUP_ACK, "TCP_DUP_ACK", "ack,count"},
+    {TraceEvent::TCP_FAST_RETRANSMIT, "TCP_FAST_RETRANSMIT", "ack,ssthresh"},
+    {TraceEvent::TCP_ACK, "TCP_ACK", "ack,cwnd,rtt"},
+    {TraceEvent::TCP_TIMEOUT, "TCP_TIMEOUT", "rto,ssthresh"},
+    {TraceEvent::TCP_STATE, "TCP_STATE", "state"},
+    {TraceEvent::TCP_RETRANSMIT, "TCP_RETRANSMIT", "seq"},
+    {TraceEvent::TCP_DELAYED_ACK, "TCP_DELAYED_ACK", ""},
+    {TraceEvent::ARQ_SEND, "ARQ_SEND", "seq,attempt,outstanding"},
+    {TraceEvent::ARQ_TIMEOUT, "ARQ_TIMEOUT", "seq,outstanding"},
+    {TraceEvent::ARQ_ACK, "ARQ_ACK", "base,ack"},
+    {TraceEvent::SW_BIT_ERRORS, "SW_BIT_ERRORS", "bytes,flipped"},
+    {TraceEvent::SW_UNDETECTED_ERROR, "SW_UNDETECTED_ERROR", "seq,flipped"},
+};
+static_assert(sizeof(EVENTS) / sizeof(EVENTS[0]) == static_cast<size_t>(TraceEvent::COUNT),
+              "every trace event needs a name");
+
+const char* const LEVEL_NAMES[] = {"OFF", "WARN", "INFO", "DEBUG"};
+
+// Records of one thread: it advances head, the drain thread advances tail
+struct Ring {
+    Ring(uint32_t capacity, uint32_t thread) : records(capacity), mask(capacity - 1), thread(thread) {}
+
+    std::vector<TraceRecord> records;
+    const uint64_t mask;
+    const uint32_t thread;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<bool> orphaned{false};     // The owning thread has exited
+};
+
+struct Session {
+    std::mutex control;                    // Serializes start and stop
+    std::mutex registry;                   // Guards rings and nextThread
+    std::vector<std::shared_ptr<Ring>> rings;
+    uint32_t nextThread = 0;
+    std::atomic<uint32_t> ringRecords{1 << 16};
+    std::atomic<int64_t> startNs{0};       // steady_clock time of startTrace
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::FILE* file = nullptr;
+    std::string path;
+    std::thread drainer;
+    uint64_t written = 0;
+    bool failed = false;
+
+    // A trace still running at exit is flushed, without the drop record
+    ~Session() {
+        if (!drainer.joinable()) return;
+        traceLevel.store(0, std::memory_order_release);
+        stopping.store(true, std::memory_order_release);
+        drainer.join();
+        std::fclose(file);
+    }
+};
+
+Session& session() {
+    static Session instance;
+    return instance;
+}
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The calling thread's ring, registered on first use; it outlives the thread
+// until the drain thread has emptied it. A thread whose ring has another size
+// than the current session asks for swaps it on its next event; the old ring
+// is drained and dropped like an exited thread's.
+struct ThreadRing {
+    std::shared_ptr<Ring> ring;
+    ~ThreadRing() {
+        if (ring) ring->orphaned.store(true, std::memory_order_release);
+    }
+};
+thread_local ThreadRing threadRing;
+
+Ring& localRing(Session& s) {
+    const uint32_t capacity = s.ringRecords.load(std::memory_order_relaxed);
+    if (!threadRing.ring || threadRing.ring->mask + 1 != capacity) {
+        std::lock_guard<std::mutex> lock(s.registry);
+        uint32_t thread = s.nextThread;
+        if (threadRing.ring) {
+            thread = threadRing.ring->thread;
+            threadRing.ring->orphaned.store(true, std::memory_order_release);
+        } else {
+            s.nextThread++;
+        }
+        threadRing.ring = std::make_shared<Ring>(capacity, thread);
+        s.rings.push_back(threadRing.ring);
+    }
+    return *threadRing.ring;
+}
+
+void writeBytes(Session& s, const void* data, size_t size, size_t count) {
+    if (count && std::fwrite(data, size, count, s.file) != count) s.failed = true;
+}
+
+void writeString(Session& s, const char* text) {
+    uint8_t length = static_cast<uint8_t>(std::strlen(text));
+    writeBytes(s, &length, 1, 1);
+    writeBytes(s, text, 1, length);
+}
+
+void writeHeader(Session& s) {
+    uint32_t recordSize = sizeof(TraceRecord);
+    uint32_t events = static_cast<uint32_t>(TraceEvent::COUNT);
+    uint64_t unixNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    writeBytes(s, MAGIC, 1, sizeof(MAGIC));
+    writeBytes(s, &recordSize, sizeof(recordSize), 1);
+    writeBytes(s, &events, sizeof(events), 1);
+    writeBytes(s, &unixNs, sizeof(unixNs), 1);
+    for (const EventInfo& info : EVENTS) {
+        uint16_t id = static_cast<uint16_t>(info.event);
+        writeBytes(s, &id, sizeof(id), 1);
+        writeString(s, info.name);
+        writeString(s, info.args);
+    }
+}
+
+// Copy everything published so far to the file, then forget the rings of
+// exited threads that are empty
+void drain(Session& s) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(s.registry);
+        rings = s.rings;
+    }
+    for (const auto& ring : rings) {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        while (tail < head) {
+            uint64_t slot = tail & ring->mask;
+            uint64_t count = std::min(head - tail, ring->mask + 1 - slot);
+            writeBytes(s, &ring->records[slot], sizeof(TraceRecord), count);
+            tail += count;
+            s.written += count;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    std::lock_guard<std::mutex> lock(s.registry);
+    s.rings.erase(std::remove_if(s.rings.begin(), s.rings.end(), [](const std::shared_ptr<Ring>& ring) {
+        return ring->orphaned.load(std::memory_order_acquire) &&
+               ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+    }), s.rings.end());
+}
+
+void drainLoop(Session& s) {
+    while (!s.stopping.load(std::memory_order_acquire)) {
+        drain(s);
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+    }
+    drain(s);
+}
+
+template <typename T>
+T readValue(std::FILE* file, const std::string& path) {
+    T value;
+    if (std::fread(&value, sizeof(T), 1, file) != 1) throw std::runtime_error("trace: truncated header in " + path);
+    return value;
+}
+
+std::string readString(std::FILE* file, const std::string& path) {
+    std::string text(readValue<uint8_t>(file, path), '\0');
+    if (!text.empty() && std::fread(&text[0], 1, text.size(), file) != text.size()) {
+        throw std::runtime_error("trace: truncated header in " + path);
+    }
+    return text;
+}
+
+} // namespace
+
+void traceEvent(TraceLevel level, TraceEvent event, int64_t a, uint32_t b, uint32_t c) {
+    Session& s = session();
+    Ring& ring = localRing(s);
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) > ring.mask) {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceRecord& record = ring.records[head & ring.mask];
+    record.timeNs = static_cast<uint64_t>(steadyNs() - s.startNs.load(std::memory_order_relaxed));
+    record.thread = ring.thread;
+    record.event = static_cast<uint16_t>(event);
+    record.level = static_cast<uint8_t>(level);
+    record.reserved = 0;
+    record.a = a;
+    record.b = b;
+    record.c = c;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void startTrace(const std::string& path, TraceLevel level, uint32_t ringRecords) {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.control);
+    if (s.drainer.joinable()) throw std::runtime_error("trace: already writing " + s.path);
+    s.file = std::fopen(path.c_str(), "wb");
+    if (!s.file) throw std::runtime_error("trace: cannot create " + path);
+    std::setvbuf(s.file, nullptr, _IOFBF, 1 << 20);
+    s.path = path;
+    s.failed = false;
+    s.written = 0;
+    s.dropped.store(0, std::memory_order_relaxed);
+    uint32_t capacity = 1;
+    while (capacity < std::max<uint32_t>(ringRecords, 2)) capacity <<= 1;
+    s.ringRecords.store(capacity, std::memory_order_relaxed);
+    writeHeader(s);
+    {
+        // Leftovers of an earlier session belong to no file
+        std::lock_guard<std::mutex> registry(s.registry);
+        for (const auto& ring : s.rings) ring->tail.store(ring->head.load(std::memory_order_acquire));
+    }
+    s.startNs.store(steadyNs(), std::memory_order_relaxed);
+    s.stopping.store(false, std::memory_order_release);
+    s.drainer = std::thread(drainLoop, std::ref(s));
+    traceLevel.store(static_cast<uint8_t>(level), std::memory_order_release);
+}
+
+TraceStats stopTrace() {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.control);
+    if (!s.drainer.joinable()) return {};
+    traceLevel.store(0, std::memory_order_release);
+    s.stopping.store(true, std::memory_order_release);
+    s.drainer.join();
+
+    TraceStats stats;
+    stats.dropped = s.dropped.load(std::memory_order_relaxed);
+    if (stats.dropped) {
+        TraceRecord record{static_cast<uint64_t>(steadyNs() - s.startNs.load(std::memory_order_relaxed)),
+                           SESSION_THREAD, static_cast<uint16_t>(TraceEvent::TRACE_DROPPED),
+                           static_cast<uint8_t>(TraceLevel::WARN), 0, static_cast<int64_t>(stats.dropped), 0, 0};
+        writeBytes(s, &record, sizeof(record), 1);
+        s.written++;
+    }
+    stats.records = s.written;
+    bool failed = s.failed;
+    if (std::fclose(s.file) != 0) failed = true;
+    s.file = nullptr;
+    if (failed) throw std::runtime_error("trace: write failed: " + s.path);
+    return stats;
+}
+
+bool traceRunning() {
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.control);
+    return s.drainer.joinable();
+}
+
+std::vector<std::string> decodeTrace(const std::string& path) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!file) throw std::runtime_error("trace: cannot open " + path);
+    char magic[sizeof(MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), file.get()) != sizeof(magic) ||
+        std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("trace: not a trace file: " + path);
+    }
+    if (readValue<uint32_t>(file.get(), path) != sizeof(TraceRecord)) {
+        throw std::runtime_error("trace: unsupported record size in " + path);
+    }
+    uint32_t events = readValue<uint32_t>(file.get(), path);
+    readValue<uint64_t>(file.get(), path);
+
+    // Names come from the file, so traces from older builds still decode
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> args;
+    for (uint32_t i = 0; i < events; i++) {
+        uint16_t id = readValue<uint16_t>(file.get(), path);
+        if (id >= names.size()) {
+            names.resize(id + 1);
+            args.resize(id + 1);
+        }
+        names[id] = readString(file.get(), path);
+        std::string list = readString(file.get(), path);
+        for (size_t begin = 0; begin < list.size();) {
+            size_t comma = std::min(list.find(',', begin), list.size());
+            args[id].push_back(list.substr(begin, comma - begin));
+            begin = comma + 1;
+        }
+    }
+
+    std::vector<std::string> lines;
+    TraceRecord record;
+    char buffer[256];
+    while (std::fread(&record, sizeof(record), 1, file.get()) == 1) {
+        const char* level = record.level < 4 ? LEVEL_NAMES[record.level] : "?";
+        std::snprintf(buffer, sizeof(buffer), "%.3f t%u %s ", record.timeNs / 1000.0, record.thread, level);
+        std::string line = buffer;
+        if (record.event < names.size() && !names[record.event].empty()) {
+            line += names[record.event];
+            const std::vector<std::string>& fields = args[record.event];
+            for (size_t i = 0; i < fields.size() && i < 3; i++) {
+                long long value = i == 0 ? record.a : i == 1 ? record.b : record.c;
+                std::snprintf(buffer, sizeof(buffer), " %s=%lld", fields[i].c_str(), value);
+                line += buffer;
+            }
+        } else {
+            line += "event" + std::to_string(record.event);
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
@@ -0,0 +1,465 @@
+import graph_module
+import random
+import threading
+import time
+
+print("\n=== Testing Topology Generators ===")
+
+config = graph_module.GeneratorConfig()
+config.seed = 42
+config.minWeight = 1
+config.maxWeight = 10
+
+# Same seed must give the same graph regardless of thread count
+g1 = graph_module.erdosRenyi(20000, 0.001, config)
+config.threads = 1
+g2 = graph_module.erdosRenyi(20000, 0.001, config)
+config.threads = 0
+print(f"G(n,p): {g1.numVertices()} vertices, {g1.numEdges()} edges")
+print(f"Deterministic across thread counts: {'✓' if g1.primMST() == g2.primMST() else '✗'}")
+
+start = time.time()
+ba = graph_module.barabasiAlbert(100000, 3, config)
+print(f"Barabasi-Albert: {ba.numEdges()} edges in {time.time() - start:.3f}s")
+
+wax = graph_module.waxman(2000, 0.4, 0.2, config)
+print(f"Waxman: {wax.numEdges()} edges")
+
+# k = 4 fat-tree: 4 core + 16 pod switches + 16 hosts, 48 links
+ft = graph_module.fatTree(4)
+print(f"Fat-tree (k=4): {ft.numVertices()} vertices, {ft.numEdges()} edges")
+print(f"Fat-tree size check: {'✓' if (ft.numVertices(), ft.numEdges()) == (36, 48) else '✗'}")
+
+t2 = graph_module.torus([8, 8])
+t3 = graph_module.torus([4, 4, 4])
+print(f"2D torus 8x8: {t2.numEdges()} edges (expected 128)")
+print(f"3D torus 4x4x4: {t3.numEdges()} edges (expected 192)")
+
+mst = t2.primMST()
+print(f"Torus MST has {len(mst)} edges (expected {t2.numVertices() - 1})")
+
+# Pending edges are merged by whichever thread first needs the adjacency;
+# mst() releases the GIL, so two threads must not merge at once
+rng = random.Random(7)
+shared = graph_module.Graph(20000)
+for _ in range(100000):
+    shared.addEdge(rng.randrange(20000), rng.randrange(20000), rng.randint(1, 100))
+trees = [None, None]
+def build_mst(slot):
+    trees[slot] = shared.mst()
+workers = [threading.Thread(target=build_mst, args=(slot,)) for slot in range(2)]
+for worker in workers:
+    worker.start()
+for worker in workers:
+    worker.join()
+same = trees[0].totalWeight == trees[1].totalWeight and trees[0].parents.tolist() == trees[1].parents.tolist()
+print(f"Concurrent first mst() calls agree: {'✓' if same else '✗'}")
+
+print("\n=== Testing Max-Flow / Min-Cut ===")
+
+# Two disjoint paths 0-1-3 and 0-2-3 with bottlenecks 3 and 4
+g = graph_module.Graph(4)
+g.addEdge(0, 1, 5)
+g.addEdge(1, 3, 3)
+g.addEdge(0, 2, 4)
+g.addEdge(2, 3, 6)
+result = graph_module.maxFlow(g, 0, 3)
+print(f"Max flow 0 -> 3: {result.flow} (expected 7)")
+print(f"Min cut edges: {result.cutEdges}")
+
+tree = graph_module.GomoryHuTree(g)
+pairs = [(0, 3), (1, 2), (2, 3)]
+print(f"Gomory-Hu min cuts: {tree.minCutBatch(pairs)}")
+print(f"Matches direct max flow: {'✓' if tree.minCutBatch(pairs) == graph_module.maxFlowBatch(g, pairs) else '✗'}")
+
+print("\n=== Testing Index/Weight Instantiations ===")
+
+# 32-bit ids with 16-bit weights for very large studies
+config = graph_module.GeneratorConfig()
+config.maxWeight = 1000
+compact = graph_module.Graph_u32_u16.erdosRenyi(5000, 0.002, config)
+print(f"{type(compact).__name__}: {compact.numEdges()} edges, MST edges {len(compact.primMST())}")
+heavy = graph_module.Graph_u32_u16(3)
+heavy.addEdge(0, 1, 10)
+heavy.addEdge(1, 2, 65535)
+print(f"{'✓' if all(parent >= 0 for parent, _ in heavy.primMST()) else '✗'} MST reaches a vertex whose only edge weighs 65535")
+
+# Float weights for latency metrics
+config.minWeight = 0.1
+config.maxWeight = 5.0
+latency = graph_module.Graph_u32_f32.waxman(2000, 0.4, 0.2, config)
+print(f"{type(latency).__name__}: {latency.numEdges()} edges")
+
+g64 = graph_module.Graph_u64_f64(3)
+g64.addEdge(0, 1, 1.5)
+g64.addEdge(1, 2, 0.25)
+print(f"Float max flow 0 -> 2: {graph_module.maxFlow(g64, 0, 2).flow} (expected 0.25)")
+
+print("\n=== Testing Binary Snapshots ===")
+
+import os
+import tempfile
+
+path = os.path.join(tempfile.mkdtemp(), "ba.csr")
+start = time.time()
+ba.saveSnapshot(path)
+print(f"Saved {ba.numEdges()} edges ({os.path.getsize(path)} bytes) in {time.time() - start:.3f}s")
+
+start = time.time()
+loaded = graph_module.loadSnapshot(path)
+print(f"Mapped in {time.time() - start:.4f}s as {type(loaded).__name__}, in place: {loaded.isMapped()}")
+print(f"Same MST after reload: {'✓' if loaded.primMST() == ba.primMST() else '✗'}")
+
+# The snapshot records index/weight types, so typed graphs come back as themselves
+latency.saveSnapshot(path)
+print(f"Typed reload: {type(graph_module.loadSnapshot(path, prefault=True)).__name__}")
+
+# Adding edges copies the mapped arrays into private memory first
+loaded = graph_module.loadSnapshot(path)
+loaded.addEdge(0, 1, 1.0)
+loaded.primMST()
+print(f"After addEdge: {loaded.numEdges()} edges, in place: {loaded.isMapped()}")
+
+# Corrupt snapshots are rejected before any algorithm indexes with them
+import struct
+
+ba.saveSnapshot(path)
+with open(path, "rb") as f:
+    original = f.read()
+vertices, arcs, offsets_pos, targets_pos = struct.unpack_from("<4Q", original, 24)
+
+def rejected(data):
+    with open(path, "wb") as f:
+        f.write(data)
+    try:
+        graph_module.loadSnapshot(path)
+    except RuntimeError:
+        return True
+    return False
+
+corrupt = bytearray(original)
+struct.pack_into("<Q", corrupt, offsets_pos + 8, arcs)
+falling = rejected(corrupt)
+stray_target = bytearray(original)
+struct.pack_into("<I", stray_target, targets_pos, vertices + 7)
+outside = rejected(stray_target)
+corrupt = bytearray(original)
+struct.pack_into("<Q", corrupt, 32, 1 << 62)
+overflow = rejected(corrupt)
+print(f"{'✓' if falling and outside and overflow else '✗'} Rejected falling offsets: {falling}, "
+      f"target out of range: {outside}, overflowing arc count: {overflow}")
+with open(path, "wb") as f:
+    f.write(stray_target)
+print(f"Trusted load skips the check: {'✓' if graph_module.loadSnapshot(path, verify=False).isMapped() else '✗'}")
+
+print("\n=== Testing Vertex Reordering ===")
+
+config = graph_module.GeneratorConfig()
+config.seed = 7
+config.maxWeight = 100
+wax = graph_module.waxman(5000, 0.4, 0.05, config)
+for order in [graph_module.VertexOrder.DEGREE, graph_module.VertexOrder.BFS, graph_module.VertexOrder.RCM]:
+    start = time.time()
+    reordered = wax.reordered(order)
+    elapsed = time.time() - start
+    print(f"{order.name}: bandwidth {wax.bandwidth()} -> {reordered.graph().bandwidth()} ({elapsed:.3f}s)")
+
+# Results come back in the original numbering
+reordered = wax.reordered(graph_module.VertexOrder.RCM)
+unreached = [parent == -1 for parent, _ in wax.primMST()]
+print(f"MST children match: {'✓' if [child for _, child in reordered.primMST()] == list(range(1, wax.numVertices())) else '✗'}")
+print(f"Same spanning component: {'✓' if [parent == -1 for parent, _ in reordered.primMST()] == unreached else '✗'}")
+direct = graph_module.maxFlow(wax, 0, 42)
+mapped = reordered.maxFlow(0, 42)
+print(f"Max flow 0 -> 42: {mapped.flow} (direct {direct.flow}), same cut: {'✓' if mapped.cutEdges == direct.cutEdges else '✗'}")
+
+print("\n=== Testing Contraction Hierarchy ===")
+
+import numpy as np
+
+config = graph_module.GeneratorConfig()
+config.seed = 11
+config.maxWeight = 100
+net = graph_module.waxman(5000, 0.4, 0.012, config)
+start = time.time()
+ch = graph_module.ContractionHierarchy(net)
+print(f"Preprocessed {net.numEdges()} edges in {time.time() - start:.3f}s, {ch.numShortcuts()} shortcuts")
+
+rng = np.random.default_rng(1)
+sources = rng.integers(0, net.numVertices(), 50000)
+targets = rng.integers(0, net.numVertices(), 50000)
+start = time.time()
+distances = ch.distanceBatch(sources, targets)
+elapsed = time.time() - start
+print(f"{len(sources)} queries in {elapsed:.3f}s ({elapsed / len(sources) * 1e6:.2f} us/query), "
+      f"{np.count_nonzero(distances < 0)} unreachable")
+
+# Hub labels answer the same queries by merging two sorted lists
+start = time.time()
+labelled = graph_module.ContractionHierarchy(net, labels=True)
+print(f"Labelled in {time.time() - start:.3f}s, {labelled.numLabelEntries() / net.numVertices():.1f} entries per vertex")
+start = time.time()
+from_labels = labelled.distanceBatch(sources, targets)
+elapsed = time.time() - start
+print(f"{len(sources)} label queries in {elapsed:.3f}s ({elapsed / len(sources) * 1e6:.2f} us/query), "
+      f"same distances: {'✓' if np.array_equal(from_labels, distances) else '✗'}")
+
+# Paths come back flattened: path i is vertices[offsets[i]:offsets[i + 1]]
+dist, offsets, vertices = ch.pathBatch(sources[:5], targets[:5])
+for i in range(5):
+    path = vertices[offsets[i]:offsets[i + 1]]
+    print(f"{sources[i]} -> {targets[i]}: distance {dist[i]}, {len(path)} vertices")
+
+# Small graph with a known answer: the direct 0-3 link is longer than 0-1-2-3
+g = graph_module.Graph(4)
+g.addEdge(0, 1, 1)
+g.addEdge(1, 2, 1)
+g.addEdge(2, 3, 1)
+g.addEdge(0, 3, 5)
+small = graph_module.ContractionHierarchy(g)
+print(f"Distance 0 -> 3: {small.distance(0, 3)} (expected 3), path {small.path(0, 3)}")
+print(f"With labels: {graph_module.ContractionHierarchy(g, labels=True).distance(0, 3)} (expected 3)")
+
+print("\n=== Testing Failure What-If Analysis ===")
+
+# Ring 0-1-2-3 with a heavy chord 0-2 and a pendant vertex 4 hanging off 3
+g = graph_module.Graph(5)
+g.addEdge(0, 1, 1)
+g.addEdge(1, 2, 1)
+g.addEdge(2, 3, 1)
+g.addEdge(3, 0, 1)
+g.addEdge(0, 2, 5)
+g.addEdge(3, 4, 2)
+analysis = graph_module.FailureAnalysis(g)
+links = analysis.linkFailures()
+print(f"MST weight {analysis.mstWeight()}, MST edges {analysis.mstEdges().nonzero()[0].tolist()}")
+print(f"MST delta per link: {links['mstDelta'].tolist()}")
+print(f"Replacement per link: {links['replacement'].tolist()}")
+print(f"Link 3-4 is a bridge: {'✓' if links['mstSplits'][5] == 1 and links['disconnectedPairs'][5] == 8 else '✗'}")
+print(f"Worst stretch when 0-1 fails: {links['maxStretch'][0]:.2f} (expected 3.00)")
+nodes = analysis.nodeFailures()
+print(f"Vertex 3 is a cut vertex: {'✓' if nodes['mstSplits'][3] == 1 else '✗'}")
+
+config = graph_module.GeneratorConfig()
+config.seed = 4
+config.maxWeight = 50
+net = graph_module.waxman(1000, 0.4, 0.04, config)
+start = time.time()
+analysis = graph_module.FailureAnalysis(net)
+links = analysis.linkFailures()
+print(f"{net.numEdges()} link failures in {time.time() - start:.3f}s: "
+      f"{int((links['mstSplits'] > 0).sum())} bridges, worst mean stretch {links['meanStretch'].max():.4f}")
+
+print("\n=== Testing Biconnectivity ===")
+
+# Two triangles sharing vertex 2, a bridge 4-5 and a doubled link 5-6
+g = graph_module.Graph(7)
+for u, v in [(0, 1), (1, 2), (2, 0), (2, 3), (3, 4), (4, 2), (4, 5), (5, 6), (5, 6)]:
+    g.addEdge(u, v, 1)
+sequential = graph_module.biconnectivity(g)
+parallel = graph_module.biconnectivity(g, parallel=True, threads=2)
+print(f"Bridges: {sequential['bridges'].nonzero()[0].tolist()} (expected [6])")
+print(f"Articulation points: {sequential['articulationPoints'].nonzero()[0].tolist()} (expected [2, 4, 5])")
+print(f"Components per edge: {sequential['components'].tolist()}")
+same = all((sequential[key] == parallel[key]).all() for key in ("bridges", "articulationPoints", "components"))
+print(f"Parallel variant agrees: {'✓' if same else '✗'}")
+
+net = graph_module.erdosRenyi(200000, 1.5e-5)
+for parallel in (False, True):
+    start = time.time()
+    result = graph_module.biconnectivity(net, parallel=parallel)
+    print(f"{'Tarjan-Vishkin' if parallel else 'Hopcroft-Tarjan'} on {net.numEdges()} edges: "
+          f"{time.time() - start:.3f}s, {int(result['bridges'].sum())} bridges, "
+          f"{int(result['articulationPoints'].sum())} articulation points, {result['numComponents']} components")
+
+print("\n=== Testing Edge Betweenness ===")
+
+# Path 0-1-2 plus a pendant 3 on vertex 1: link 0-1 carries pairs (0,1), (0,2), (0,3)
+g = graph_module.Graph(4)
+g.addEdge(0, 1, 1)
+g.addEdge(1, 2, 1)
+g.addEdge(1, 3, 1)
+result = graph_module.edgeBetweenness(g)
+print(f"Centrality: {result['centrality'].tolist()} (expected [3.0, 3.0, 3.0])")
+
+# Square with one diagonal: the two shortest 0-2 paths split the pair evenly
+g = graph_module.Graph(4)
+for u, v in [(0, 1), (1, 2), (2, 3), (3, 0), (1, 3)]:
+    g.addEdge(u, v, 1)
+print(f"Square with diagonal: {graph_module.edgeBetweenness(g)['centrality'].tolist()}")
+
+net = graph_module.barabasiAlbert(3000, 3)
+start = time.time()
+exact = graph_module.edgeBetweenness(net, weighted=False)
+exact_time = time.time() - start
+start = time.time()
+approx = graph_module.edgeBetweenness(net, samples=300, weighted=False)
+approx_time = time.time() - start
+error = abs(approx["centrality"] - exact["centrality"]).max()
+print(f"Exact on {net.numEdges()} edges: {exact_time:.3f}s; {approx['sources']} pivots: {approx_time:.3f}s")
+print(f"Max error {error:.0f} within bound {approx['errorBound']:.0f}: {'✓' if error <= approx['errorBound'] else '✗'}")
+top = exact["centrality"].argsort()[::-1][:5]
+print(f"Most critical links (exact): {top.tolist()}, sampled ranks them {approx['centrality'].argsort()[::-1][:5].tolist()}")
+
+print("\n=== Testing Steiner Trees ===")
+
+# Star through hub 4 is cheaper than the ring between terminals 0..3
+g = graph_module.Graph(5)
+for u in range(4):
+    g.addEdge(u, (u + 1) % 4, 3)
+    g.addEdge(u, 4, 2)
+builder = graph_module.SteinerTreeBuilder(g)
+tree = builder.build([0, 1, 2, 3])
+print(f"Terminals 0-3: weight {tree['weight']} (optimum 8, bound 16): {'✓' if 8 <= tree['weight'] <= 16 else '✗'}")
+tree = builder.build([0, 1])
+print(f"Terminals 0, 1: weight {tree['weight']} (expected 3), connected {tree['connected']}")
+
+config = graph_module.GeneratorConfig()
+config.seed = 5
+config.maxWeight = 20
+net = graph_module.waxman(5000, 0.4, 0.03, config)
+builder = graph_module.SteinerTreeBuilder(net)
+rng = np.random.default_rng(5)
+groups = [rng.choice(net.numVertices(), size=30, replace=False) for _ in range(100)]
+start = time.time()
+trees = builder.buildBatch(groups)
+print(f"{len(groups)} multicast groups of 30 in {time.time() - start:.3f}s, "
+      f"mean tree weight {np.mean([t['weight'] for t in trees]):.1f}, "
+      f"mean tree edges {np.mean([len(t['edges']) for t in trees]):.1f}")
+same = all(builder.build(groups[i])["edges"].tolist() == trees[i]["edges"].tolist() for i in range(5))
+print(f"Batch matches single builds: {'✓' if same else '✗'}")
+
+print("\n=== Testing ECMP and k-Shortest Paths ===")
+
+# Diamond 0-{1,2}-3 with equal costs plus a longer detour 0-4-3
+g = graph_module.Graph(5)
+for u, v, w in [(0, 1, 1), (1, 3, 1), (0, 2, 1), (2, 3, 1), (0, 4, 2), (4, 3, 2)]:
+    g.addEdge(u, v, w)
+ecmp = graph_module.ecmpNextHops(g, [3])
+offsets, hops = ecmp["offsets"], ecmp["nextHops"]
+print(f"Next hops from 0 towards 3: {sorted(hops[offsets[0]:offsets[1]].tolist())} (expected [1, 2])")
+pool = graph_module.kShortestPaths(g, [0], [3], 4)
+paths = [pool["vertices"][pool["pathOffsets"][i]:pool["pathOffsets"][i + 1]].tolist()
+         for i in range(pool["pairOffsets"][0], pool["pairOffsets"][1])]
+print(f"Paths 0 -> 3: {paths}, lengths {pool['lengths'].tolist()} (expected [2, 2, 4])")
+
+tree = graph_module.fatTree(8)
+n = tree.numVertices()
+rng = np.random.default_rng(8)
+sources = rng.integers(0, n, 1000)
+targets = rng.integers(0, n, 1000)
+start = time.time()
+pool = graph_module.kShortestPaths(tree, sources, targets, 8)
+counts = pool["pairOffsets"][1:] - pool["pairOffsets"][:-1]
+print(f"Yen k=8 on fat-tree(8), {len(sources)} pairs: {time.time() - start:.3f}s, "
+      f"{len(pool['lengths'])} paths, mean {counts.mean():.2f} per pair")
+start = time.time()
+ecmp = graph_module.ecmpNextHops(tree, np.arange(n))
+fanout = ecmp["offsets"][1:] - ecmp["offsets"][:-1]
+print(f"ECMP tables for all {n} destinations: {time.time() - start:.3f}s, max fan-out {fanout.max()}")
+
+print("\n=== Testing Semi-External MST ===")
+
+config = graph_module.GeneratorConfig()
+config.seed = 9
+config.maxWeight = 1000
+net = graph_module.erdosRenyi(100000, 2e-4, config)
+with tempfile.TemporaryDirectory() as directory:
+    edge_file = os.path.join(directory, "edges.bin")
+    tree_file = os.path.join(directory, "tree.bin")
+    net.writeEdgeFile(edge_file)
+    start = time.time()
+    # A 4 MB budget forces many sorted runs
+    stats = graph_module.Graph.externalMST(edge_file, net.numVertices(), tree_file, memoryBytes=4 << 20)
+    print(f"{stats['inputEdges']} edges in {stats['runs']} runs ({stats['runEdges']} kept after filtering), "
+          f"{time.time() - start:.3f}s")
+    tree = np.fromfile(tree_file, dtype=graph_module.Graph.edgeRecordDtype())
+    print(f"Tree: {len(tree)} edges, weight {stats['weight']}, {stats['components']} components")
+    reference = graph_module.FailureAnalysis(net).mstWeight()
+    print(f"Matches in-memory MST weight {reference}: {'✓' if reference == stats['weight'] == tree['weight'].sum() else '✗'}")
+    print(f"Temporary runs removed: {'✓' if sorted(os.listdir(directory)) == ['edges.bin', 'tree.bin'] else '✗'}")
+
+print("\n=== Testing Graph Partitioning ===")
+
+# Two 4-cliques joined by one link split along that link
+g = graph_module.Graph(8)
+for base in (0, 4):
+    for u in range(base, base + 4):
+        for v in range(u + 1, base + 4):
+            g.addEdge(u, v, 1)
+g.addEdge(3, 4, 7)
+result = graph_module.partition(g, 2, epsilon=0.0)
+print(f"Parts: {result['parts'].tolist()}, cut {result['cutEdges']} (expected 1), cut weight {result['cutWeight']}")
+
+torus = graph_module.torus([64, 64])
+for parts in (4, 16):
+    start = time.time()
+    result = graph_module.partition(torus, parts)
+    print(f"Torus 64x64 into {parts}: {time.time() - start:.3f}s, cut {result['cutEdges']}/{torus.numEdges()}, "
+          f"imbalance {result['imbalance']:.3f}, sizes {result['partSizes'].min()}-{result['partSizes'].max()}")
+net = graph_module.barabasiAlbert(20000, 3)
+result = graph_module.partition(net, 8)
+again = graph_module.partition(net, 8, threads=1)
+print(f"BA 20000 into 8: cut {result['cutEdges']}/{net.numEdges()}, imbalance {result['imbalance']:.3f}, "
+      f"same for any thread count: {'✓' if (result['parts'] == again['parts']).all() else '✗'}")
+
+print("\n=== Testing NumPy MST Results ===")
+
+g = graph_module.Graph(5)
+for u, v, w in [(0, 1, 2), (0, 3, 6), (1, 2, 3), (1, 3, 8), (1, 4, 5), (2, 4, 7), (3, 4, 9)]:
+    g.addEdge(u, v, w)
+tree = g.mst()
+print(f"Parents {tree.parents.tolist()}, children {tree.children.tolist()}, weights {tree.weights.tolist()}")
+print(f"Total weight {tree.totalWeight} (expected 16), read-only views: {'✓' if not tree.weights.flags.writeable else '✗'}")
+parents = g.mst(parentsOnly=True).parentOf
+print(f"Parent array: {[-1 if p == graph_module.Graph.NO_VERTEX else int(p) for p in parents]}")
+
+net = graph_module.erdosRenyi(200000, 2e-5)
+start = time.time()
+pairs = net.primMST()
+middle = time.time()
+tree = net.mst()
+end = time.time()
+parents = net.mst(parentsOnly=True)
+print(f"primMST list: {middle - start:.3f}s, mst arrays: {end - middle:.3f}s, parents only: {time.time() - end:.3f}s")
+same = [p for p in pairs if p[0] != -1] == list(zip(tree.parents.tolist(), tree.children.tolist()))
+print(f"Same tree as primMST: {'✓' if same else '✗'}, "
+      f"parent array agrees: {'✓' if (parents.parentOf[tree.children] == tree.parents).all() else '✗'}")
+
+print("\n=== Testing Spanning Tree Protocol ===")
+
+ring = graph_module.Graph(6)
+for i in range(6):
+    ring.addEdge(i, (i + 1) % 6, 1)
+for rapid in (False, True):
+    config = graph_module.StpConfig()
+    config.rapid = rapid
+    name = "RSTP" if rapid else "STP"
+    result = graph_module.spanningTreeProtocol(ring, config)
+    print(f"{name} ring of 6: converged in {result['convergenceTime']} ms, parents {result['parentOf'].tolist()}, "
+          f"blocked edge {np.flatnonzero(~result['active']).tolist()} (expected [3])")
+    result = graph_module.spanningTreeProtocol(ring, config, failures=[(60000, 0)])
+    print(f"{name} after failing edge 0 at 60 s: reconverged at {result['convergenceTime']} ms, "
+          f"active edges {result['active'].sum()}, loop free: {'✓' if result['loopFree'] else '✗'}")
+
+# A tree topology keeps every link; the result is the MST rooted at bridge 0
+config = graph_module.StpConfig()
+config.rapid = True
+tree = graph_module.Graph(2000)
+for v in range(1, 2000):
+    tree.addEdge(v, (v * 7919 + 13) % v, 1 + v % 5)
+result = graph_module.spanningTreeProtocol(tree, config)
+parents = [-1 if p == graph_module.Graph.NO_VERTEX else int(p) for p in tree.mst(parentsOnly=True).parentOf]
+print(f"Tree topology matches mst() parents: {'✓' if result['parentOf'].tolist() == parents else '✗'}")
+
+fabric = graph_module.barabasiAlbert(50000, 2)
+distances = graph_module.ecmpNextHops(fabric, [0])['distances'][0]
+for rapid in (False, True):
+    config = graph_module.StpConfig()
+    config.rapid = rapid
+    start = time.time()
+    result = graph_module.spanningTreeProtocol(fabric, config)
+    print(f"{'RSTP' if rapid else 'STP'} 50000 bridges: {time.time() - start:.3f}s, converged at "
+          f"{result['convergenceTime']} ms, {result['bpdus']} BPDUs, active {result['active'].sum()}/{fabric.numVertices() - 1}, "
+          f"loop free: {'✓' if result['loopFree'] else '✗'}, root costs are shortest paths: "
+          f"{'✓' if (result['rootCost'] == distances).all() else '✗'}")
@@ -47,4 +47,369 @@ for i in range(3):
     print(f"Transmission {i+1} Success: {success}")
     print(f"ACK: {ack}")
     print(f"Next Sequence Number: {nextSeq}")
-    time.sleep(0.5)  # Small delay between transmissions 
\ No newline at end of file
+    time.sleep(0.5)  # Small delay between transmissions 
+
+print("\n=== Testing Virtual-Time Stop-and-Wait ===")
+
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 5
+config.timeoutMs = 1000
+config.errorProbability = 0.2
+config.lossProbability = 0.2
+config.ackLossProbability = 0.3
+config.virtualTime = True
+config.propagationDelayMs = 10.0
+config.bandwidthBps = 1e6
+clock = stop_and_wait_module.SimClock()
+start = time.time()
+success, ack, nextSeq = stop_and_wait_module.sendPacket(data, 0, config, clock)
+print(f"Success: {success} after {clock.frames} frame(s), simulated latency {clock.nowMs:.3f} ms, "
+      f"wall time {(time.time() - start) * 1000:.3f} ms")
+
+transfers = 1000000
+start = time.time()
+stats = stop_and_wait_module.simulateTransfers(data, transfers, config)
+elapsed = time.time() - start
+print(f"{transfers} transfers in {elapsed:.3f}s ({transfers / elapsed:,.0f}/s): {stats['delivered']} delivered, "
+      f"{stats['failed']} failed, {stats['attempts']} frames, {stats['elapsedMs'] / 1000:.1f} simulated seconds")
+# Per attempt: success with probability p after one round trip, else the frame time plus the timeout
+frame_ms = (len(data) + 5) * 8 * 1000 / config.bandwidthBps
+round_trip = frame_ms + 2 * config.propagationDelayMs + 8 * 1000 / config.bandwidthBps
+p = (1 - config.lossProbability) * (1 - config.errorProbability) * (1 - config.ackLossProbability)
+expected_frames = sum((1 - p) ** k for k in range(config.maxRetries))
+print(f"Mean latency {stats['latencyMs'].mean():.2f} ms; "
+      f"frames per transfer {stats['attempts'] / transfers:.4f} (expected {expected_frames:.4f}), "
+      f"fastest {stats['latencyMs'].min():.3f} ms (one round trip {round_trip:.3f} ms)")
+
+print("\n=== Testing Binary Event Tracing ===")
+
+import os
+import tempfile
+from trace_reader import read_trace, format_record
+
+trace_path = os.path.join(tempfile.mkdtemp(), "stop_and_wait.trace")
+transfers = 200000
+start = time.time()
+stop_and_wait_module.simulateTransfers(data, transfers, config)
+untraced = time.time() - start
+
+stop_and_wait_module.startTrace(trace_path, stop_and_wait_module.TraceLevel.DEBUG)
+start = time.time()
+traced_stats = stop_and_wait_module.simulateTransfers(data, transfers, config)
+traced = time.time() - start
+trace_stats = stop_and_wait_module.stopTrace()
+print(f"{transfers} transfers: {untraced:.3f}s untraced, {traced:.3f}s at DEBUG; "
+      f"{trace_stats['records']} records written, {trace_stats['dropped']} dropped, "
+      f"{os.path.getsize(trace_path) / 1e6:.1f} MB")
+
+events, records = read_trace(trace_path)
+lines = stop_and_wait_module.decodeTrace(trace_path)
+matches = len(lines) == len(records) and all(
+    format_record(events, records[i]) == lines[i] for i in range(0, len(lines), max(1, len(lines) // 1000)))
+print(f"{'✓' if matches else '✗'} Python reader matches decodeTrace ({len(records)} records)")
+names = {name: event for event, (name, _) in events.items()}
+sends = int((records["event"] == names["SW_SEND"]).sum())
+ok = trace_stats['dropped'] > 0 or sends == traced_stats['attempts']
+print(f"{'✓' if ok else '✗'} {sends} SW_SEND records for {traced_stats['attempts']} frames sent")
+for line in lines[:5]:
+    print("  " + line)
+
+# A later session's ring size applies to threads that already traced
+stop_and_wait_module.startTrace(trace_path, stop_and_wait_module.TraceLevel.DEBUG, 16)
+stop_and_wait_module.simulateTransfers(data, 10000, config)
+small = stop_and_wait_module.stopTrace()
+stop_and_wait_module.startTrace(trace_path, stop_and_wait_module.TraceLevel.DEBUG, 1 << 22)
+stop_and_wait_module.simulateTransfers(data, 10000, config)
+large = stop_and_wait_module.stopTrace()
+print(f"{'✓' if small['dropped'] > 0 and large['dropped'] == 0 else '✗'} Ring resized between sessions: "
+      f"{small['dropped']} dropped with 16 records, {large['dropped']} with 4M")
+# Both protocol modules bind the tracer; they must load side by side, as in protocol_demo.py
+import tcp_tahoe_module
+both = tcp_tahoe_module.TraceLevel.INFO.value == stop_and_wait_module.TraceLevel.INFO.value
+print(f"{'✓' if both else '✗'} stop_and_wait_module and tcp_tahoe_module imported together")
+
+print("\n=== Testing Go-Back-N and Selective-Repeat ===")
+
+payload = list(range(100))
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 1000
+config.timeoutMs = 100
+config.errorProbability = 0.05
+config.lossProbability = 0.05
+config.ackLossProbability = 0.05
+config.propagationDelayMs = 10.0
+config.bandwidthBps = 1e6
+frames = 5000
+windows = [1, 2, 4, 8, 16, 32, 64]
+
+baseline = stop_and_wait_module.simulateTransfers(payload, frames, config, seed=3)
+gbn = stop_and_wait_module.sweepWindowSizes(payload, frames, config, stop_and_wait_module.ArqProtocol.GO_BACK_N, windows,
+                                            seed=3)
+sr = stop_and_wait_module.sweepWindowSizes(payload, frames, config,
+                                           stop_and_wait_module.ArqProtocol.SELECTIVE_REPEAT, windows, seed=3)
+print(f"Stop-and-Wait: utilization {baseline['utilization']:.3f}, goodput {baseline['goodputBps'] / 1e3:.1f} kbit/s")
+print("window  GBN util  GBN frames/pkt   SR util  SR frames/pkt")
+for i, w in enumerate(windows):
+    print(f"{w:6d}  {gbn['utilization'][i]:8.3f}  {gbn['transmissions'][i] / frames:14.3f}  "
+          f"{sr['utilization'][i]:8.3f}  {sr['transmissions'][i] / frames:13.3f}")
+ok = abs(gbn['utilization'][0] - baseline['utilization']) < 0.05 * baseline['utilization']
+print(f"{'✓' if ok else '✗'} A window of one behaves like Stop-and-Wait")
+print(f"{'✓' if sr['utilization'][-1] > 5 * baseline['utilization'] else '✗'} "
+      f"Selective-Repeat with {windows[-1]} frames in flight: {sr['utilization'][-1] / baseline['utilization']:.1f}x the utilization")
+try:
+    stop_and_wait_module.simulateWindow(payload, 10, config, stop_and_wait_module.WindowConfig(
+        stop_and_wait_module.ArqProtocol.SELECTIVE_REPEAT, 5, 3))
+    print("✗ Oversized Selective-Repeat window accepted")
+except ValueError as e:
+    print(f"✓ Oversized window rejected: {e}")
+
+print("\n=== Testing Seeded Network Conditions ===")
+
+from concurrent.futures import ThreadPoolExecutor
+
+first = stop_and_wait_module.simulateTransfers(payload, 20000, config, seed=42)
+again = stop_and_wait_module.simulateTransfers(payload, 20000, config, seed=42)
+other = stop_and_wait_module.simulateTransfers(payload, 20000, config, seed=42, stream=1)
+print(f"{'✓' if (first['latencyMs'] == again['latencyMs']).all() else '✗'} Same seed replays the run "
+      f"({first['attempts']} frames both times)")
+print(f"{'✓' if (first['latencyMs'] != other['latencyMs']).any() else '✗'} Another stream of the seed differs "
+      f"({other['attempts']} frames)")
+unseeded = [stop_and_wait_module.simulateTransfers(payload, 20000, config) for _ in range(2)]
+print(f"{'✓' if (unseeded[0]['latencyMs'] != unseeded[1]['latencyMs']).any() else '✗'} Calls without a seed "
+      f"draw a fresh one ({unseeded[0]['attempts']} and {unseeded[1]['attempts']} frames)")
+
+# Streams run concurrently (the GIL is released) and match their sequential runs
+streams = 64
+start = time.time()
+with ThreadPoolExecutor(8) as pool:
+    parallel = list(pool.map(lambda s: stop_and_wait_module.simulateTransfers(payload, 20000, config, 7, s), range(streams)))
+elapsed = time.time() - start
+sequential = [stop_and_wait_module.simulateTransfers(payload, 20000, config, 7, s) for s in (0, streams - 1)]
+same = all((a['latencyMs'] == b['latencyMs']).all() for a, b in zip(sequential, (parallel[0], parallel[-1])))
+print(f"{'✓' if same else '✗'} {streams} concurrent streams in {elapsed:.3f}s match sequential runs")
+
+window = stop_and_wait_module.WindowConfig(stop_and_wait_module.ArqProtocol.SELECTIVE_REPEAT, 16)
+runs = [stop_and_wait_module.simulateWindow(payload, 5000, config, window, seed=3) for _ in range(2)]
+print(f"{'✓' if runs[0] == runs[1] else '✗'} Seeded Selective-Repeat runs identical: {runs[0]['transmissions']} frames")
+
+clock_a = stop_and_wait_module.SimClock(99)
+clock_b = stop_and_wait_module.SimClock(99)
+config.virtualTime = True
+outcomes = [(stop_and_wait_module.sendPacket(payload, 0, config, clock_a)[0],
+             stop_and_wait_module.sendPacket(payload, 0, config, clock_b)[0]) for _ in range(100)]
+print(f"{'✓' if all(a == b for a, b in outcomes) and clock_a.nowMs == clock_b.nowMs else '✗'} "
+      f"Clocks with one seed agree on every sendPacket ({clock_a.frames} frames, {clock_a.nowMs:.1f} ms)")
+
+print("\n=== Testing Parameter Sweep ===")
+
+import numpy as np
+
+errors = [0.0, 0.05, 0.1, 0.2]
+losses = [0.0, 0.05, 0.1, 0.2]
+ack_losses = [0.0, 0.1, 0.3]
+timeouts = [25, 100, 500]
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 8
+config.propagationDelayMs = 10.0
+config.bandwidthBps = 1e6
+trials = 5000
+start = time.time()
+sweep = stop_and_wait_module.sweepProtocolConfigs(payload, config, errors, losses, ack_losses, timeouts, trials, seed=1)
+elapsed = time.time() - start
+cells = sweep['successRate'].size
+print(f"{cells} cells x {trials} trials in {elapsed:.3f}s ({cells * trials / elapsed:,.0f} transfers/s), "
+      f"shape {sweep['successRate'].shape}, attemptCounts {sweep['attemptCounts'].shape}")
+
+single = stop_and_wait_module.sweepProtocolConfigs(payload, config, errors, losses, ack_losses, timeouts, trials,
+                                                   seed=1, threads=1)
+same = all((sweep[k] == single[k]).all() for k in sweep)
+print(f"{'✓' if same else '✗'} Results independent of the thread count")
+unseeded = [stop_and_wait_module.sweepProtocolConfigs(payload, config, [0.1], [0.1], [0.1], [100], 1000)
+            for _ in range(2)]
+print(f"{'✓' if (unseeded[0]['meanAttempts'] != unseeded[1]['meanAttempts']).any() else '✗'} Sweeps without a "
+      f"seed draw a fresh one ({unseeded[0]['meanAttempts'][0, 0, 0, 0]:.4f} and "
+      f"{unseeded[1]['meanAttempts'][0, 0, 0, 0]:.4f} mean attempts)")
+
+# Success needs frame, CRC and ACK to survive in one of maxRetries attempts
+p = (1 - errors[2]) * (1 - losses[3]) * (1 - ack_losses[2])
+expected = 1 - (1 - p) ** config.maxRetries
+measured = sweep['successRate'][2, 3, 2, 1]
+print(f"{'✓' if abs(measured - expected) < 0.02 else '✗'} Success rate {measured:.4f} (expected {expected:.4f}), "
+      f"attempts mean {sweep['meanAttempts'][2, 3, 2, 1]:.2f} p50 {sweep['p50Attempts'][2, 3, 2, 1]} "
+      f"p99 {sweep['p99Attempts'][2, 3, 2, 1]}")
+print(f"{'✓' if (sweep['attemptCounts'].sum(axis=-1) == trials).all() else '✗'} Attempt histograms cover every trial")
+best = np.unravel_index(sweep['goodputBps'][2, 3, 2].argmax(), sweep['goodputBps'][2, 3, 2].shape)[0]
+print("Goodput by timeout at error 0.1, loss 0.2, ACK loss 0.3: " +
+      ", ".join(f"{t} ms -> {g / 1e3:.1f} kbit/s" for t, g in zip(timeouts, sweep['goodputBps'][2, 3, 2])) +
+      f" (best {timeouts[best]} ms)")
+
+print("\n=== Testing Pooled Packet Buffers ===")
+
+clock = stop_and_wait_module.SimClock(5)
+config.virtualTime = True
+for i in range(10000):
+    stop_and_wait_module.sendPacket(payload, i % 2, config, clock)
+pool = clock.pool
+print(f"{'✓' if pool.slabs == 1 and pool.available == 1 else '✗'} 10000 frames built in {pool.slabs} "
+      f"{pool.slabSize}-byte slab(s) with {pool.headroom} bytes of headroom")
+start = time.time()
+stats = stop_and_wait_module.simulateTransfers(payload, 1000000, config, seed=5)
+elapsed = time.time() - start
+print(f"1000000 pooled transfers in {elapsed:.3f}s ({1000000 / elapsed:,.0f}/s)")
+
+print("\n=== Testing Bit-Level Corruption ===")
+
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 10
+config.timeoutMs = 100
+config.lossProbability = 0.0
+config.ackLossProbability = 0.0
+config.propagationDelayMs = 10.0
+config.bandwidthBps = 1e6
+config.corruption = stop_and_wait_module.CorruptionModel.BIT_ERRORS
+config.bitErrorRate = 1e-3
+bits = (len(payload) + 5) * 8
+stats = stop_and_wait_module.simulateTransfers(payload, 200000, config, seed=11)
+expected = 1 - (1 - config.bitErrorRate) ** bits
+measured = stats['crcErrors'] / stats['attempts']
+print(f"{'✓' if abs(measured - expected) < 0.01 else '✗'} BER {config.bitErrorRate}: CRC rejected {measured:.4f} of "
+      f"{bits}-bit frames (expected {expected:.4f}), {stats['undetectedErrors']} undetected")
+
+config.corruption = stop_and_wait_module.CorruptionModel.BURST
+config.bitErrorRate = 1e-4
+config.burstLength = 32
+stats = stop_and_wait_module.simulateTransfers(payload, 200000, config, seed=11)
+print(f"{'✓' if stats['undetectedErrors'] == 0 else '✗'} {stats['crcErrors']} bursts of {config.burstLength} bits, "
+      f"all caught by CRC-32 ({stats['undetectedErrors']} undetected)")
+
+window = stop_and_wait_module.WindowConfig(stop_and_wait_module.ArqProtocol.SELECTIVE_REPEAT, 16)
+run = stop_and_wait_module.simulateWindow(payload, 50000, config, window, seed=11)
+print(f"Selective-Repeat over the burst channel: {run['crcErrors']} CRC errors, "
+      f"{run['retransmissions']} retransmissions, {run['undetectedErrors']} undetected")
+
+# Clean frames cost one draw: a nearly error-free channel runs as fast as the per-frame model
+config.corruption = stop_and_wait_module.CorruptionModel.BIT_ERRORS
+config.bitErrorRate = 1e-9
+start = time.time()
+stop_and_wait_module.simulateTransfers(payload, 500000, config, seed=11)
+bit_level = time.time() - start
+config.corruption = stop_and_wait_module.CorruptionModel.FRAME
+config.errorProbability = 0.0
+start = time.time()
+stop_and_wait_module.simulateTransfers(payload, 500000, config, seed=11)
+per_frame = time.time() - start
+print(f"500000 transfers: {bit_level:.3f}s at BER 1e-9, {per_frame:.3f}s with per-frame corruption")
+
+print("\n=== Testing Sender/Receiver over a Channel ===")
+
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 10
+config.timeoutMs = 100
+config.errorProbability = 0.0
+config.lossProbability = 0.0
+config.ackLossProbability = 0.0
+config.propagationDelayMs = 10.0
+config.bandwidthBps = 1e6
+link = stop_and_wait_module.simulateLink(payload, 20000, config, seed=13)
+a = link['propagationRatio']
+expected = 1 / (1 + 2 * a)
+print(f"{'✓' if abs(link['utilization'] - expected) < 0.005 else '✗'} a = {a:.3f}: utilization "
+      f"{link['utilization']:.4f} (1/(1+2a) = {expected:.4f}), {link['throughputBps'] / 1e3:.1f} kbit/s")
+
+config.errorProbability = 0.05
+config.lossProbability = 0.1
+config.ackLossProbability = 0.05
+link = stop_and_wait_module.simulateLink(payload, 20000, config, seed=13)
+same = link == stop_and_wait_module.simulateLink(payload, 20000, config, seed=13)
+print(f"{'✓' if link['delivered'] == 20000 and same else '✗'} Lossy link: {link['delivered']} delivered in "
+      f"{link['frames']} frames, {link['crcErrors']} CRC errors, {link['duplicates']} duplicates re-acknowledged, "
+      f"utilization {link['utilization']:.4f} (reproducible: {same})")
+unseeded = [stop_and_wait_module.simulateLink(payload, 2000, config) for _ in range(2)]
+print(f"{'✓' if unseeded[0] != unseeded[1] else '✗'} Links without a seed draw a fresh one "
+      f"({unseeded[0]['frames']} and {unseeded[1]['frames']} frames)")
+
+# Short frames on a fast link: the event loop, not the CRC, sets the pace
+config.errorProbability = 0.0
+config.lossProbability = 0.0
+config.ackLossProbability = 0.0
+config.propagationDelayMs = 0.001
+config.bandwidthBps = 1e9
+start = time.time()
+link = stop_and_wait_module.simulateLink([1] * 16, 2000000, config, seed=13)
+elapsed = time.time() - start
+print(f"2000000 frames in {elapsed:.3f}s ({link['frames'] / elapsed:,.0f} frames/s, "
+      f"{link['events'] / elapsed:,.0f} events/s)")
+
+print("\n=== Testing Coroutine Flows ===")
+
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 10
+config.timeoutMs = 100
+config.errorProbability = 0.0
+config.lossProbability = 0.0
+config.ackLossProbability = 0.0
+config.propagationDelayMs = 10.0
+config.bandwidthBps = 1e6
+flow = stop_and_wait_module.simulateFlows(payload, 1, 1000, config, seed=17)
+link = stop_and_wait_module.simulateLink(payload, 1000, config, seed=17)
+print(f"{'✓' if abs(flow['elapsedMs'] - link['elapsedMs']) < 1e-6 else '✗'} One coroutine flow matches the "
+      f"callback endpoints: {flow['elapsedMs']:.1f} ms vs {link['elapsedMs']:.1f} ms for 1000 messages")
+
+config.errorProbability = 0.05
+config.lossProbability = 0.1
+config.ackLossProbability = 0.05
+start = time.time()
+flows = stop_and_wait_module.simulateFlows(payload, 100000, 5, config, seed=17)
+elapsed = time.time() - start
+print(f"{'✓' if flows['delivered'] == 500000 and flows['failed'] == 0 else '✗'} 100000 concurrent flows on one "
+      f"thread in {elapsed:.3f}s: {flows['delivered']} delivered in {flows['frames']} frames, "
+      f"{flows['events'] / elapsed:,.0f} events/s, mean completion {flows['meanCompletionMs']:.1f} ms")
+same = stop_and_wait_module.simulateFlows(payload, 1000, 5, config, seed=17) == \
+    stop_and_wait_module.simulateFlows(payload, 1000, 5, config, seed=17)
+print(f"{'✓' if same else '✗'} Flows are reproducible from a seed")
+unseeded = [stop_and_wait_module.simulateFlows(payload, 1000, 5, config) for _ in range(2)]
+print(f"{'✓' if unseeded[0] != unseeded[1] else '✗'} Flows without a seed draw a fresh one "
+      f"({unseeded[0]['frames']} and {unseeded[1]['frames']} frames)")
+
+print("\n=== Testing GIL Release and asyncio Variants ===")
+
+import asyncio
+import threading
+
+config = stop_and_wait_module.ProtocolConfig()
+config.maxRetries = 5
+config.timeoutMs = 300
+config.errorProbability = 0.1
+config.lossProbability = 0.1
+config.ackLossProbability = 0.5
+
+# The main thread keeps running while the blocking sends wait for ACKs; every
+# ACK is lost so each send blocks for its full timeouts
+blocking = stop_and_wait_module.ProtocolConfig()
+blocking.maxRetries = 2
+blocking.timeoutMs = 50
+blocking.ackLossProbability = 1.0
+results = []
+threads = [threading.Thread(target=lambda: results.append(stop_and_wait_module.sendPacket(payload, 0, blocking)))
+           for _ in range(4)]
+for thread in threads:
+    thread.start()
+ticks = 0
+while any(thread.is_alive() for thread in threads):
+    ticks += 1
+    time.sleep(0.001)
+print(f"{'✓' if len(results) == 4 and ticks > 1 else '✗'} 4 blocking sendPacket threads, main thread ran "
+      f"{ticks} times meanwhile")
+
+async def send_many(count):
+    start = time.time()
+    outcomes = await asyncio.gather(*[stop_and_wait_module.sendPacketAsync(payload, i % 2, config)
+                                      for i in range(count)])
+    return outcomes, time.time() - start
+
+outcomes, elapsed = asyncio.run(send_many(1000))
+delivered = sum(success for success, _, _ in outcomes)
+consistent = all(next_seq == (i + 1) % 2 and ack == [i % 2]
+                 for i, (success, ack, next_seq) in enumerate(outcomes) if success)
+print(f"{'✓' if consistent and delivered > 900 else '✗'} 1000 concurrent sendPacketAsync transfers in "
+      f"{elapsed:.3f}s on the native loop: {delivered} delivered")
@@ -0,0 +1,64 @@
+"""Reader for the binary trace files written by startTrace/stopTrace.
+
+The header carries the event names and argument names, so this needs no copy
+of the C++ event list. Records load straight into a numpy structured array.
+
+Usage: python trace_reader.py trace.bin
+"""
+import struct
+import sys
+
+import numpy as np
+
+MAGIC = b"NSTRACE1"
+LEVEL_NAMES = ["OFF", "WARN", "INFO", "DEBUG"]
+RECORD_DTYPE = np.dtype([
+    ("timeNs", "<u8"),
+    ("thread", "<u4"),
+    ("event", "<u2"),
+    ("level", "u1"),
+    ("reserved", "u1"),
+    ("a", "<i8"),
+    ("b", "<u4"),
+    ("c", "<u4"),
+])
+
+
+def read_trace(path):
+    """Return (events, records): events maps id -> (name, [arg names]),
+    records is a structured array with RECORD_DTYPE."""
+    with open(path, "rb") as f:
+        if f.read(len(MAGIC)) != MAGIC:
+            raise ValueError(f"not a trace file: {path}")
+        record_size, count, _start_unix_ns = struct.unpack("<IIQ", f.read(16))
+        if record_size != RECORD_DTYPE.itemsize:
+            raise ValueError(f"unsupported record size {record_size} in {path}")
+        events = {}
+        for _ in range(count):
+            (event_id,) = struct.unpack("<H", f.read(2))
+            name = f.read(f.read(1)[0]).decode()
+            args = f.read(f.read(1)[0]).decode()
+            events[event_id] = (name, args.split(",") if args else [])
+        offset = f.tell()
+    records = np.fromfile(path, dtype=RECORD_DTYPE, offset=offset)
+    return events, records
+
+
+def format_record(events, record):
+    """One record in the same text form as decodeTrace."""
+    level = int(record["level"])
+    line = f"{record['timeNs'] / 1000:.3f} t{record['thread']} {LEVEL_NAMES[level] if level < 4 else '?'} "
+    event = int(record["event"])
+    if event not in events:
+        return line + f"event{event}"
+    name, args = events[event]
+    values = (int(record["a"]), int(record["b"]), int(record["c"]))
+    return line + name + "".join(f" {arg}={value}" for arg, value in zip(args, values))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("usage: trace_reader.py TRACE_FILE")
+    events, records = read_trace(sys.argv[1])
+    for record in records:
+        print(format_record(events, record))